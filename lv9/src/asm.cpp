@@ -10,68 +10,55 @@ Context context;
 RegisterManager register_manager;
 
 /**
- * @brief 翻译 Koopa IR 程序
+ * @brief 翻译程序
  * @param[in] program 程序
  */
-void visit(const koopa_raw_program_t& program) {
+void visit(const Program& program) {
 	// 翻译所有全局变量
-	visit(program.values);
+	for (auto global : program.globals) {
+		visit(global);
+	}
 	// 翻译所有函数
-	visit(program.funcs);
-};
-
-/**
- * @brief 翻译 Koopa IR 切片
- * @param[in] slice 切片
- */
-void visit(const koopa_raw_slice_t& slice) {
-	// 切片 slice 是存储一系列元素的数组
-	// 遍历数组，对每个元素进行翻译
-	for (size_t i = 0; i < slice.len; ++i) {
-		auto ptr = slice.buffer[i];
-		// 根据 slice 的 kind 决定将 ptr 视作何种元素
-		// RSIK: Raw Slice Kind, 区分 slice 的类型
-		switch (slice.kind) {
-		case KOOPA_RSIK_FUNCTION:
-			// 访问函数
-			// 先强制转换为 koopa_raw_function_t 类型
-			visit(reinterpret_cast<koopa_raw_function_t>(ptr));
-			break;
-		case KOOPA_RSIK_BASIC_BLOCK:
-			// 访问基本块
-			// 先强制转换为 koopa_raw_basic_block_t 类型
-			visit(reinterpret_cast<koopa_raw_basic_block_t>(ptr));
-			break;
-		case KOOPA_RSIK_VALUE:
-			// 访问指令
-			// 先强制转换为 koopa_raw_value_t 类型
-			visit(reinterpret_cast<koopa_raw_value_t>(ptr));
-			break;
-		default:
-			// 我们暂时不会遇到其他内容, 于是不对其做任何处理
-			cout << slice.kind << endl;
-			assert(false);
-		}
+	for (auto func : program.funcs) {
+		visit(func);
 	}
 };
 
 /**
- * @brief 翻译 Koopa IR 函数
+ * @brief 翻译函数
  * @param[in] func 函数
  */
-void visit(const koopa_raw_function_t& func) {
+void visit(const Function* func) {
 	// 忽略库函数
-	if (func->bbs.len == 0) {
+	if (func->is_decl()) {
 		return;
 	}
-	// 访问所有基本块，bbs: basic block slice
-	riscv_ofs << endl;
-	riscv._text();
-	// 忽略函数名前的@，@main -> main
-	riscv._globl(func->name + 1);
-	riscv._label(func->name + 1);
+	// 每个函数单独计时
+	TimeRegion region(func->name + 1, "function");
+	// 开始生成函数的机器指令，函数头在输出时生成
+	riscv.begin_function(func);
+	// 分配寄存器，-O2 时使用图着色，-perf 模式下使用线性扫描
+	// 否则只把跨调用的值放到被调用者保存寄存器中，免得每次调用前后都要存取栈，其余的值仍然存放在栈上
+	if (opt_level >= 2) {
+		register_allocator.graph_coloring(func);
+	}
+	else if (mode == "-perf") {
+		register_allocator.linear_scan(func);
+	}
+	else {
+		register_allocator.linear_scan(func, true);
+	}
+	// 为未分配到寄存器的值分配栈槽，活跃区间不重叠的值共享栈槽
+	register_allocator.assign_stack_slots(func);
+	// 按值的编号开辟寄存器映射，清空临时寄存器的缓存
+	register_manager.begin_function(func);
+	// 按访问频率排布栈槽与 alloc 分配的空间
+	FrameLayout layout;
+	layout.compute(func, register_allocator);
 	// 计算栈帧大小，此时还只是指令计数，没乘 4
 	int cnt = 0;
+	// 不共享栈槽时需要的栈槽个数，用于统计栈帧缩减了多少
+	int unshared = 0;
 	// 计算函数体内 call 指令最多用到的参数个数
 	int stack_args = 0;
 	// 计算函数体内 alloc 指令们总共分配的空间大小
@@ -79,680 +66,971 @@ void visit(const koopa_raw_function_t& func) {
 	// 判断函数体内是否有 call 指令，若有，则需要多分配一条 store 指令来压栈代表返回值的 ra 寄存器
 	bool has_call = false;
 	// 遍历所有基本块
-	for (size_t i = 0; i < func->bbs.len; ++i) {
-		auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
-		// 计算基本块内指令数
-		cnt += bb->insts.len;
+	for (auto bb : func->bbs) {
 		// 遍历基本块内所有指令
-		for (size_t j = 0; j < bb->insts.len; ++j) {
-			auto inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
-			// 如果是 unit 类型，则不占用栈帧空间
-			if (inst->ty->tag == KOOPA_RTT_UNIT) {
-				cnt -= 1;
+		for (auto inst = bb->head; inst; inst = inst->next) {
+			// 如果不是 unit 类型，且结果没有分配到寄存器、也不在使用处重新计算，则占用一个栈槽
+			if (inst->ty->tag != Type::Tag::UNIT && register_allocator.get(inst) == NO_REG && !register_allocator.is_remat(inst)) {
+				unshared += 1;
 			}
 			// 如果是 call 指令，需要额外计算变量表所需空间
-			if (inst->kind.tag == KOOPA_RVT_CALL) {
-				int args = inst->kind.data.call.args.len;
+			if (inst->kind == Value::Kind::CALL) {
+				int args = inst->num_operands;
 				// 取最大值，不同 call 之间可以覆写
 				stack_args = max(stack_args, args - 8);
 				has_call = true;
 			}
 			// 如果是 alloc 指令，检查是否为数组
-			if (inst->kind.tag == KOOPA_RVT_ALLOC) {
-				int size = get_alloc_size(inst->ty->data.pointer.base);
+			if (inst->kind == Value::Kind::ALLOC) {
+				int size = inst->ty->base->size();
 				alloc_size += size;
 			}
 		}
 	}
-	// 如果函数体内有 call 指令，需要多分配一条 store 指令来存储 ra 寄存器
-	cnt += has_call;
+	// 溢出的前 8 个参数与基本块参数也占用栈槽
+	for (auto param : func->params) {
+		if (register_allocator.slot[param->id] != -1) {
+			unshared += 1;
+		}
+	}
+	for (auto bb : func->bbs) {
+		for (auto param : bb->params) {
+			if (register_allocator.slot[param->id] != -1) {
+				unshared += 1;
+			}
+		}
+	}
+	// 需要保存的寄存器：有 call 指令时的 ra，以及用到的被调用者保存寄存器
+	vector<Reg> saved_regs;
+	if (has_call) {
+		saved_regs.push_back(RA);
+	}
+	for (auto reg : register_allocator.callee_saved) {
+		saved_regs.push_back(reg);
+	}
+	cnt += saved_regs.size();
 	// 额外分配压栈参数空间
 	cnt += stack_args;
 	// 乘 4，转换为实际字节数
 	cnt *= 4;
-	// 加上 alloc 指令分配的空间
-	cnt += alloc_size;
+	// 加上栈槽与 alloc 指令分配的空间
+	cnt += layout.size;
 	// 对齐到 16 的倍数
 	cnt = (cnt + 15) / 16 * 16;
 	// ---[DEBUG]---
 	// 检查是否超过 imm12 的限制
 	// cnt = 8000;
 	// ---[DEBUG END]---
-	context_manager.create_context(func->name + 1, cnt);
-	riscv._addi("sp", "sp", -cnt);
+	if (stats) {
+		int before = ((unshared + (int)saved_regs.size() + stack_args) * 4 + alloc_size + 15) / 16 * 16;
+		cerr << "frame: " << func->name + 1 << " " << before << " -> " << cnt << " bytes" << endl;
+	}
+	context_manager.create_context(func->name + 1, cnt, func->value_count);
 	context = context_manager.get_context(func->name + 1);
 	// ---[DEBUG]---
 	// 检查是否超过 imm12 的限制
 	// context.stack_used = 2040;
 	// ---[DEBUG END]---
-	// 如果函数体内有 call 指令，则需要存储代表返回后下一条指令地址的 ra 寄存器到栈底
-	if (has_call) {
-		riscv._sw("ra", "sp", context.stack_size - 4);
-		context.save_ra = true;
+	// ra 与被调用者保存寄存器保存在栈底，ra 代表返回后下一条指令地址
+	for (int i = 0; i < (int)saved_regs.size(); i++) {
+		context.saved_regs.push_back({ saved_regs[i], context.stack_size - 4 * (i + 1) });
 	}
-	// 在栈顶先分配掉压栈参数所需空间
+	// 收缩包装，确定序言所在的基本块，以及哪些基本块在序言之后执行
+	layout.shrink_wrap(func, register_allocator);
+	context.frame_block = layout.frame_block;
+	context.framed = layout.framed;
+	// 在栈顶先分配掉压栈参数所需空间，其上为栈槽与 alloc 指令分配的空间
 	context.stack_used = stack_args * 4;
+	for (int i = 0; i < func->value_count; i++) {
+		if (layout.offset[i] != -1) {
+			context.stack_map[i] = context.stack_used + layout.offset[i];
+		}
+	}
+	context.stack_used += layout.size;
 	// 访问所有基本块
-	visit(func->bbs);
+	for (auto bb : func->bbs) {
+		visit(bb);
+	}
+	// 输出函数的全部机器指令
+	riscv.end_function();
 };
 
 /**
- * @brief 翻译 Koopa IR 基本块
- * @param[in] bb 基本块
+ * @brief 生成序言，分配栈帧并保存 ra 与用到的被调用者保存寄存器
  */
-void visit(const koopa_raw_basic_block_t& bb) {
-	// 输出基本块标号
-	riscv_ofs << bb->name + 1 << ":" << endl;
-	// 访问所有指令，insts: instruction slice
-	visit(bb->insts);
-};
+void prologue() {
+	// 叶函数的值都在寄存器中、也没有局部数组时不需要栈帧，省去序言与尾声中对 sp 的调整
+	if (context.stack_size != 0) {
+		riscv._addi(SP, SP, -context.stack_size);
+	}
+	for (auto& saved : context.saved_regs) {
+		riscv._sw(saved.first, SP, saved.second);
+	}
+}
 
 /**
- * @brief 计算 alloc 指令分配的空间大小，对于数组可以递归处理
- * @param[in] ty 类型
- * @return 分配的空间大小
+ * @brief 生成尾声，恢复序言中保存的寄存器并释放栈帧
  */
-int get_alloc_size(const koopa_raw_type_t ty) {
-	switch (ty->tag) {
-		// 空类型不占用空间
-	case KOOPA_RTT_UNIT:
-		return 0;
-		// 函数类型不占用空间
-	case KOOPA_RTT_FUNCTION:
-		return 0;
-		// 32 位整数占用 4 字节
-	case KOOPA_RTT_INT32:
-		return 4;
-		// 指针类型占用 4 字节
-	case KOOPA_RTT_POINTER:
-		return 4;
-		// 数组类型占用空间为数组长度乘以数组元素类型占用空间
-	case KOOPA_RTT_ARRAY:
-		return ty->data.array.len * get_alloc_size(ty->data.array.base);
-	default:
-		printf("Invalid type: %s\n", koopaRawTypeTagToString(ty->tag).c_str());
-		assert(false);
+void epilogue() {
+	// 需要恢复序言中保存的寄存器，包括代表返回地址（返回后下一条指令地址）的寄存器 ra
+	for (auto& saved : context.saved_regs) {
+		riscv._lw(saved.first, SP, saved.second);
+	}
+	// 恢复栈指针，没有栈帧时不需要恢复
+	if (context.stack_size != 0) {
+		riscv._addi(SP, SP, context.stack_size);
 	}
 }
 
 /**
- * @brief 翻译 alloc 指令，设置已用帧栈，记录数组的栈偏移
+ * @brief 在入口处把参数从 a0 ~ a7 与调用者的栈帧挪到分配的位置
+ * @param[in] func 函数
+ * @note 先把溢出的前 8 个参数存入栈槽，再处理寄存器之间的传递，最后加载分配到寄存器的第 8 个以后的参数，避免覆盖还没读取的 a0 ~ a7
+ */
+void receive_params(const Function* func) {
+	vector<pair<Reg, Reg>> moves;
+	for (auto param : func->params) {
+		auto index = static_cast<const Argument*>(param)->index;
+		if (!param->uses || index >= 8) {
+			continue;
+		}
+		auto reg = register_allocator.get(param);
+		if (reg == NO_REG) {
+			riscv._sw(a_reg(index), SP, context.stack_map[param->id]);
+		}
+		else {
+			moves.push_back({ reg, a_reg(index) });
+		}
+	}
+	parallel_move(moves);
+	for (auto param : func->params) {
+		auto index = static_cast<const Argument*>(param)->index;
+		auto reg = register_allocator.get(param);
+		if (param->uses && index >= 8 && reg != NO_REG) {
+			riscv._lw(reg, SP, context.stack_size + 4 * (index - 8));
+		}
+	}
+}
+
+/**
+ * @brief 在 jump 之前把实参传给目标基本块的参数
+ * @param[in] jump jump 指令
+ * @note - 参数与实参都可能在寄存器或栈槽中，位置用寄存器编号表示，栈槽用 VREG_BASE 加偏移量表示；
+ *         按并行赋值处理，先完成目标位置不再被读取的传递，剩下的都成环时把一个目标位置的旧值挪到临时寄存器
+ * @note - 缓存在临时寄存器中的实参直接从临时寄存器读取，多于一个时先全部写回栈上，留出中转用的临时寄存器
+ */
+void pass_block_args(const Jump* jump) {
+	struct Move {
+		int dst;
+		int src;
+		const Value* value;
+	};
+	// 值所在的位置，非零整数与可重算的值没有位置，传递时再生成
+	auto location = [&](const Value* value) -> int {
+		auto reg = register_allocator.get(value);
+		if (reg != NO_REG) {
+			return reg;
+		}
+		if (value->kind == Value::Kind::INTEGER) {
+			return static_cast<const Integer*>(value)->value == 0 ? X0 : NO_REG;
+		}
+		if (register_allocator.is_remat(value)) {
+			return NO_REG;
+		}
+		if (value->kind == Value::Kind::FUNC_ARG && static_cast<const Argument*>(value)->index >= 8) {
+			return VREG_BASE + context.stack_size + 4 * (static_cast<const Argument*>(value)->index - 8);
+		}
+		reg = register_manager.find_cached(value);
+		return reg != NO_REG ? reg : VREG_BASE + context.stack_map[value->id];
+	};
+	int cached = 0;
+	for (int i = 0; i < jump->num_operands; i++) {
+		auto arg = jump->arg(i);
+		if (Liveness::is_candidate(arg) && register_allocator.get(arg) == NO_REG && register_manager.find_cached(arg) != NO_REG) {
+			cached++;
+		}
+	}
+	if (cached > 1) {
+		register_manager.flush();
+		register_manager.reset();
+	}
+	vector<Move> moves;
+	for (int i = 0; i < jump->num_operands; i++) {
+		// 参数的旧值可能还缓存在临时寄存器中，目标位置只能是分配的寄存器或栈槽
+		auto param = jump->target->params[i];
+		auto reg = register_allocator.get(param);
+		auto arg = jump->arg(i);
+		Move move{ reg != NO_REG ? reg : VREG_BASE + context.stack_map[param->id], location(arg), arg };
+		if (move.dst != move.src) {
+			moves.push_back(move);
+		}
+	}
+	// 中转与打破环各用一个临时寄存器，需要时才占用
+	Reg transfer = NO_REG;
+	Reg cycle = NO_REG;
+	auto emit = [&](int dst, int src, const Value* value) {
+		if (src == NO_REG || (src >= VREG_BASE && dst >= VREG_BASE)) {
+			if (transfer == NO_REG) {
+				transfer = register_manager.new_reg();
+			}
+		}
+		Reg reg = dst < VREG_BASE ? dst : transfer;
+		if (src == NO_REG) {
+			register_manager.load_operand(reg, value);
+		}
+		else if (src >= VREG_BASE) {
+			riscv._lw(reg, SP, src - VREG_BASE);
+		}
+		else {
+			reg = src;
+		}
+		if (dst >= VREG_BASE) {
+			riscv._sw(reg, SP, dst - VREG_BASE);
+		}
+		else if (dst != reg) {
+			riscv._mv(dst, reg);
+		}
+	};
+	while (!moves.empty()) {
+		// 找一个目标位置不再被读取的传递
+		int ready = -1;
+		for (int i = 0; i < (int)moves.size() && ready == -1; i++) {
+			ready = i;
+			for (int j = 0; j < (int)moves.size(); j++) {
+				if (j != i && moves[j].src == moves[i].dst) {
+					ready = -1;
+					break;
+				}
+			}
+		}
+		if (ready == -1) {
+			auto target = moves.front().dst;
+			if (cycle == NO_REG) {
+				cycle = register_manager.new_reg();
+			}
+			emit(cycle, target, nullptr);
+			for (auto& move : moves) {
+				if (move.src == target) {
+					move.src = cycle;
+				}
+			}
+			continue;
+		}
+		emit(moves[ready].dst, moves[ready].src, moves[ready].value);
+		moves.erase(moves.begin() + ready);
+	}
+}
+
+/**
+ * @brief 翻译基本块
+ * @param[in] bb 基本块
+ */
+void visit(const BasicBlock* bb) {
+	// 输出基本块标号
+	riscv._label(riscv.block_label(bb));
+	// 临时寄存器缓存的值不跨基本块
+	register_manager.begin_block();
+	// 在需要栈帧的基本块的公共支配结点处生成序言
+	if (bb->id == context.frame_block) {
+		prologue();
+	}
+	// 在入口处把参数挪到分配的位置，需要用到栈帧时序言一定也在入口处
+	if (bb == bb->parent->bbs.front()) {
+		receive_params(bb->parent);
+	}
+	// 访问所有指令
+	for (auto inst = bb->head; inst; inst = inst->next) {
+		visit(inst);
+	}
+};
+
+/**
+ * @brief 翻译 alloc 指令，栈偏移已经在排布栈帧时确定
  * @param[in] value 指令
  */
-void alloc(const koopa_raw_value_t& value) {
+void alloc(const Alloc* value) {
 	// ---[DEBUG]---
 	// 输出 alloc 指令的名称和类型
 	// printf("alloc name: %s\n", value->name);
-	// printf("alloc rtt: %s\n", koopaRawTypeTagToString(value->ty->tag).c_str());
+	// printf("alloc rtt: %s\n", typeTagToString(value->ty->tag).c_str());
 	// ---[DEBUG END]---
 	// 计算 alloc 指令分配的空间大小
-	int size = get_alloc_size(value->ty->data.pointer.base);
+	int size = value->ty->base->size();
 	// ---[DEBUG]---
 	// 输出 alloc 指令分配的空间大小
 	// printf("alloc size: %d\n", size);
 	// ---[DEBUG END]---
-	// 记录栈偏移
-	context.stack_map[value] = context.stack_used;
-	// 更新已用栈帧
-	context.stack_used += size;
+	// 栈偏移必须已经在排布栈帧时记录
+	assert(context.stack_map[value->id] + size <= context.stack_size);
 }
 
 /**
- * @brief 翻译值，一般就是翻译指令
- * @param[in] value 值
+ * @brief 翻译指令
+ * @param[in] inst 指令
  */
-void visit(const koopa_raw_value_t& value) {
-	// 根据值（指令）的类型判断后续需要如何访问
-	const auto& kind = value->kind;
+void visit(const Instruction* inst) {
 	// 重置寄存器计数器，避免寄存器超限
 	register_manager.reset();
 	// ---[DEBUG]---
 	// 输出指令类型  
-	// printf("visit: %s\n", koopaRawValueTagToString(kind.tag).c_str());
+	// printf("visit: %s\n", valueKindToString(inst->kind).c_str());
 	// riscv_ofs << "---" << endl;
-	// riscv_ofs << "[" << koopaRawValueTagToString(kind.tag).c_str() << "]" << endl;
+	// riscv_ofs << "[" << valueKindToString(inst->kind).c_str() << "]" << endl;
 	// ---[DEBUG END]---
-	// RVT: Raw Value Tag, 区分指令类型
-	// 说明：什么时候传 value，什么时候不传
-	// 1. 如果需要存储单条值（指令）的计算结果，则需要传入 value
-	// 2. 否则不传入 value
-	switch (kind.tag) {
-	case KOOPA_RVT_RETURN:
+	// 根据指令的种类转换为具体的指令类型再访问
+	// 需要存储单条指令计算结果的指令，会以自身的编号在 stack_map 中记录结果位置
+	switch (inst->kind) {
+	case Value::Kind::RETURN:
 		// 访问 return 指令
-		visit(kind.data.ret);
+		visit(static_cast<const Return*>(inst));
 		break;
-	case KOOPA_RVT_BINARY:
+	case Value::Kind::BINARY:
 		// 处理 binary 指令（双目运算）
-		// 由于要在栈上存储单条指令的计算结果，所以将指令本身 value 也传入
-		// 用于后续在 symbol_map 中存储结果
-		visit(kind.data.binary, value);
+		visit(static_cast<const Binary*>(inst));
 		break;
-	case KOOPA_RVT_ALLOC:
+	case Value::Kind::ALLOC:
 		// 处理 alloc 指令（局部分配）
-		alloc(value);
-		break;
-	case KOOPA_RVT_GLOBAL_ALLOC:
-		// 处理 global_alloc 指令（全局分配）
-		visit(kind.data.global_alloc, value);
-		break;
-	case KOOPA_RVT_AGGREGATE:
-		// 处理 aggregate 指令（初始化列表）
-		visit(kind.data.aggregate);
+		alloc(static_cast<const Alloc*>(inst));
 		break;
-	case KOOPA_RVT_GET_PTR:
+	case Value::Kind::GET_PTR:
 		// 处理 get_ptr 指令（指针计算）
-		visit(kind.data.get_ptr, value);
+		visit(static_cast<const GetPtr*>(inst));
 		break;
-	case KOOPA_RVT_GET_ELEM_PTR:
+	case Value::Kind::GET_ELEM_PTR:
 		// 处理 get_elem_ptr 指令（元素指针计算）
-		visit(kind.data.get_elem_ptr, value);
+		visit(static_cast<const GetElemPtr*>(inst));
 		break;
-	case KOOPA_RVT_STORE:
+	case Value::Kind::STORE:
 		// 处理 store 指令（存储）
-		visit(kind.data.store);
+		visit(static_cast<const Store*>(inst));
 		break;
-	case KOOPA_RVT_LOAD:
+	case Value::Kind::LOAD:
 		// 处理 load 指令（加载）
-		// 由于需要在栈上记录加载结果所在的位置，所以需要传入 value
-		visit(kind.data.load, value);
+		visit(static_cast<const Load*>(inst));
 		break;
-	case KOOPA_RVT_BRANCH:
+	case Value::Kind::BRANCH:
 		// 处理 branch 指令（条件分支）
-		visit(kind.data.branch);
+		visit(static_cast<const Branch*>(inst));
 		break;
-	case KOOPA_RVT_JUMP:
+	case Value::Kind::JUMP:
 		// 处理 jump 指令（无条件跳转）
-		visit(kind.data.jump);
+		visit(static_cast<const Jump*>(inst));
 		break;
-	case KOOPA_RVT_CALL:
+	case Value::Kind::CALL:
 		// 处理 call 指令（函数调用）
-		// 由于需要判断是否需要存储返回值，所以需要传入 value
-		visit(kind.data.call, value);
+		visit(static_cast<const Call*>(inst));
 		break;
 	default:
 		// 其他类型暂时遇不到
-		printf("Invalid instruction: %s\n", koopaRawValueTagToString(kind.tag).c_str());
+		printf("Invalid instruction: %s\n", valueKindToString(inst->kind).c_str());
 		assert(false);
 	}
+	// 更新操作数的剩余使用次数
+	register_manager.release(inst);
 };
 
 /**
  * @brief 处理全局分配指令
- * @param[in] global_alloc 全局分配指令的数据
- * @param[in] value 全局分配指令自身，全局存储时用作键
+ * @param[in] global_alloc 全局分配指令，全局存储时以其编号用作键
  */
-void visit(const koopa_raw_global_alloc_t& global_alloc, const koopa_raw_value_t& value) {
-	riscv_ofs << endl;
+void visit(const GlobalAlloc* global_alloc) {
+	riscv_ofs << '\n';
 	// 在全局变量表中创建全局变量
-	context_manager.create_global(value);
+	context_manager.create_global(global_alloc);
 	// 获取全局变量名
-	auto global_name = context_manager.get_global(value);
+	auto global_name = context_manager.get_global(global_alloc);
 	// 输出 .data .global label 等格式信息
 	riscv._data();
 	riscv._globl(global_name);
 	riscv._label(global_name);
 	// 判断初始化值的类型
-	auto init = global_alloc.init;
-	switch (init->kind.tag) {
-	case KOOPA_RVT_INTEGER:
+	auto init = global_alloc->init;
+	switch (init->kind) {
+	case Value::Kind::INTEGER:
 		// 输出整数
-		riscv._word(init->kind.data.integer.value);
+		riscv._word(static_cast<const Integer*>(init)->value);
 		break;
-	case KOOPA_RVT_ZERO_INIT:
+	case Value::Kind::ZERO_INIT:
 		// 输出 0 初始化，指定个数
-		riscv._zero(get_alloc_size(init->ty));
+		riscv._zero(init->ty->size());
 		break;
-	case KOOPA_RVT_AGGREGATE:
+	case Value::Kind::AGGREGATE:
 		// 递归处理初始化列表
-		visit(init->kind.data.aggregate);
+		visit(static_cast<const Aggregate*>(init));
 		break;
 	default:
 		// 其他类型暂时遇不到
-		printf("Invalid global_alloc init: %s\n", koopaRawValueTagToString(init->kind.tag).c_str());
+		printf("Invalid global_alloc init: %s\n", valueKindToString(init->kind).c_str());
 		assert(false);
 	}
 }
 
 /**
  * @brief 处理初始化列表
- * @param[in] aggregate 初始化列表的数据
+ * @param[in] aggregate 初始化列表
  */
-void visit(const koopa_raw_aggregate_t& aggregate) {
+void visit(const Aggregate* aggregate) {
 	// 遍历初始化列表
-	for (int i = 0; i < aggregate.elems.len; i++) {
+	for (int i = 0; i < aggregate->len; i++) {
 		// 获取列表中的当前元素
-		auto elem = reinterpret_cast<koopa_raw_value_t>(aggregate.elems.buffer[i]);
+		auto elem = aggregate->elems[i];
 		// 处理整数
-		if (elem->kind.tag == KOOPA_RVT_INTEGER) {
-			riscv._word(elem->kind.data.integer.value);
+		if (elem->kind == Value::Kind::INTEGER) {
+			riscv._word(static_cast<const Integer*>(elem)->value);
 		}
 		// 递归处理下一级初始化列表 aggregate
 		else {
-			visit(elem);
+			visit(static_cast<const Aggregate*>(elem));
 		}
 	}
 }
 
 /**
- * @brief 处理 getptr 指针计算指令，会存放加载出来的指针到栈上
- * @param[in] get_ptr getptr 指针计算指令的数据
- * @param[in] value getptr 指针计算指令自身，存储时用作键
+ * @brief 计算 getptr / getelemptr 偏移后的指针，即 base + index * size
+ * @param[in] value getptr / getelemptr 指令
+ * @param[in] base 基准值所在的寄存器
+ * @param[in] index 下标
+ * @param[in] size 步长
+ * @return 结果所在的寄存器
  */
-void visit(const koopa_raw_get_ptr_t& get_ptr, const koopa_raw_value_t& value) {
+Reg offset_pointer(const Value* value, Reg base, const Value* index, int size) {
+	// 判断 index 是否为非零，如果是零的话就不用加上偏移了
+	bool is_non_zero = register_manager.get_operand_reg(index);
+	if (!is_non_zero) {
+		return base;
+	}
+	// 获取 index 所在的寄存器
+	auto bias = register_manager.reg_map[index->id];
+	// 获取存放结果的寄存器
+	auto ptr = register_manager.result_reg(value);
+	// 获取存放偏移量的临时寄存器
+	auto step = register_manager.tmp_reg();
+	// 步长为常数，按代价选择移位加减序列或乘法指令，基准、下标与结果可能已经占用了临时寄存器，只在 step 中计算
+	riscv._muli(step, bias, size, false);
+	// 计算最终地址
+	riscv._add(ptr, base, step);
+	return ptr;
+}
+
+/**
+ * @brief 处理 getptr 指针计算指令，计算出的指针存到分配的寄存器或栈上
+ * @param[in] get_ptr getptr 指针计算指令，存储时以其编号用作键
+ */
+void visit(const GetPtr* get_ptr) {
+	// 溢出后在使用处重新计算，此处不生成代码
+	if (register_allocator.is_remat(get_ptr)) {
+		return;
+	}
 	// ---[DEBUG]---
 	// 输出 getptr 指令的 src 和 index 的类型
-	// printf("get_ptr src: %s\n", koopaRawValueTagToString(get_ptr.src->kind.tag).c_str());
-	// printf("get_ptr index: %s\n", koopaRawValueTagToString(get_ptr.index->kind.tag).c_str());
-	// riscv_ofs << "get_ptr src: " << koopaRawValueTagToString(get_ptr.src->kind.tag).c_str() << endl;
-	// riscv_ofs << "get_ptr index: " << koopaRawValueTagToString(get_ptr.index->kind.tag).c_str() << endl;
+	// printf("get_ptr src: %s\n", valueKindToString(get_ptr->src()->kind).c_str());
+	// printf("get_ptr index: %s\n", valueKindToString(get_ptr->index()->kind).c_str());
 	// ---[DEBUG END]---
-	// 获取栈偏移
-	auto offset = context.stack_map[get_ptr.src];
-	// 准备存放基准值的寄存器
-	auto base = register_manager.new_reg();
+	auto src = get_ptr->src();
+	auto index = get_ptr->index();
+	// 准备基准值所在的寄存器
+	Reg base;
 	// 判断是基准值的来源
-	switch (get_ptr.src->kind.tag) {
-		// 函数参数传进来的，已经被提前 load 后压栈到 offset(sp)
-	case KOOPA_RVT_LOAD:
-		riscv._lw(base, "sp", offset);
+	switch (src->kind) {
+		// 函数参数传进来的指针
+	case Value::Kind::FUNC_ARG:
+		register_manager.get_operand_reg(src);
+		base = register_manager.reg_map[src->id];
 		break;
 		// 全局变量的指针，使用 la 指令获取地址
-	case KOOPA_RVT_GLOBAL_ALLOC:
-		riscv._la(base, context_manager.get_global(get_ptr.src));
+	case Value::Kind::GLOBAL_ALLOC:
+		base = register_manager.new_reg();
+		riscv._la(base, context_manager.get_global(src));
 		break;
 	default:
 		assert(false);
 	}
-	// 判断 index 是否为非零，如果是零的话就不用加上偏移了
-	bool is_non_zero = register_manager.get_operand_reg(get_ptr.index);
-	// 非零，则需要加上偏移
-	if (is_non_zero) {
-		// 获取 index 所在的寄存器
-		auto bias = register_manager.reg_map[get_ptr.index];
-		// 获取存放步长的临时寄存器
-		auto step = register_manager.tmp_reg();
-		// 要获取步长，就需要获取数组元素的类型
-		auto size = get_alloc_size(get_ptr.src->ty->data.pointer.base);
-		// 判断步长是否为 2 的幂次
-		auto power = is_power_of_two(size);
-		// 如果是 2 的幂次，则可以进行强度削减，转换为左移指令
-		if (power != -1) {
-			riscv._li(step, power);
-			riscv._sll(bias, bias, step);
-		}
-		// 否则，还是使用乘法指令
-		else {
-			riscv._li(step, size);
-			riscv._mul(bias, bias, step);
-		}
-		// 计算最终地址
-		riscv._add(base, base, bias);
-	}
-	// 将加载出来的指针存到栈上
-	riscv._sw(base, "sp", context.stack_used);
-	// 必须先存再压栈，不然 context.stack_used 会变
-	context.push(value, context.stack_used);
+	// 计算偏移后的指针
+	auto ptr = offset_pointer(get_ptr, base, index, src->ty->base->size());
+	// 将计算出的指针保存下来
+	register_manager.save_result(get_ptr, ptr);
 }
 
 /**
- * @brief 处理 getelemptr 指针指令，会存放加载出来的指针到栈上
- * @param[in] get_elem_ptr getelemptr 指针计算指令的数据
- * @param[in] value getelemptr 指针计算指令自身，存储时用作键
+ * @brief 处理 getelemptr 指针指令，计算出的指针存到分配的寄存器或栈上
+ * @param[in] get_elem_ptr getelemptr 指针计算指令，存储时以其编号用作键
  */
-void visit(const koopa_raw_get_elem_ptr_t& get_elem_ptr, const koopa_raw_value_t& value) {
+void visit(const GetElemPtr* get_elem_ptr) {
+	// 溢出后在使用处重新计算，此处不生成代码
+	if (register_allocator.is_remat(get_elem_ptr)) {
+		return;
+	}
 	// ---[DEBUG]---
 	// 输出 getelemptr 指令的 src 和 index 的类型
-	// printf("get_elem_ptr src: %s\n", koopaRawValueTagToString(get_elem_ptr.src->kind.tag).c_str());
-	// printf("get_elem_ptr index: %s\n", koopaRawValueTagToString(get_elem_ptr.index->kind.tag).c_str());
-	// riscv_ofs << "get_elem_ptr src: " << koopaRawValueTagToString(get_elem_ptr.src->kind.tag).c_str() << endl;
-	// riscv_ofs << "get_elem_ptr index: " << koopaRawValueTagToString(get_elem_ptr.index->kind.tag).c_str() << endl;
+	// printf("get_elem_ptr src: %s\n", valueKindToString(get_elem_ptr->src()->kind).c_str());
+	// printf("get_elem_ptr index: %s\n", valueKindToString(get_elem_ptr->index()->kind).c_str());
 	// ---[DEBUG END]---
-	// 获取栈偏移
-	auto offset = context.stack_map[get_elem_ptr.src];
-	// 准备存放基准值的寄存器
-	auto base = register_manager.new_reg();
+	auto src = get_elem_ptr->src();
+	auto index = get_elem_ptr->index();
+	// 准备基准值所在的寄存器
+	Reg base;
 	// 判断是基准值的来源
-	switch (get_elem_ptr.src->kind.tag) {
+	switch (src->kind) {
 		// 全局变量的指针，使用 la 指令获取地址
-	case KOOPA_RVT_GLOBAL_ALLOC:
-		riscv._la(base, context_manager.get_global(get_elem_ptr.src));
+	case Value::Kind::GLOBAL_ALLOC:
+		base = register_manager.new_reg();
+		riscv._la(base, context_manager.get_global(src));
 		break;
-		// 一个之前的 getelemptr 指令，结果已经存到栈上
-	case KOOPA_RVT_GET_ELEM_PTR:
-		riscv._lw(base, "sp", offset);
-		break;
-		// 一个之前的 getptr 指令，结果已经存到栈上
-	case KOOPA_RVT_GET_PTR:
-		riscv._lw(base, "sp", offset);
+		// 一个之前的 getelemptr 或 getptr 指令计算出的指针
+	case Value::Kind::GET_ELEM_PTR:
+	case Value::Kind::GET_PTR:
+		register_manager.get_operand_reg(src);
+		base = register_manager.reg_map[src->id];
 		break;
 		// 一个之前的 alloc 指令，起始位置已经在 alloc 函数中存到了栈上
-	case KOOPA_RVT_ALLOC:
-		riscv._addi(base, "sp", offset);
+	case Value::Kind::ALLOC:
+		base = register_manager.new_reg();
+		riscv._addi(base, SP, context.stack_map[src->id]);
 		break;
 	default:
 		assert(false);
 	}
-	// 判断 index 是否为非零，如果是零的话就不用加上偏移了
-	bool is_non_zero = register_manager.get_operand_reg(get_elem_ptr.index);
-	// 非零，则需要加上偏移
-	if (is_non_zero) {
-		// 获取 index 所在的寄存器
-		auto bias = register_manager.reg_map[get_elem_ptr.index];
-		// 获取存放步长的临时寄存器
-		auto step = register_manager.tmp_reg();
-		// 要获取步长，就需要获取数组元素的类型
-		auto size = get_alloc_size(get_elem_ptr.src->ty->data.pointer.base->data.array.base);
-		// 判断步长是否为 2 的幂次
-		auto power = is_power_of_two(size);
-		// 如果是 2 的幂次，则可以进行强度削减，转换为左移指令
-		if (power != -1) {
-			riscv._li(step, power);
-			riscv._sll(bias, bias, step);
-		}
-		// 否则，还是使用乘法指令
-		else {
-			riscv._li(step, size);
-			riscv._mul(bias, bias, step);
+	// 计算偏移后的指针
+	auto ptr = offset_pointer(get_elem_ptr, base, index, src->ty->base->base->size());
+	// 将计算出的指针保存下来
+	register_manager.save_result(get_elem_ptr, ptr);
+}
+
+/**
+ * @brief 同时在寄存器之间传递多个值，按依赖顺序生成 mv 指令，成环时借助临时寄存器
+ * @param[in] moves 目标寄存器与来源寄存器，目标寄存器互不相同
+ */
+void parallel_move(const vector<pair<Reg, Reg>>& moves) {
+	// 记录每个目标寄存器的来源
+	vector<Reg> source(VREG_BASE, NO_REG);
+	// 每个寄存器还要被多少个尚未完成的传递读取
+	vector<int> readers(VREG_BASE, 0);
+	vector<Reg> pending;
+	for (auto& move : moves) {
+		if (move.first != move.second) {
+			source[move.first] = move.second;
+			readers[move.second]++;
+			pending.push_back(move.first);
 		}
-		// 计算最终地址
-		riscv._add(base, base, bias);
 	}
-	// 将加载出来的指针存到栈上
-	riscv._sw(base, "sp", context.stack_used);
-	// 必须先存再压栈，不然 context.stack_used 会变
-	context.push(value, context.stack_used);
+	while (!pending.empty()) {
+		// 找一个不再被读取的目标寄存器，可以直接覆写
+		auto it = find_if(pending.begin(), pending.end(), [&](Reg target) { return readers[target] == 0; });
+		if (it == pending.end()) {
+			// 剩下的传递成环，先把一个目标寄存器的旧值移到临时寄存器，打破环
+			auto target = pending.front();
+			auto tmp = register_manager.tmp_reg();
+			riscv._mv(tmp, target);
+			for (auto other : pending) {
+				if (source[other] == target) {
+					source[other] = tmp;
+				}
+			}
+			readers[tmp] = readers[target];
+			readers[target] = 0;
+			continue;
+		}
+		auto target = *it;
+		riscv._mv(target, source[target]);
+		readers[source[target]]--;
+		pending.erase(it);
+	}
 }
 
 /**
- * @brief 处理 call 指令，如果有返回值，会将返回值存到栈上
- * @param[in] call call 指令的数据
- * @param[in] value call 指令自身，存储时用作键
+ * @brief 处理 call 指令，如果有返回值，会将返回值存到分配的寄存器或栈上
+ * @param[in] call call 指令，存储时以其编号用作键
+ * @note 前 8 个参数先处理寄存器之间的传递，最后再加载立即数与栈上的值
  */
-void visit(const koopa_raw_call_t& call, const koopa_raw_value_t& value) {
+void visit(const Call* call) {
 	// 获取参数个数
-	int args = call.args.len;
-	// 处理前 8 个参数
-	for (int i = 0; i < min(args, 8); i++) {
-		// 取出正在处理的参数的 value
-		auto arg = reinterpret_cast<koopa_raw_value_t>(call.args.buffer[i]);
-		// 获取存放到的目的地寄存器
-		// 这 8 个参数一定是存到 a0 - a7 寄存器中的
-		auto target = "a" + to_string(i);
-		// 若为整数，则直接将整数存到目标寄存器中
-		if (arg->kind.tag == KOOPA_RVT_INTEGER) {
-			riscv._li(target, arg->kind.data.integer.value);
-		}
-		// 若为指针参数，则从栈上获取
-		else if (arg->kind.tag == KOOPA_RVT_GET_ELEM_PTR) {
-			riscv._lw(target, "sp", context.stack_map[arg]);
-		}
-		// 若为之前某操作的中间结果，实际上也必然为整数，但是需要先加载
-		else {
-			riscv._lw(target, "sp", context.stack_map[arg]);
-		}
-	}
-	// 处理超过 8 个参数的情况，此时需要将参数存到栈上
+	int args = call->num_operands;
+	// 处理超过 8 个参数的情况，此时需要将参数存到栈上，要在 a0 - a7 被覆写之前处理
 	for (int i = 8; i < args; i++) {
 		// 取出正在处理的参数的 value
-		auto arg = reinterpret_cast<koopa_raw_value_t>(call.args.buffer[i]);
+		auto arg = call->arg(i);
 		// 计算栈偏移
 		int target = (i - 8) * 4;
-		// 若为整数，则直接将整数存到目标寄存器中
-		if (arg->kind.tag == KOOPA_RVT_INTEGER) {
-			// 准备一个临时寄存器
-			auto tmp = register_manager.new_reg();
-			// 将整数存到临时寄存器中
-			riscv._li(tmp, arg->kind.data.integer.value);
-			// 将临时寄存器里的整数存到栈上目标地址
-			riscv._sw(tmp, "sp", target);
-		}
-		// 若为指针参数，则从栈上获取
-		else if (arg->kind.tag == KOOPA_RVT_GET_ELEM_PTR) {
-			// 准备一个临时寄存器
-			auto tmp = register_manager.new_reg();
-			// 从栈上获取指针到临时寄存器中
-			riscv._lw(tmp, "sp", context.stack_map[arg]);
-			// 将临时寄存器里的指针存到栈上目标地址
-			riscv._sw(tmp, "sp", target);
-		}
-		// 为之前某操作的中间结果，实际上也必然为整数，但是需要先加载
-		else {
-			// 准备一个临时寄存器
-			auto tmp = register_manager.new_reg();
-			// 从栈上获取整数到临时寄存器中
-			riscv._lw(tmp, "sp", context.stack_map[arg]);
-			// 将临时寄存器里的整数存到栈上目标地址
-			riscv._sw(tmp, "sp", target);
-		}
+		// 将参数准备到寄存器中，再存到栈上目标地址
+		register_manager.get_operand_reg(arg);
+		riscv._sw(register_manager.reg_map[arg->id], SP, target);
 		// 释放临时寄存器，必须在循环间释放
 		register_manager.reset();
 	}
+	// 处理前 8 个参数，这 8 个参数一定是存到 a0 - a7 寄存器中的
+	// 先处理已经在寄存器中的参数
+	vector<pair<Reg, Reg>> moves;
+	for (int i = 0; i < min(args, 8); i++) {
+		auto reg = register_allocator.get(call->arg(i));
+		if (reg != NO_REG) {
+			moves.push_back({ a_reg(i), reg });
+		}
+	}
+	parallel_move(moves);
+	// 再处理立即数与栈上的参数
+	for (int i = 0; i < min(args, 8); i++) {
+		auto arg = call->arg(i);
+		if (register_allocator.get(arg) == NO_REG) {
+			register_manager.load_operand(a_reg(i), arg);
+		}
+	}
+	// 调用会覆盖临时寄存器，先写回缓存的值，参数都已就位，临时寄存器也不再被占用
+	register_manager.flush();
+	register_manager.reset();
 	// 调用函数
-	riscv._call(call.callee->name + 1);
+	riscv._call(call->callee->name + 1);
 	// 判断是否需要存储返回值
-	if (value->ty->tag != KOOPA_RTT_UNIT) {
-		// 将返回值存到栈上
-		context.push(value, context.stack_used);
-		// 注意要先压栈才能通过 stack_map 访问到
-		riscv._sw("a0", "sp", context.stack_map[value]);
+	if (call->ty->tag != Type::Tag::UNIT) {
+		// 将 a0 中的返回值保存下来
+		register_manager.save_result(call, A0);
 	}
 }
 
 /**
  * @brief 处理 branch 指令，根据条件跳转到不同的分支
- * @param[in] branch branch 指令的数据
+ * @param[in] branch branch 指令
  */
-void visit(const koopa_raw_branch_t& branch) {
-	// 准备条件表达式
-	register_manager.get_operand_reg(branch.cond);
-	// 获取条件表达式所在的寄存器
-	auto cond = register_manager.reg_map[branch.cond];
-	// 根据条件跳转到不同的基本块，输出的是基本块的 label
-	riscv._bnez(cond, branch.true_bb->name + 1);
-	riscv._beqz(cond, branch.false_bb->name + 1);
+void visit(const Branch* branch) {
+	auto& reg_map = register_manager.reg_map;
+	auto true_label = riscv.block_label(branch->true_bb);
+	// 条件是只被 br 使用的比较时，直接生成比较分支指令，不计算比较结果
+	if (Liveness::is_branch_compare(branch->cond())) {
+		auto compare = static_cast<const Binary*>(branch->cond());
+		register_manager.get_operand_reg(compare->lhs());
+		register_manager.get_operand_reg(compare->rhs());
+		const auto lhs = reg_map[compare->lhs()->id];
+		const auto rhs = reg_map[compare->rhs()->id];
+		switch (compare->op) {
+		case BinaryOp::EQ:
+			riscv._beq(lhs, rhs, true_label);
+			break;
+		case BinaryOp::NOT_EQ:
+			riscv._bne(lhs, rhs, true_label);
+			break;
+		case BinaryOp::LT:
+			riscv._blt(lhs, rhs, true_label);
+			break;
+		case BinaryOp::GE:
+			riscv._bge(lhs, rhs, true_label);
+			break;
+		case BinaryOp::GT:
+			// lhs > rhs 等价于 rhs < lhs
+			riscv._blt(rhs, lhs, true_label);
+			break;
+		case BinaryOp::LE:
+			// lhs <= rhs 等价于 rhs >= lhs
+			riscv._bge(rhs, lhs, true_label);
+			break;
+		default:
+			assert(false);
+		}
+	}
+	else {
+		// 准备条件表达式
+		register_manager.get_operand_reg(branch->cond());
+		// 条件成立时跳转到 true 分支
+		riscv._bnez(reg_map[branch->cond()->id], true_label);
+	}
+	// 否则跳转到 false 分支，跳到紧接着的基本块的 j 在输出前删去
+	riscv._jump(riscv.block_label(branch->false_bb));
 }
 
 /**
  * @brief 处理 jump 指令，跳转到目标基本块
- * @param[in] jump jump 指令的数据
+ * @param[in] jump jump 指令
  */
-void visit(const koopa_raw_jump_t& jump) {
+void visit(const Jump* jump) {
+	// 目标基本块有参数时，先把实参传过去
+	if (jump->num_operands) {
+		pass_block_args(jump);
+	}
 	// 跳转到目标基本块
-	riscv._jump(jump.target->name + 1);
+	riscv._jump(riscv.block_label(jump->target));
 }
 
 /**
- * @brief 处理 load 指令，将加载出来的值存到栈上
- * @param[in] load load 指令的数据
- * @param[in] value load 指令自身，存储时用作键
+ * @brief 处理 load 指令，将加载出来的值存到分配的寄存器或栈上
+ * @param[in] load load 指令，存储时以其编号用作键
  */
-void visit(const koopa_raw_load_t& load, const koopa_raw_value_t& value) {
-	// 准备一个临时寄存器
-	auto reg = register_manager.new_reg();
-	// 获取当前栈偏移，压栈加载出来的值时需要用到
-	auto bias = context.stack_used;
+void visit(const Load* load) {
 	// ---[DEBUG]---
 	// 打印加载的值的类型
-	// printf("load: %s\n", koopaRawValueTagToString(load.src->kind.tag).c_str());
-	// riscv_ofs << "load: " << koopaRawValueTagToString(load.src->kind.tag).c_str() << endl;
+	// printf("load: %s\n", valueKindToString(load->src()->kind).c_str());
 	// ---[DEBUG END]---
+	auto src = load->src();
+	// 准备存放结果的寄存器
+	auto reg = register_manager.result_reg(load);
 	// 如果是全局变量，需要先获取地址，再解引用获取值
-	if (load.src->kind.tag == KOOPA_RVT_GLOBAL_ALLOC) {
-		riscv._la(reg, context_manager.get_global(load.src));
+	if (src->kind == Value::Kind::GLOBAL_ALLOC) {
+		riscv._la(reg, context_manager.get_global(src));
 		riscv._lw(reg, reg, 0);
 	}
-	// 如果是指针，加载出来后还需要解引用一下
-	else if (load.src->kind.tag == KOOPA_RVT_GET_ELEM_PTR) {
-		riscv._lw(reg, "sp", context.stack_map[load.src]);
-		riscv._lw(reg, reg, 0);
-	}
-	// 对于 get_ptr 指令同理
-	else if (load.src->kind.tag == KOOPA_RVT_GET_PTR) {
-		riscv._lw(reg, "sp", context.stack_map[load.src]);
-		riscv._lw(reg, reg, 0);
+	// 如果是指针，需要解引用一下，对于 get_ptr 指令同理
+	else if (src->kind == Value::Kind::GET_ELEM_PTR || src->kind == Value::Kind::GET_PTR) {
+		register_manager.get_operand_reg(src);
+		riscv._lw(reg, register_manager.reg_map[src->id], 0);
 	}
 	// 如果是栈上变量，直接获取值
 	else {
-		riscv._lw(reg, "sp", context.stack_map[load.src]);
+		riscv._lw(reg, SP, context.stack_map[src->id]);
 	}
-	// 将加载出来的值存到栈上
-	riscv._sw(reg, "sp", bias);
-	context.push(value, bias);
+	// 将加载出来的值保存下来
+	register_manager.save_result(load, reg);
 }
 
 /**
  * @brief 处理 store 指令
- * @param[in] store store 指令的数据
+ * @param[in] store store 指令
  */
-void visit(const koopa_raw_store_t& store) {
+void visit(const Store* store) {
 	// ---[DEBUG]---
 	// 打印要存储的值和目标地址的类型
-	// printf("store value: %s\n", koopaRawValueTagToString(store.value->kind.tag).c_str());
-	// printf("store dest: %s\n", koopaRawValueTagToString(store.dest->kind.tag).c_str());
+	// printf("store value: %s\n", valueKindToString(store->value()->kind).c_str());
+	// printf("store dest: %s\n", valueKindToString(store->dest()->kind).c_str());
 	// ---[DEBUG END]---
+	auto value = store->value();
+	auto dest = store->dest();
 	// 准备要存储的值
-	register_manager.get_operand_reg(store.value);
+	register_manager.get_operand_reg(value);
+	auto reg = register_manager.reg_map[value->id];
+	assert(reg != NO_REG);
 	// 如果是全局变量，需要先获取地址，再存储到解引用后的位置上
-	if (store.dest->kind.tag == KOOPA_RVT_GLOBAL_ALLOC) {
-		auto reg = register_manager.new_reg();
-		riscv._la(reg, context_manager.get_global(store.dest));
-		riscv._sw(register_manager.reg_map[store.value], reg, 0);
-	}
-	// 如果是指针，也需要再解引用一下才能获得目标地址
-	else if (store.dest->kind.tag == KOOPA_RVT_GET_ELEM_PTR) {
-		auto reg = register_manager.new_reg();
-		riscv._lw(reg, "sp", context.stack_map[store.dest]);
-		riscv._sw(register_manager.reg_map[store.value], reg, 0);
-	}
-	// 对于 get_ptr 指令同理
-	else if (store.dest->kind.tag == KOOPA_RVT_GET_PTR) {
-		auto reg = register_manager.new_reg();
-		riscv._lw(reg, "sp", context.stack_map[store.dest]);
-		riscv._sw(register_manager.reg_map[store.value], reg, 0);
+	if (dest->kind == Value::Kind::GLOBAL_ALLOC) {
+		auto addr = register_manager.new_reg();
+		riscv._la(addr, context_manager.get_global(dest));
+		riscv._sw(reg, addr, 0);
+	}
+	// 如果是指针，也需要再解引用一下才能获得目标地址，对于 get_ptr 指令同理
+	else if (dest->kind == Value::Kind::GET_ELEM_PTR || dest->kind == Value::Kind::GET_PTR) {
+		register_manager.get_operand_reg(dest);
+		riscv._sw(reg, register_manager.reg_map[dest->id], 0);
 	}
 	// 如果是栈上变量，直接存储到栈上目标位置即可
 	else {
-		assert(register_manager.reg_map[store.value] != "");
-		riscv._sw(register_manager.reg_map[store.value], "sp", context.stack_map[store.dest]);
+		riscv._sw(reg, SP, context.stack_map[dest->id]);
 	}
 }
 
 /**
  * @brief 处理 return 指令，如果有返回值，会将返回值存到 a0 寄存器中
- * @param[in] ret return 指令的数据
+ * @param[in] ret return 指令
  */
-void visit(const koopa_raw_return_t& ret) {
+void visit(const Return* ret) {
 	// 如果返回值非空，那么先把值搞到 a0 寄存器中
-	if (ret.value != nullptr) {
+	auto value = ret->value();
+	if (value != nullptr) {
 		// ---[DEBUG]---
 		// 打印返回值的类型
-		// printf("return: %s\n", koopaRawValueTagToString(ret.value->kind.tag).c_str());
+		// printf("return: %s\n", valueKindToString(value->kind).c_str());
 		// ---[DEBUG END]---
-		// 判断返回值的类型
-		switch (ret.value->kind.tag) {
-			// 形如 ret 1 直接返回整数的
-		case KOOPA_RVT_INTEGER:
-			riscv._li("a0", ret.value->kind.data.integer.value);
-			break;
-			// 形如 ret %n, 返回之前某操作的中间结果
-		case KOOPA_RVT_BINARY:
-		case KOOPA_RVT_LOAD:
-		case KOOPA_RVT_CALL:
-			riscv._lw("a0", "sp", context.stack_map[ret.value]);
-			break;
-		default:
-			assert(false && "Invalid return value");
-		}
+		// 形如 ret 1 直接返回整数的，ret @x 返回参数的，或 ret %n 返回之前某操作的中间结果
+		assert(value->kind == Value::Kind::INTEGER || value->kind == Value::Kind::FUNC_ARG || Liveness::is_candidate(value));
+		register_manager.load_operand(A0, value);
 	}
-	// 即将返回，需要恢复代表返回地址（返回后下一条指令地址）的寄存器 ra
-	if (context.save_ra) {
-		riscv._lw("ra", "sp", context.stack_size - 4);
+	// 即将返回，从序言之后的路径返回时需要生成尾声，提前返回的路径没有经过序言
+	if (context.framed[ret->parent->id]) {
+		epilogue();
 	}
-	// 恢复栈指针
-	riscv._addi("sp", "sp", context.stack_size);
 	// 返回
 	riscv._ret();
 };
 
 /**
- * @brief 处理 binary 指令，计算二元运算的结果，并存到栈上
- * @param[in] binary binary 指令的数据
- * @param[in] value binary 指令自身，存储时用作键
+ * @brief 一个操作数是能放进 12 位立即数的整数时，用 I 型指令计算二元运算，省去 li 与一个临时寄存器
+ * @param[in] binary binary 指令
+ * @return 是否已经生成代码，没有对应的 I 型指令或立即数超出范围时返回 false
+ * @note - 整数在左侧时交换两个操作数，比较运算同时反转方向，sub 与除法没有这样的对称性
+ * @note - 乘整数不受范围限制，按代价展开为移位加减序列；除以整数与对整数取余用 mulh 乘魔数与移位计算
+ * @note - sub x, C 即 addi x, -C；eq / ne 先用 xori 比较再 seqz / snez；lt 为 slti，le x, C 即 slti x, C + 1，ge 与 gt 再取反
  */
-void visit(const koopa_raw_binary_t& binary, const koopa_raw_value_t& value) {
-	// 准备两个操作数到寄存器中
-	bool lhs_use_reg = register_manager.get_operand_reg(binary.lhs);
-	bool rhs_use_reg = register_manager.get_operand_reg(binary.rhs);
-	// 确定中间结果的寄存器
-	// 如果两个都是 0，即在 x0 寄存器，显然要新开一个寄存器，来存储中间结果
-	if (!lhs_use_reg && !rhs_use_reg) {
-		register_manager.reg_map[value] = register_manager.new_reg();
+bool binary_imm(const Binary* binary) {
+	auto op = binary->op;
+	auto value = binary->lhs();
+	auto constant = binary->rhs();
+	if (constant->kind != Value::Kind::INTEGER) {
+		if (value->kind != Value::Kind::INTEGER) {
+			return false;
+		}
+		swap(value, constant);
+		switch (op) {
+		case BinaryOp::LT:
+			op = BinaryOp::GT;
+			break;
+		case BinaryOp::GT:
+			op = BinaryOp::LT;
+			break;
+		case BinaryOp::LE:
+			op = BinaryOp::GE;
+			break;
+		case BinaryOp::GE:
+			op = BinaryOp::LE;
+			break;
+		case BinaryOp::SUB:
+		case BinaryOp::DIV:
+		case BinaryOp::MOD:
+			return false;
+		default:
+			break;
+		}
 	}
-	// 对于其他情况，找一个已有寄存器来存储中间结果
-	else if (lhs_use_reg) {
-		register_manager.reg_map[value] = register_manager.reg_map[binary.lhs];
+	if (op == BinaryOp::MUL) {
+		register_manager.get_operand_reg(value);
+		const auto cur = register_manager.result_reg(binary);
+		riscv._muli(cur, register_manager.reg_map[value->id], static_cast<const Integer*>(constant)->value);
+		register_manager.save_result(binary, cur);
+		return true;
 	}
-	else {
-		register_manager.reg_map[value] = register_manager.reg_map[binary.rhs];
+	// 除数为整数时用乘法与移位代替 div / rem
+	if (op == BinaryOp::DIV || op == BinaryOp::MOD) {
+		register_manager.get_operand_reg(value);
+		const auto cur = register_manager.result_reg(binary);
+		const auto src = register_manager.reg_map[value->id];
+		const auto divisor = static_cast<const Integer*>(constant)->value;
+		if (op == BinaryOp::DIV) {
+			riscv._divi(cur, src, divisor);
+		}
+		else {
+			riscv._remi(cur, src, divisor);
+		}
+		register_manager.save_result(binary, cur);
+		return true;
+	}
+	// 用 64 位计算 -C 与 C + 1，避免溢出
+	long long imm = static_cast<const Integer*>(constant)->value;
+	long long needed;
+	switch (op) {
+	case BinaryOp::ADD:
+	case BinaryOp::AND:
+	case BinaryOp::OR:
+	case BinaryOp::EQ:
+	case BinaryOp::NOT_EQ:
+	case BinaryOp::LT:
+	case BinaryOp::GE:
+		needed = imm;
+		break;
+	case BinaryOp::SUB:
+		needed = -imm;
+		break;
+	case BinaryOp::LE:
+	case BinaryOp::GT:
+		needed = imm + 1;
+		break;
+	default:
+		return false;
 	}
+	if (needed < -2048 || needed >= 2048) {
+		return false;
+	}
+	// 准备另一个操作数到寄存器中
+	register_manager.get_operand_reg(value);
+	const auto cur = register_manager.result_reg(binary);
+	const auto src = register_manager.reg_map[value->id];
+	const int i = needed;
+	switch (op) {
+	case BinaryOp::ADD:
+	case BinaryOp::SUB:
+		riscv._addi(cur, src, i);
+		break;
+	case BinaryOp::AND:
+		riscv._andi(cur, src, i);
+		break;
+	case BinaryOp::OR:
+		riscv._ori(cur, src, i);
+		break;
+	case BinaryOp::EQ:
+		riscv._xori(cur, src, i);
+		riscv._seqz(cur, cur);
+		break;
+	case BinaryOp::NOT_EQ:
+		riscv._xori(cur, src, i);
+		riscv._snez(cur, cur);
+		break;
+	case BinaryOp::LT:
+	case BinaryOp::LE:
+		riscv._slti(cur, src, i);
+		break;
+	default:
+		// ge 与 gt 分别是 lt 与 le 取反
+		riscv._slti(cur, src, i);
+		riscv._xori(cur, cur, 1);
+		break;
+	}
+	register_manager.save_result(binary, cur);
+	return true;
+}
 
+/**
+ * @brief 处理 binary 指令，计算二元运算的结果，并存到分配的寄存器或栈上
+ * @param[in] binary binary 指令，存储时以其编号用作键
+ */
+void visit(const Binary* binary) {
+	// 与紧接着的 br 合并为比较分支指令，在 br 处生成
+	if (Liveness::is_branch_compare(binary)) {
+		return;
+	}
+	// 一个操作数是小整数时使用 I 型指令
+	if (binary_imm(binary)) {
+		return;
+	}
+	auto& reg_map = register_manager.reg_map;
+	// 准备两个操作数到寄存器中
+	register_manager.get_operand_reg(binary->lhs());
+	register_manager.get_operand_reg(binary->rhs());
 	// 获取存放中间结果的寄存器
-	const auto cur = register_manager.reg_map[value];
+	const auto cur = register_manager.result_reg(binary);
 	// 获取两个操作数所在的寄存器
-	const auto lhs = register_manager.reg_map[binary.lhs];
-	const auto rhs = register_manager.reg_map[binary.rhs];
+	const auto lhs = reg_map[binary->lhs()->id];
+	const auto rhs = reg_map[binary->rhs()->id];
 	// 根据二元运算符的类型，执行相应的指令
-	switch (binary.op) {
-	case KOOPA_RBO_EQ:
+	switch (binary->op) {
+	case BinaryOp::EQ:
 		riscv._xor(cur, lhs, rhs);
 		riscv._seqz(cur, cur);
 		break;
-	case KOOPA_RBO_NOT_EQ:
+	case BinaryOp::NOT_EQ:
 		riscv._xor(cur, lhs, rhs);
 		riscv._snez(cur, cur);
 		break;
-	case KOOPA_RBO_LE:
+	case BinaryOp::LE:
 		// lhs <= rhs 等价于 !(lhs > rhs)
 		riscv._sgt(cur, lhs, rhs);
 		riscv._seqz(cur, cur);
 		break;
-	case KOOPA_RBO_GE:
+	case BinaryOp::GE:
 		// lhs >= rhs 等价于 !(lhs < rhs)
 		riscv._slt(cur, lhs, rhs);
 		riscv._seqz(cur, cur);
 		break;
-	case KOOPA_RBO_LT:
+	case BinaryOp::LT:
 		riscv._slt(cur, lhs, rhs);
 		break;
-	case KOOPA_RBO_GT:
+	case BinaryOp::GT:
 		riscv._sgt(cur, lhs, rhs);
 		break;
-	case KOOPA_RBO_OR:
+	case BinaryOp::OR:
 		riscv._or(cur, lhs, rhs);
 		break;
-	case KOOPA_RBO_AND:
+	case BinaryOp::AND:
 		riscv._and(cur, lhs, rhs);
 		break;
-	case KOOPA_RBO_SUB:
+	case BinaryOp::SUB:
 		riscv._sub(cur, lhs, rhs);
 		break;
-	case KOOPA_RBO_ADD:
+	case BinaryOp::ADD:
 		riscv._add(cur, lhs, rhs);
 		break;
-	case KOOPA_RBO_MUL:
+	case BinaryOp::MUL:
 		riscv._mul(cur, lhs, rhs);
 		break;
-	case KOOPA_RBO_DIV:
+	case BinaryOp::DIV:
 		riscv._div(cur, lhs, rhs);
 		break;
-	case KOOPA_RBO_MOD:
+	case BinaryOp::MOD:
 		riscv._rem(cur, lhs, rhs);
 		break;
 	default:
-		printf("Invalid binary operation: %s\n", koopaRawBinaryOpToString(binary.op).c_str());
+		printf("Invalid binary operation: %s\n", binaryOpToString(binary->op).c_str());
 	}
-	// 把结果存回栈中
-	context.push(value, context.stack_used);
-	// 注意要先压栈才能通过 stack_map 访问到
-	riscv._sw(cur, "sp", context.stack_map[value]);
+	// 把结果保存下来
+	register_manager.save_result(binary, cur);
 }
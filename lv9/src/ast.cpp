@@ -1,11 +1,15 @@
 #include "include/ast.hpp"
 
-// 全局符号表
-SymbolTable global_symbol_table;
-// 局部符号表
-SymbolTable* local_symbol_table = &global_symbol_table;
+// 符号表
+SymbolTable symbol_table;
 // 全局环境管理器
 EnvironmentManager environment_manager;
+// Koopa IR 构建器
+IRBuilder ir_builder;
+// AST 内存池
+Arena ast_arena;
+// 标识符字符串池
+StringPool string_pool;
 
 /**
  * @brief 打印根节点 ProgramAST
@@ -24,91 +28,81 @@ Result ProgramAST::print() const {
  * @brief 打印函数定义节点 FuncDefAST
  * */
 Result FuncDefAST::print() const {
-    koopa_ofs << endl;
     // 函数体内必然非全局环境
     environment_manager.is_global = false;
-    // 保存当前局部符号表
-    SymbolTable* parent_symbol_table = local_symbol_table;
-    // 创建新的局部符号表
-    local_symbol_table = new SymbolTable();
-    // 设置父符号表
-    local_symbol_table->set_parent(parent_symbol_table);
+    // 进入新的作用域
+    symbol_table.push_scope();
     // 清空全局环境管理器的 is_symbol_allocated，因为不同函数体内是独立的
     environment_manager.is_symbol_allocated.clear();
     // 清空临时寄存器计数器
     environment_manager.temp_count = 0;
-    // 输出函数声明
-    koopa_ofs << "fun @" << ident;
-    koopa_ofs << "(";
-    // 输出函数参数
+    // 准备函数参数
+    vector<pair<string, const Type*>> params;
     if (func_f_params) {
-        bool is_first = true;
         // 遍历所有函数参数
         for (auto& item : *func_f_params) {
-            if (is_first) {
-                is_first = false;
-            }
-            else {
-                koopa_ofs << ", ";
-            }
-            ((FuncFParamAST*)item.get())->as_param();
+            auto param = (FuncFParamAST*)item;
+            params.push_back({ "@" + param->ident.str(), param->as_param() });
         }
     }
-    koopa_ofs << ")";
-    // 输出函数返回类型
+    // 准备函数返回类型
+    const Type* ret_type;
     if (func_type == FuncType::INT) {
-        koopa_ofs << ": i32";
+        ret_type = ir_builder.int_type();
         // 记录这个函数有返回值
         environment_manager.is_func_return[ident] = true;
     }
     else {
+        ret_type = ir_builder.unit_type();
         // 记录这个函数没有返回值
         environment_manager.is_func_return[ident] = false;
     }
-    // 输出函数体
-    koopa_ofs << " {" << endl;
-    koopa_ofs << "%" << ident << "_entry:" << endl;
+    // 开始函数定义
+    ir_builder.begin_function("@" + ident.str(), params, ret_type);
+    ir_builder.label("%" + ident.str() + "_entry");
+    // 标记函数体内被赋值的变量名，没有被赋值的普通参数不必再存到栈上
+    vector<bool> assigned(string_pool.size(), false);
+    block->mark_assigned(assigned);
     // 首先打印参数
     for (auto& item : *func_f_params) {
+        auto param = (FuncFParamAST*)item;
+        param->is_assigned = assigned[param->ident.id];
         item->print();
     }
     // 然后打印函数体内语句
     block->print();
     // 最后打印返回语句，保证函数最后一句话是 ret
     if (func_type == FuncType::INT) {
-        koopa_ofs << "\tret 0" << endl;
+        ir_builder.ret(IMM_(0));
     }
     else {
-        koopa_ofs << "\tret" << endl;
+        ir_builder.ret();
     }
-    koopa_ofs << "}" << endl;
-    // 恢复父符号表
-    delete local_symbol_table;
-    local_symbol_table = parent_symbol_table;
+    ir_builder.end_function();
+    // 退出作用域
+    symbol_table.pop_scope();
     // 恢复全局环境状态
     environment_manager.is_global = true;
     return Result();
 }
 
 /**
- * @brief 在函数签名中打印函数参数，输出行内字符串
- * @note 形如 @ident: i32 / @arr: *i32 / @arr: *[i32, 10]
+ * @brief 获取函数签名中的函数参数类型
+ * @return 参数类型，形如 i32 / *i32 / *[i32, 10]
  */
-void FuncFParamAST::as_param() const {
+const Type* FuncFParamAST::as_param() const {
     // 如果是数组参数
     if (is_array) {
-        koopa_ofs << "@" << ident << ": *";
         // 准备数组索引
         vector<int> indices;
         for (auto& item : *array_index) {
             indices.push_back(item->print().value);
         }
-        // 格式化数组类型
-        format_array_type(indices);
+        return ir_builder.pointer_type(ir_builder.array_type(indices));
     }
     // 如果是普通参数
     else {
-        koopa_ofs << "@" << ident << ": i32";
+        return ir_builder.int_type();
     }
 }
 
@@ -119,33 +113,26 @@ void FuncFParamAST::as_param() const {
  * @note store @x, %x
  */
 Result FuncFParamAST::print() const {
-    // 在当前层级符号表中分配变量
-    string ident_with_suffix = local_symbol_table->assign(ident);
-    // 如果是数组参数
+    // 如果是数组参数，指针本身不能被赋值，使用时直接从参数 @arr 寻址
     if (is_array) {
-        // 形如 @arr = alloc *[[i32, 3], 2]
-        koopa_ofs << "\t@" << ident_with_suffix << " = alloc *";
-        // 准备数组索引
-        vector<int> indices;
-        for (auto& item : *array_index) {
-            indices.push_back(item->print().value);
-        }
-        // 格式化数组类型
-        format_array_type(indices);
-        koopa_ofs << endl;
         // 在当前层级符号表中创建数组类型变量
         // 由于传参必定是指针，默认有一个 []，所以维度数需要 +1
-        local_symbol_table->create(ident_with_suffix, PTR_(array_index->size() + 1));
+        symbol_table.create(ident, PTR_(array_index->size() + 1));
+        return Result();
     }
-    // 如果是普通参数
-    else {
-        // 形如 @x = alloc i32
-        koopa_ofs << "\t@" << ident_with_suffix << " = alloc i32" << endl;
-        // 在当前层级符号表中创建变量
-        local_symbol_table->create(ident_with_suffix, VAR_);
+    // 没有被重新赋值的普通参数，使用时直接读取参数 @x
+    if (!is_assigned) {
+        symbol_table.create(ident, ARG_);
+        return Result();
     }
-    // 输出形如 store @x, %x 的 store 指令
-    koopa_ofs << "\tstore @" << ident << ", @" << ident_with_suffix << endl;
+    // 在当前层级符号表中分配变量
+    string ident_with_suffix = symbol_table.assign(ident);
+    // 形如 @x_1 = alloc i32
+    ir_builder.alloc("@" + ident_with_suffix, as_param());
+    // 在当前层级符号表中创建变量
+    symbol_table.create(ident, VAR_);
+    // 输出形如 store @x, @x_1 的 store 指令
+    ir_builder.store("@" + ident.str(), "@" + ident_with_suffix);
     return Result();
 }
 
@@ -153,25 +140,30 @@ Result FuncFParamAST::print() const {
  * @brief 打印函数体
  * */
 Result BlockAST::print() const {
-    // 保存当前局部符号表
-    SymbolTable* parent_symbol_table = local_symbol_table;
-    // 创建新的局部符号表
-    local_symbol_table = new SymbolTable();
-    // 设置父符号表
-    local_symbol_table->set_parent(parent_symbol_table);
+    // 进入新的作用域
+    symbol_table.push_scope();
     // 遍历所有语句
     for (auto& item : block_items) {
         // 如果符号表内没有出现返回语句则继续打印
-        if (!local_symbol_table->is_returned) {
+        if (!symbol_table.is_returned()) {
             item->print();
         }
     }
-    // 恢复父符号表
-    delete local_symbol_table;
-    local_symbol_table = parent_symbol_table;
+    // 退出作用域
+    symbol_table.pop_scope();
     return Result();
 }
 
+/**
+ * @brief 标记基本块内被赋值的变量名
+ * @param[inout] assigned 按标识符编号标记是否被赋值
+ * */
+void BlockAST::mark_assigned(vector<bool>& assigned) const {
+    for (auto& item : block_items) {
+        item->mark_assigned(assigned);
+    }
+}
+
 /**
  * @brief 打印常量定义列表
  * */
@@ -188,7 +180,7 @@ Result ConstDeclAST::print() const {
  * */
 Result ConstDefAST::print() const {
     // 在当前层级符号表中分配常量名
-    string ident_with_suffix = local_symbol_table->assign(ident);
+    string ident_with_suffix = symbol_table.assign(ident);
     // 数组常量
     if (array_index->size() > 0) {
         // 准备数组索引
@@ -197,34 +189,25 @@ Result ConstDefAST::print() const {
             Result index_result = item->print();
             index_results.push_back(index_result.value);
         }
-        // 输出类型声明
-        print_array_type(ident_with_suffix, index_results);
         // 判断是否初始化
         // 给定了初始化列表
         if (value) {
-            ((ConstInitValAST*)value.get())->print(ident_with_suffix, index_results);
+            ((ConstInitValAST*)value)->print(ident_with_suffix, index_results);
         }
         // 没有给定初始化列表，默认置零
         // 由于是常量，所以必然要初始化掉
         else {
-            // 全局数组可以用 zeroinit 初始化
-            if (environment_manager.is_global) {
-                koopa_ofs << ", zeroinit" << endl;
-            }
-            // 局部数组不能用 zeroinit 初始化
-            else {
-                koopa_ofs << endl;
-            }
+            print_array(ident_with_suffix, index_results);
         }
         // 在当前层级符号表中创建数组类型常量，并记录维度数
-        local_symbol_table->create(ident_with_suffix, ARR_(array_index->size()));
+        symbol_table.create(ident, ARR_(array_index->size()));
     }
     // 全局 / 局部非数组常量
     else {
         // 计算常量值
         Result value_result = value->print();
         // 在当前层级符号表中创建常量
-        local_symbol_table->create(ident_with_suffix, VAL_(value_result.value));
+        symbol_table.create(ident, VAL_(value_result.value));
     }
     return Result();
 }
@@ -245,14 +228,6 @@ void ConstInitValAST::init(const vector<int>& indices, int*& arr, int& cur, int
         product *= indices[i];
         steps.push_front(product);
     }
-    // ---[DEBUG]---
-    // 打印 steps
-    // koopa_ofs << "\nsteps: ";
-    // for (auto& item : steps) {
-    //   koopa_ofs << item << " ";
-    // }
-    // koopa_ofs << endl;
-    // ---[DEBUG END]---
     // 判断 init_values 是否为空
     // 若为空，则至少要填入一个 0 使得后续对齐可以工作
     // 如果不填的话后续对齐会直接跳过，因为初始的时候必然是对齐了 align 的
@@ -262,7 +237,7 @@ void ConstInitValAST::init(const vector<int>& indices, int*& arr, int& cur, int
     else {
         // 从前到后遍历初始化值的列表
         for (auto& item : *init_values) {
-            auto it = (ConstInitValAST*)(item.get());
+            auto it = (ConstInitValAST*)(item);
             // 如果是整数，直接放入
             if (it->const_exp) {
                 Result res = it->print();
@@ -309,13 +284,7 @@ Result ConstInitValAST::print(const string& ident, const vector<int>& indices) {
     int cur = 0;
     init(indices, array, cur, total);
     // 打印数组
-    // 记录当前打印到的索引
-    int index = 0;
-    // 记录基址
-    vector<int> bases;
-    // 基址初始化为 -1，方便后续特判最外层
-    bases.push_back(-1);
-    print_array(ident, indices, array, 0, index, bases);
+    print_array(ident, indices, array);
     // 释放数组
     delete[] array;
     return Result();
@@ -360,7 +329,7 @@ Result VarDeclAST::print() const {
  * */
 Result VarDefAST::print() const {
     // 在当前层级符号表中分配变量
-    string ident_with_suffix = local_symbol_table->assign(ident);
+    string ident_with_suffix = symbol_table.assign(ident);
     // 数组变量
     if (array_index->size() > 0) {
         // 准备数组索引
@@ -369,26 +338,17 @@ Result VarDefAST::print() const {
             Result index_result = item->print();
             index_results.push_back(index_result.value);
         }
-        // 输出类型声明
-        print_array_type(ident_with_suffix, index_results);
         // 判断是否初始化
         // 给定了初始化列表
         if (value) {
-            ((InitValAST*)(*value).get())->print(ident_with_suffix, index_results);
+            ((InitValAST*)(*value))->print(ident_with_suffix, index_results);
         }
         // 没有给定初始化列表，默认置零
         else {
-            // 全局数组可以用 zeroinit 初始化
-            if (environment_manager.is_global) {
-                koopa_ofs << ", zeroinit" << endl;
-            }
-            // 局部数组不能用 zeroinit 初始化
-            else {
-                koopa_ofs << endl;
-            }
+            print_array(ident_with_suffix, index_results);
         }
         // 在当前层级符号表中创建数组类型变量，并记录维度数
-        local_symbol_table->create(ident_with_suffix, ARR_(array_index->size()));
+        symbol_table.create(ident, ARR_(array_index->size()));
         return Result();
     }
     // 非数组变量
@@ -399,11 +359,11 @@ Result VarDefAST::print() const {
             if (value) {
                 Result value_result = (*value)->print();
                 assert(value_result.type == Result::Type::IMM);
-                koopa_ofs << "global @" << ident_with_suffix << " = alloc i32, " << value_result << endl;
+                ir_builder.global_alloc("@" + ident_with_suffix, ir_builder.int_type(), ir_builder.integer(value_result.value));
             }
             // 没有给定初始化列表，默认置零
             else {
-                koopa_ofs << "global @" << ident_with_suffix << " = alloc i32, zeroinit" << endl;
+                ir_builder.global_alloc("@" + ident_with_suffix, ir_builder.int_type(), ir_builder.zero_init(ir_builder.int_type()));
             }
         }
         // 局部变量
@@ -411,17 +371,17 @@ Result VarDefAST::print() const {
             // 判断是否需要生成 alloc 指令
             // 如果已经分配过，不能再次分配，因为不能有两条同名的 alloc 指令
             if (!environment_manager.is_symbol_allocated[ident_with_suffix]) {
-                koopa_ofs << "\t@" << ident_with_suffix << " = alloc i32" << endl;
+                ir_builder.alloc("@" + ident_with_suffix, ir_builder.int_type());
                 environment_manager.is_symbol_allocated[ident_with_suffix] = true;
             }
             // 若初始值不为空，则生成 store 指令
             if (value) {
                 Result value_result = (*value)->print();
-                koopa_ofs << "\tstore " << value_result << ", @" << ident_with_suffix << endl;
+                ir_builder.store(value_result, "@" + ident_with_suffix);
             }
         }
         // 在当前层级符号表中创建变量
-        local_symbol_table->create(ident_with_suffix, VAR_);
+        symbol_table.create(ident, VAR_);
         return Result();
     }
 }
@@ -451,7 +411,7 @@ void InitValAST::init(const vector<int>& indices, int* arr, int& cur, int align)
     else {
         // 从前到后遍历初始化值的列表
         for (auto& item : *init_values) {
-            auto it = (InitValAST*)(item.get());
+            auto it = (InitValAST*)(item);
             // 如果是整数，直接放入
             if (it->exp) {
                 Result res = it->print();
@@ -497,13 +457,7 @@ Result InitValAST::print(const string& ident, const vector<int>& indices) {
     int cur = 0;
     init(indices, array, cur, total);
     // 打印数组
-    // 记录当前打印到的索引
-    int index = 0;
-    // 记录基址
-    vector<int> bases;
-    // 基址初始化为 -1，方便后续特判最外层
-    bases.push_back(-1);
-    print_array(ident, indices, array, 0, index, bases);
+    print_array(ident, indices, array);
     // 释放数组
     delete[] array;
     return Result();
@@ -540,31 +494,42 @@ Result StmtIfAST::print() const {
     // 根据是否存在 else 语句进行分支处理
     if (else_stmt) {
         // 生成 br 指令
-        koopa_ofs << "\tbr " << exp_result << ", " << then_label << ", " << else_label << endl;
+        ir_builder.branch(exp_result, then_label, else_label);
         // 生成 then 语句块
-        koopa_ofs << then_label << ":" << endl;
+        ir_builder.label(then_label);
         then_stmt->print();
-        koopa_ofs << "\tjump " << end_label << endl;
+        ir_builder.jump(end_label);
         // 生成 else 语句块
-        koopa_ofs << else_label << ":" << endl;
+        ir_builder.label(else_label);
         (*else_stmt)->print();
-        koopa_ofs << "\tjump " << end_label << endl;
+        ir_builder.jump(end_label);
     }
     else {
         // 生成 br 指令
-        koopa_ofs << "\tbr " << exp_result << ", " << then_label << ", " << end_label << endl;
+        ir_builder.branch(exp_result, then_label, end_label);
         // 生成 then 语句块
-        koopa_ofs << then_label << ":" << endl;
+        ir_builder.label(then_label);
         then_stmt->print();
-        koopa_ofs << "\tjump " << end_label << endl;
+        ir_builder.jump(end_label);
     }
     // 生成 end 标签
-    koopa_ofs << end_label << ":" << endl;
+    ir_builder.label(end_label);
     // 恢复是否返回的记录，避免 if 生成的语句块中有单条 return 语句修改当前块 is_returned = true
-    local_symbol_table->is_returned = false;
+    symbol_table.set_returned(false);
     return Result();
 }
 
+/**
+ * @brief 标记 if 语句两个分支内被赋值的变量名
+ * @param[inout] assigned 按标识符编号标记是否被赋值
+ * */
+void StmtIfAST::mark_assigned(vector<bool>& assigned) const {
+    then_stmt->mark_assigned(assigned);
+    if (else_stmt) {
+        (*else_stmt)->mark_assigned(assigned);
+    }
+}
+
 /**
  * @brief 打印 while 语句
  * */
@@ -584,37 +549,45 @@ Result StmtWhileAST::print() const {
     environment_manager.add_while_count();
     // 生成 while 循环
     // 首行生成一条跳转指令，跳转到 while 循环的入口，避免之前最后一条指令是标号，如函数起始处
-    koopa_ofs << "\tjump " << entry_label << endl;
+    ir_builder.jump(entry_label);
     // 生成 while 循环的入口标签
-    koopa_ofs << entry_label << ":" << endl;
+    ir_builder.label(entry_label);
     // 打印条件表达式，并存储计算得出的条件表达式结果
     Result exp_result = exp->print();
     // 备份是否返回的记录，避免 while 语句中的单句 return 修改当前块 is_returned
-    bool backup_is_returned = local_symbol_table->is_returned;
+    bool backup_is_returned = symbol_table.is_returned();
     // 生成条件跳转指令
-    koopa_ofs << "\tbr " << exp_result << ", " << body_label << ", " << end_label << endl;
+    ir_builder.branch(exp_result, body_label, end_label);
     // 生成 while 循环体
-    koopa_ofs << body_label << ":" << endl;
+    ir_builder.label(body_label);
     stmt->print();
-    koopa_ofs << "\tjump " << entry_label << endl;
+    ir_builder.jump(entry_label);
     // 生成 end 标签
-    koopa_ofs << end_label << ":" << endl;
+    ir_builder.label(end_label);
     // 恢复是否返回的记录
-    local_symbol_table->is_returned = backup_is_returned;
+    symbol_table.set_returned(backup_is_returned);
     // 恢复当前 while 循环计数器 current
     environment_manager.set_while_current(old_while_current);
     return Result();
 }
 
+/**
+ * @brief 标记循环体内被赋值的变量名
+ * @param[inout] assigned 按标识符编号标记是否被赋值
+ * */
+void StmtWhileAST::mark_assigned(vector<bool>& assigned) const {
+    stmt->mark_assigned(assigned);
+}
+
 /**
  * @brief 打印 break 语句
  * */
 Result StmtBreakAST::print() const {
     // 生成跳转指令，跳转到当前 while 循环（即 current 计数器）的结束标签
-    koopa_ofs << "\tjump " << environment_manager.get_while_end_label(true) << endl;
+    ir_builder.jump(environment_manager.get_while_end_label(true));
     // 生成跳转后标签，避免 jump 指令成为最后一条语句
     auto jump_label = environment_manager.get_jump_label();
-    koopa_ofs << jump_label << ":" << endl;
+    ir_builder.label(jump_label);
     return Result();
 }
 
@@ -623,10 +596,10 @@ Result StmtBreakAST::print() const {
  * */
 Result StmtContinueAST::print() const {
     // 生成跳转指令，跳转到当前 while 循环（即 current 计数器）的入口标签
-    koopa_ofs << "\tjump " << environment_manager.get_while_entry_label(true) << endl;
+    ir_builder.jump(environment_manager.get_while_entry_label(true));
     // 生成跳转后标签，避免 jump 指令成为最后一条语句
     auto jump_label = environment_manager.get_jump_label();
-    koopa_ofs << jump_label << ":" << endl;
+    ir_builder.label(jump_label);
     return Result();
 }
 
@@ -636,14 +609,14 @@ Result StmtContinueAST::print() const {
  * */
 Result StmtAssignAST::print() const {
     // 获取左值
-    auto l_val_ast = (LValAST*)l_val.get();
+    auto l_val_ast = (LValAST*)l_val;
     // 获取变量名
     auto ident = l_val_ast->ident;
-    // 获取变量名在符号表中的位置，可能需要向上级符号表查找
-    string ident_with_suffix = local_symbol_table->locate(ident);
-    assert(local_symbol_table->exist(ident_with_suffix));
+    // 获取变量名在符号表中当前可见的绑定，即最内层作用域中的同名变量
+    assert(symbol_table.exist(ident));
+    string ident_with_suffix = symbol_table.locate(ident);
     // 获取变量
-    auto symbol = local_symbol_table->read(ident_with_suffix);
+    auto symbol = symbol_table.read(ident);
     // 计算表达式结果并存储到变量中
     Result exp_result = exp->print();
     // 判断左值是否为数组相关类型
@@ -659,50 +632,60 @@ Result StmtAssignAST::print() const {
             auto prev_reg = CUR_REG_;
             auto index = (*l_val_ast->array_index)[i]->print();
             if (i == 0) {
-                koopa_ofs << "\t" << NEW_REG_ << " = getelemptr @" << ident_with_suffix << ", " << index << endl;
+                ir_builder.get_elem_ptr(NEW_REG_, "@" + ident_with_suffix, index);
             }
             else {
-                koopa_ofs << "\t" << NEW_REG_ << " = getelemptr " << prev_reg << ", " << index << endl;
+                ir_builder.get_elem_ptr(NEW_REG_, prev_reg, index);
             }
         }
         // 最后存储右值到目标地址
-        koopa_ofs << "\tstore " << exp_result << ", " << CUR_REG_ << endl;
+        ir_builder.store(exp_result, CUR_REG_);
     }
     // 指针类型，即左值是通过函数参数传进来的情况
     else if (symbol.type == Symbol::Type::PTR) {
         /*
         已知 arr 是一个 int[][3] 传进来的指针，即类型为 *[i32, 3]
         那么 arr[2][3] = 1 应当翻译为：
-        %0 = load @arr
-        %1 = getptr %0, 2
-        %2 = getelemptr %1, 3
-        store 1, %2
+        %0 = getptr @arr, 2
+        %1 = getelemptr %0, 3
+        store 1, %1
          */
-         // 先 load 出基指针
-        koopa_ofs << "\t" << NEW_REG_ << " = load @" << ident_with_suffix << endl;
+        // 基指针就是参数本身
+        ir_builder.alias(NEW_REG_, "@" + ident.str());
         // 再进行寻址
         for (int i = 0;i < l_val_ast->array_index->size();i++) {
             auto prev_reg = CUR_REG_;
             auto index = (*l_val_ast->array_index)[i]->print();
             // 如果是第一次寻址，则使用 getptr 指令
             if (i == 0) {
-                koopa_ofs << "\t" << NEW_REG_ << " = getptr " << prev_reg << ", " << index << endl;
+                ir_builder.get_ptr(NEW_REG_, prev_reg, index);
             }
             // 否则使用 getelemptr 指令
             else {
-                koopa_ofs << "\t" << NEW_REG_ << " = getelemptr " << prev_reg << ", " << index << endl;
+                ir_builder.get_elem_ptr(NEW_REG_, prev_reg, index);
             }
         }
         // 最后存储右值到目标地址
-        koopa_ofs << "\tstore " << exp_result << ", " << CUR_REG_ << endl;
+        ir_builder.store(exp_result, CUR_REG_);
     }
     // 若不是数组/指针类型，则直接存储右值到目标地址
     else {
-        koopa_ofs << "\tstore " << exp_result << ", @" << ident_with_suffix << endl;
+        ir_builder.store(exp_result, "@" + ident_with_suffix);
     }
     return Result();
 }
 
+/**
+ * @brief 标记被赋值的变量名，数组元素赋值不改变参数本身，不标记
+ * @param[inout] assigned 按标识符编号标记是否被赋值
+ * */
+void StmtAssignAST::mark_assigned(vector<bool>& assigned) const {
+    auto l_val_ast = (LValAST*)l_val;
+    if (l_val_ast->array_index->empty()) {
+        assigned[l_val_ast->ident.id] = true;
+    }
+}
+
 /**
  * @brief 打印表达式语句
  * */
@@ -722,18 +705,18 @@ Result StmtReturnAST::print() const {
     // 若表达式不为空，则计算表达式结果并返回
     if (exp) {
         Result exp_result = (*exp)->print();
-        koopa_ofs << "\tret " << exp_result << endl;
+        ir_builder.ret(exp_result);
     }
     // 若表达式为空，则单句返回即可
     else {
-        koopa_ofs << "\tret" << endl;
+        ir_builder.ret();
     }
     // 设置当前块 is_returned 为 true
-    local_symbol_table->is_returned = true;
+    symbol_table.set_returned(true);
     // 设置返回结束标签，这样可以避免一个标号末尾出现多句 ret / br / jump 的情况
     // 也即我们总是保证每次生成结束时最后一条语句并非跳转指令，那么就能保证不会出现多条改变控制流的语句都在最后的情况
     auto jump_label = environment_manager.get_jump_label();
-    koopa_ofs << jump_label << ":" << endl;
+    ir_builder.label(jump_label);
     return Result();
 }
 
@@ -743,13 +726,19 @@ Result StmtReturnAST::print() const {
  */
 Result LValAST::print() const {
     // 获取变量名在符号表中的位置，然后读取其值
-    string ident_with_suffix = local_symbol_table->locate(ident);
-    assert(local_symbol_table->exist(ident_with_suffix));
-    auto symbol = local_symbol_table->read(ident_with_suffix);
+    assert(symbol_table.exist(ident));
+    string ident_with_suffix = symbol_table.locate(ident);
+    auto symbol = symbol_table.read(ident);
     // 若变量是变量，则使用 load 指令读取其值
     if (symbol.type == Symbol::Type::VAR) {
         Result result = NEW_REG_;
-        koopa_ofs << "\t" << result << " = load @" << ident_with_suffix << endl;
+        ir_builder.load(result, "@" + ident_with_suffix);
+        return result;
+    }
+    // 若变量是没有被重新赋值的参数，则直接使用参数的值
+    else if (symbol.type == Symbol::Type::ARG) {
+        Result result = NEW_REG_;
+        ir_builder.alias(result, "@" + ident.str());
         return result;
     }
     // 若变量是常量，则直接返回常量值
@@ -763,14 +752,6 @@ Result LValAST::print() const {
         for (auto& item : *array_index) {
             indices.push_back(item->print());
         }
-        // ---[DEBUG]---
-        // 打印数组索引
-        // koopa_ofs << "indices: ";
-        // for (auto& item : indices) {
-        //   koopa_ofs << item << " ";
-        // }
-        // koopa_ofs << endl;
-        // ---[DEBUG END]---
         // 获取指明的数组维度
         int set_dims = 0;
         // 遍历进行指针寻址
@@ -780,10 +761,10 @@ Result LValAST::print() const {
             // 指针是强类型的，后加 index 会在实际计算时自动乘以当前指针对应类型的步长
             // 特判首次寻址，加 @ 符号
             if (i == 0) {
-                koopa_ofs << "\t" << NEW_REG_ << " = getelemptr @" << ident_with_suffix << ", " << indices[i] << endl;
+                ir_builder.get_elem_ptr(NEW_REG_, "@" + ident_with_suffix, indices[i]);
             }
             else {
-                koopa_ofs << "\t" << NEW_REG_ << " = getelemptr " << prev_reg << ", " << indices[i] << endl;
+                ir_builder.get_elem_ptr(NEW_REG_, prev_reg, indices[i]);
             }
         }
         auto prev_reg = CUR_REG_;
@@ -797,7 +778,7 @@ Result LValAST::print() const {
             %1 = getelemptr %0, 3
             %2 = load %1
              */
-            koopa_ofs << "\t" << NEW_REG_ << " = load " << prev_reg << endl;
+            ir_builder.load(NEW_REG_, prev_reg);
         }
         // 其他情况，都表明这是加载一个指针，然后要用做函数参数传递
         // 此时，应当生成一条 %1 = getelemptr %0, 0 的指令
@@ -810,7 +791,7 @@ Result LValAST::print() const {
             准备 arr 作为 f2d 参数时，应当翻译为
             %0 = getelemptr @arr, 0
              */
-            koopa_ofs << "\t" << NEW_REG_ << " = getelemptr @" << ident_with_suffix << ", 0" << endl;
+            ir_builder.get_elem_ptr(NEW_REG_, "@" + ident_with_suffix, IMM_(0));
         }
         // 其他情况表示我们就是要得到一个指针，直接使用 getelemptr 指令就行
         else {
@@ -821,7 +802,7 @@ Result LValAST::print() const {
             %0 = getelemptr @arr, 1
             %1 = getelemptr %0, 0
              */
-            koopa_ofs << "\t" << NEW_REG_ << " = getelemptr " << prev_reg << ", 0" << endl;
+            ir_builder.get_elem_ptr(NEW_REG_, prev_reg, IMM_(0));
         }
         return CUR_REG_;
     }
@@ -834,31 +815,31 @@ Result LValAST::print() const {
         }
         // 获取指明的数组维度
         int set_dims = 0;
-        // 先 load 出基指针
-        koopa_ofs << "\t" << NEW_REG_ << " = load @" << ident_with_suffix << endl;
+        // 基指针就是参数本身
+        ir_builder.alias(NEW_REG_, "@" + ident.str());
         // 遍历进行指针寻址
         for (int i = 0;i < indices.size();i++) {
             set_dims += 1;
             auto prev_reg = CUR_REG_;
             // 对指针进行首次寻址，使用 getptr 指令
             if (i == 0) {
-                koopa_ofs << "\t" << NEW_REG_ << " = getptr " << prev_reg << ", " << indices[i] << endl;
+                ir_builder.get_ptr(NEW_REG_, prev_reg, indices[i]);
             }
             // 对指针进行后续寻址，使用 getelemptr 指令
             else {
-                koopa_ofs << "\t" << NEW_REG_ << " = getelemptr " << prev_reg << ", " << indices[i] << endl;
+                ir_builder.get_elem_ptr(NEW_REG_, prev_reg, indices[i]);
             }
         }
         auto prev_reg = CUR_REG_;
         // 如果指明的数组维度与实际数组维度相同，则表明这是加载一个数组元素，使用 load 指令来解引用
         if (set_dims == symbol.value) {
-            koopa_ofs << "\t" << NEW_REG_ << " = load " << prev_reg << endl;
+            ir_builder.load(NEW_REG_, prev_reg);
         }
         // 其他情况表示我们就是要得到一个指针，直接使用 getelemptr 指令就行
         else if (set_dims != 0) {
-            koopa_ofs << "\t" << NEW_REG_ << " = getelemptr " << prev_reg << ", 0" << endl;
+            ir_builder.get_elem_ptr(NEW_REG_, prev_reg, IMM_(0));
         }
-        // 对于完全没指定的情况，前面最开始使用的 load 指令就是结果了
+        // 对于完全没指定的情况，参数本身就是结果
         return CUR_REG_;
     }
     else {
@@ -912,7 +893,7 @@ Result LExpWithOpAST::print() const {
                 }
                 else {
                     // 生成一条 ne 0 指令，相当于 rhs != 0，得到布尔值
-                    koopa_ofs << "\t" << NEW_REG_ << " = ne " << rhs << ", 0" << endl;
+                    ir_builder.binary(NEW_REG_, BinaryOp::NOT_EQ, rhs, IMM_(0));
                     return CUR_REG_;
                 }
             }
@@ -925,30 +906,30 @@ Result LExpWithOpAST::print() const {
         environment_manager.add_short_circuit_count();
 
         // 生成 alloc 指令
-        koopa_ofs << "\t" << result << " = alloc i32" << endl;
+        ir_builder.alloc(result, ir_builder.int_type());
         environment_manager.is_symbol_allocated[result] = true;
 
         // 生成 br 指令
-        koopa_ofs << "\tbr " << lhs << ", " << true_label << ", " << false_label << endl;
+        ir_builder.branch(lhs, true_label, false_label);
 
         // 生成 true 分支
-        koopa_ofs << true_label << ":" << endl;
-        koopa_ofs << "\t" << "store 1, " << result << endl;
-        koopa_ofs << "\tjump " << end_label << endl;
+        ir_builder.label(true_label);
+        ir_builder.store(IMM_(1), result);
+        ir_builder.jump(end_label);
 
         // 生成 false 分支
-        koopa_ofs << false_label << ":" << endl;
+        ir_builder.label(false_label);
         Result rhs = right->print();
         Result temp = NEW_REG_;
         // 生成一条 ne 0 指令，相当于 rhs != 0，得到布尔值
-        koopa_ofs << "\t" << temp << " = ne " << rhs << ", 0" << endl;
-        koopa_ofs << "\t" << "store " << temp << ", " << result << endl;
-        koopa_ofs << "\tjump " << end_label << endl;
+        ir_builder.binary(temp, BinaryOp::NOT_EQ, rhs, IMM_(0));
+        ir_builder.store(temp, result);
+        ir_builder.jump(end_label);
 
         // 生成 end 标签
-        koopa_ofs << end_label << ":" << endl;
+        ir_builder.label(end_label);
         Result result_reg = NEW_REG_;
-        koopa_ofs << "\t" << result_reg << " = load " << result << endl;
+        ir_builder.load(result_reg, result);
 
         return result_reg;
     }
@@ -966,7 +947,7 @@ Result LExpWithOpAST::print() const {
                 }
                 else {
                     // 生成一条 ne 0 指令，相当于 rhs != 0，得到布尔值
-                    koopa_ofs << "\t" << NEW_REG_ << " = ne " << rhs << ", 0" << endl;
+                    ir_builder.binary(NEW_REG_, BinaryOp::NOT_EQ, rhs, IMM_(0));
                     return CUR_REG_;
                 }
             }
@@ -979,30 +960,30 @@ Result LExpWithOpAST::print() const {
         environment_manager.add_short_circuit_count();
 
         // 生成 alloc 指令
-        koopa_ofs << "\t" << result << " = alloc i32" << endl;
+        ir_builder.alloc(result, ir_builder.int_type());
         environment_manager.is_symbol_allocated[result] = true;
 
         // 生成 br 指令
-        koopa_ofs << "\tbr " << lhs << ", " << true_label << ", " << false_label << endl;
+        ir_builder.branch(lhs, true_label, false_label);
 
         // 生成 false 分支
-        koopa_ofs << false_label << ":" << endl;
-        koopa_ofs << "\t" << "store 0, " << result << endl;
-        koopa_ofs << "\tjump " << end_label << endl;
+        ir_builder.label(false_label);
+        ir_builder.store(IMM_(0), result);
+        ir_builder.jump(end_label);
 
         // 生成 true 分支
-        koopa_ofs << true_label << ":" << endl;
+        ir_builder.label(true_label);
         Result rhs = right->print();
         Result temp = NEW_REG_;
         // 生成一条 ne 0 指令，相当于 rhs != 0，得到布尔值
-        koopa_ofs << "\t" << temp << " = ne " << rhs << ", 0" << endl;
-        koopa_ofs << "\t" << "store " << temp << ", " << result << endl;
-        koopa_ofs << "\tjump " << end_label << endl;
+        ir_builder.binary(temp, BinaryOp::NOT_EQ, rhs, IMM_(0));
+        ir_builder.store(temp, result);
+        ir_builder.jump(end_label);
 
         // 生成 end 标签
-        koopa_ofs << end_label << ":" << endl;
+        ir_builder.label(end_label);
         Result result_reg = NEW_REG_;
-        koopa_ofs << "\t" << result_reg << " = load " << result << endl;
+        ir_builder.load(result_reg, result);
 
         return result_reg;
     }
@@ -1016,14 +997,15 @@ Result LExpWithOpAST::print() const {
  * @param[in] op 等式运算符
  * @return 等式运算符枚举类型
  */
-EqExpWithOpAST::EqOp EqExpWithOpAST::convert(const string& op) const {
-    if (op == "==") {
+EqExpWithOpAST::EqOp EqExpWithOpAST::convert(Operator op) const {
+    switch (op) {
+    case Operator::EQ:
         return EqOp::EQ;
-    }
-    else if (op == "!=") {
+    case Operator::NEQ:
         return EqOp::NEQ;
+    default:
+        throw runtime_error("Invalid operator");
     }
-    throw runtime_error("Invalid operator: " + op);
 }
 
 /**
@@ -1057,10 +1039,10 @@ Result EqExpWithOpAST::print() const {
         Result result = NEW_REG_;
         switch (eq_op) {
         case EqOp::EQ:
-            koopa_ofs << "\t" << result << " = eq " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::EQ, lhs, rhs);
             break;
         case EqOp::NEQ:
-            koopa_ofs << "\t" << result << " = ne " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::NOT_EQ, lhs, rhs);
             break;
         default:
             assert(false);
@@ -1081,20 +1063,19 @@ Result RelExpAST::print() const {
  * @param[in] op 关系运算符
  * @return 关系运算符枚举类型
  */
-RelExpWithOpAST::RelOp RelExpWithOpAST::convert(const string& op) const {
-    if (op == "<=") {
+RelExpWithOpAST::RelOp RelExpWithOpAST::convert(Operator op) const {
+    switch (op) {
+    case Operator::LE:
         return RelOp::LE;
-    }
-    else if (op == ">=") {
+    case Operator::GE:
         return RelOp::GE;
-    }
-    else if (op == "<") {
+    case Operator::LT:
         return RelOp::LT;
-    }
-    else if (op == ">") {
+    case Operator::GT:
         return RelOp::GT;
+    default:
+        throw runtime_error("Invalid operator");
     }
-    throw runtime_error("Invalid operator: " + op);
 }
 
 /**
@@ -1125,16 +1106,16 @@ Result RelExpWithOpAST::print() const {
         Result result = NEW_REG_;
         switch (rel_op) {
         case RelOp::LE:
-            koopa_ofs << "\t" << result << " = le " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::LE, lhs, rhs);
             break;
         case RelOp::GE:
-            koopa_ofs << "\t" << result << " = ge " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::GE, lhs, rhs);
             break;
         case RelOp::LT:
-            koopa_ofs << "\t" << result << " = lt " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::LT, lhs, rhs);
             break;
         case RelOp::GT:
-            koopa_ofs << "\t" << result << " = gt " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::GT, lhs, rhs);
             break;
         default:
             assert(false);
@@ -1155,14 +1136,15 @@ Result AddExpAST::print() const {
  * @param[in] op 加法运算符
  * @return 加法运算符枚举类型
  */
-AddExpWithOpAST::AddOp AddExpWithOpAST::convert(const string& op) const {
-    if (op == "+") {
+AddExpWithOpAST::AddOp AddExpWithOpAST::convert(Operator op) const {
+    switch (op) {
+    case Operator::ADD:
         return AddOp::ADD;
-    }
-    else if (op == "-") {
+    case Operator::SUB:
         return AddOp::SUB;
+    default:
+        throw runtime_error("Invalid operator");
     }
-    throw runtime_error("Invalid operator: " + op);
 }
 
 /**
@@ -1189,10 +1171,10 @@ Result AddExpWithOpAST::print() const {
         Result result = NEW_REG_;
         switch (add_op) {
         case AddOp::ADD:
-            koopa_ofs << "\t" << result << " = add " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::ADD, lhs, rhs);
             break;
         case AddOp::SUB:
-            koopa_ofs << "\t" << result << " = sub " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::SUB, lhs, rhs);
             break;
         default:
             assert(false);
@@ -1213,17 +1195,17 @@ Result MulExpAST::print() const {
  * @param[in] op 乘法运算符
  * @return 乘法运算符枚举类型
  */
-MulExpWithOpAST::MulOp MulExpWithOpAST::convert(const string& op) const {
-    if (op == "*") {
+MulExpWithOpAST::MulOp MulExpWithOpAST::convert(Operator op) const {
+    switch (op) {
+    case Operator::MUL:
         return MulOp::MUL;
-    }
-    else if (op == "/") {
+    case Operator::DIV:
         return MulOp::DIV;
-    }
-    else if (op == "%") {
+    case Operator::MOD:
         return MulOp::MOD;
+    default:
+        throw runtime_error("Invalid operator");
     }
-    throw runtime_error("Invalid operator: " + op);
 }
 
 /**
@@ -1252,13 +1234,13 @@ Result MulExpWithOpAST::print() const {
         Result result = NEW_REG_;
         switch (mul_op) {
         case MulOp::MUL:
-            koopa_ofs << "\t" << result << " = mul " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::MUL, lhs, rhs);
             break;
         case MulOp::DIV:
-            koopa_ofs << "\t" << result << " = div " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::DIV, lhs, rhs);
             break;
         case MulOp::MOD:
-            koopa_ofs << "\t" << result << " = mod " << lhs << ", " << rhs << endl;
+            ir_builder.binary(result, BinaryOp::MOD, lhs, rhs);
             break;
         default:
             assert(false);
@@ -1279,17 +1261,17 @@ Result UnaryExpAST::print() const {
  * @param[in] op 一元运算符
  * @return 一元运算符枚举类型
  */
-UnaryExpWithOpAST::UnaryOp UnaryExpWithOpAST::convert(const string& op) const {
-    if (op == "+") {
+UnaryExpWithOpAST::UnaryOp UnaryExpWithOpAST::convert(Operator op) const {
+    switch (op) {
+    case Operator::ADD:
         return UnaryOp::POSITIVE;
-    }
-    else if (op == "-") {
+    case Operator::SUB:
         return UnaryOp::NEGATIVE;
-    }
-    else if (op == "!") {
+    case Operator::NOT:
         return UnaryOp::NOT;
+    default:
+        throw runtime_error("Invalid operator");
     }
-    throw runtime_error("Invalid operator: " + op);
 }
 
 /**
@@ -1317,13 +1299,13 @@ Result UnaryExpWithOpAST::print() const {
         Result result = NEW_REG_;
         switch (unary_op) {
         case UnaryOp::POSITIVE:
-            koopa_ofs << "\t" << result << " = add 0, " << unary_exp_result << endl;
+            ir_builder.binary(result, BinaryOp::ADD, IMM_(0), unary_exp_result);
             break;
         case UnaryOp::NEGATIVE:
-            koopa_ofs << "\t" << result << " = sub 0, " << unary_exp_result << endl;
+            ir_builder.binary(result, BinaryOp::SUB, IMM_(0), unary_exp_result);
             break;
         case UnaryOp::NOT:
-            koopa_ofs << "\t" << result << " = eq 0, " << unary_exp_result << endl;
+            ir_builder.binary(result, BinaryOp::EQ, IMM_(0), unary_exp_result);
             break;
         default:
             assert(false);
@@ -1345,26 +1327,12 @@ Result UnaryExpWithFuncCallAST::print() const {
     // 若函数有返回值，则使用临时变量存储结果
     if (environment_manager.is_func_return[ident]) {
         Result result = NEW_REG_;
-        koopa_ofs << "\t" << result << " = call @" << ident << "(";
-        for (size_t i = 0; i < params.size(); i++) {
-            koopa_ofs << params[i];
-            if (i != params.size() - 1) {
-                koopa_ofs << ", ";
-            }
-        }
-        koopa_ofs << ")" << endl;
+        ir_builder.call(result, "@" + ident.str(), params);
         return result;
     }
     // 若函数无返回值，则直接调用函数
     else {
-        koopa_ofs << "\tcall @" << ident << "(";
-        for (size_t i = 0; i < params.size(); i++) {
-            koopa_ofs << params[i];
-            if (i != params.size() - 1) {
-                koopa_ofs << ", ";
-            }
-        }
-        koopa_ofs << ")" << endl;
+        ir_builder.call("@" + ident.str(), params);
         return Result();
     }
 }
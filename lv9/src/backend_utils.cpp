@@ -1,29 +1,13 @@
 #include "include/backend_utils.hpp"
 
 /**
- * @brief 解析 KoopaIR 字符串，生成 Riscv 汇编代码
- * @param[in] koopa_ir KoopaIR 字符串
+ * @brief 由 IR 生成 Riscv 汇编代码
+ * @param[in] program 前端构建的 IR
  */
-void parse_riscv(const char* koopa_ir) {
-    // 解析字符串 str, 得到 Koopa IR 程序
-    koopa_program_t program;
-    koopa_error_code_t ret = koopa_parse_from_string(koopa_ir, &program);
-    // 确保解析时没有出错
-    assert(ret == KOOPA_EC_SUCCESS);
-    // 创建一个 raw program builder, 用来构建 raw program
-    koopa_raw_program_builder_t builder = koopa_new_raw_program_builder();
-    // 将 Koopa IR 程序转换为 raw program
-    koopa_raw_program_t raw = koopa_build_raw_program(builder, program);
-    // 释放 Koopa IR 程序占用的内存
-    koopa_delete_program(program);
-
-    // 处理 raw program
-    visit(raw);
-
-    // 处理完成, 释放 raw program builder 占用的内存
-    // 注意, raw program 中所有的指针指向的内存均为 raw program builder 的内存
-    // 所以不要在 raw program 处理完毕之前释放 builder
-    koopa_delete_raw_program_builder(builder);
+void generate_riscv(const Program& program) {
+    // 处理 IR
+    // IR 由前端的 IRBuilder 直接在内存中构建，无需再解析 Koopa IR 文本
+    visit(program);
 }
 
 /**
@@ -32,30 +16,26 @@ void parse_riscv(const char* koopa_ir) {
  * @return 是否为 2 的幂次，若为 2 的幂次则返回幂次，否则返回 -1
  */
 int is_power_of_two(int x) {
-    if (x <= 0) {
-        return -1;
-    }
-    double logResult = log2(x);
-    if (floor(logResult) == logResult) {
-        return static_cast<int>(logResult);
-    }
-    else {
+    if (x <= 0 || (x & (x - 1)) != 0) {
         return -1;
     }
+    return __builtin_ctz(x);
 }
 
 /**
- * @brief 生成 .data 宏
+ * @brief 判断立即数是否能放进 I 型指令的 12 位有符号立即数字段
+ * @param[in] imm 立即数
+ * @return 是否在 [-2048, 2048) 范围内
  */
-void Riscv::_data() {
-    riscv_ofs << "\t.data" << endl;
+bool is_imm12(int imm) {
+    return imm >= -2048 && imm < 2048;
 }
 
 /**
- * @brief 生成 .text 宏
+ * @brief 生成 .data 宏
  */
-void Riscv::_text() {
-    riscv_ofs << "\t.text" << endl;
+void Riscv::_data() {
+    riscv_ofs << "\t.data" << '\n';
 }
 
 /**
@@ -63,7 +43,7 @@ void Riscv::_text() {
  * @param[in] name 全局变量名
  */
 void Riscv::_globl(const string& name) {
-    riscv_ofs << "\t.globl " << name << endl;
+    riscv_ofs << "\t.globl " << name << '\n';
 }
 
 /**
@@ -71,7 +51,7 @@ void Riscv::_globl(const string& name) {
  * @param[in] value 要存储的值
  */
 void Riscv::_word(const int& value) {
-    riscv_ofs << "\t.word " << value << endl;
+    riscv_ofs << "\t.word " << value << '\n';
 }
 
 /**
@@ -79,30 +59,69 @@ void Riscv::_word(const int& value) {
  * @param[in] len 要填充的 0 的个数
  */
 void Riscv::_zero(const int& len) {
-    riscv_ofs << "\t.zero " << len << endl;
+    riscv_ofs << "\t.zero " << len << '\n';
 }
 
 /**
- * @brief 生成 label 标签，即 `name:`
+ * @brief 生成数据段的 label 标签，即 `name:`
  * @param[in] name 标签名
  */
 void Riscv::_label(const string& name) {
-    riscv_ofs << name << ":" << endl;
+    riscv_ofs << name << ":" << '\n';
+}
+
+/**
+ * @brief 开始翻译函数，之后生成的指令都追加到该函数的机器指令列表中
+ * @param[in] func 函数
+ * @note 基本块的标号编号与基本块的编号相同
+ */
+void Riscv::begin_function(const Function* func) {
+    // 忽略函数名前的@，@main -> main
+    this->func.reset(func->name + 1, func->block_count);
+    for (auto bb : func->bbs) {
+        this->func.labels[bb->id] = bb->name + 1;
+    }
+}
+
+/**
+ * @brief 结束翻译函数，整理跳转后输出该函数的全部机器指令
+ */
+void Riscv::end_function() {
+    func.remove_fallthrough_jumps();
+    func.relax_branches();
+    func.print(riscv_ofs);
+}
+
+/**
+ * @brief 获取基本块的标号
+ * @param[in] bb 基本块
+ * @return 标号编号
+ */
+int Riscv::block_label(const BasicBlock* bb) {
+    return bb->id;
+}
+
+/**
+ * @brief 生成代码段的 label 标签，即 `name:`
+ * @param[in] label 标号编号
+ */
+void Riscv::_label(int label) {
+    func.instrs.emplace_back(Opcode::LABEL).label = label;
 }
 
 /**
  * @brief 生成 call ident 指令
  * @param[in] ident 函数名
  */
-void Riscv::_call(const string& ident) {
-    riscv_ofs << "\tcall " << ident << endl;
+void Riscv::_call(const char* ident) {
+    func.instrs.emplace_back(Opcode::CALL).symbol = ident;
 }
 
 /**
  * @brief 生成 ret 指令
  */
 void Riscv::_ret() {
-    riscv_ofs << "\tret" << endl;
+    func.instrs.emplace_back(Opcode::RET);
 }
 
 /**
@@ -110,8 +129,8 @@ void Riscv::_ret() {
  * @param[in] rd 目标寄存器
  * @param[in] rs1 源寄存器
  */
-void Riscv::_seqz(const string& rd, const string& rs1) {
-    riscv_ofs << "\tseqz " << rd << ", " << rs1 << endl;
+void Riscv::_seqz(Reg rd, Reg rs1) {
+    func.instrs.emplace_back(Opcode::SEQZ, rd, rs1);
 }
 
 /**
@@ -119,8 +138,8 @@ void Riscv::_seqz(const string& rd, const string& rs1) {
  * @param[in] rd 目标寄存器
  * @param[in] rs1 源寄存器
  */
-void Riscv::_snez(const string& rd, const string& rs1) {
-    riscv_ofs << "\tsnez " << rd << ", " << rs1 << endl;
+void Riscv::_snez(Reg rd, Reg rs1) {
+    func.instrs.emplace_back(Opcode::SNEZ, rd, rs1);
 }
 
 /**
@@ -129,8 +148,8 @@ void Riscv::_snez(const string& rd, const string& rs1) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_or(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tor " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_or(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::OR, rd, rs1, rs2);
 }
 
 /**
@@ -139,8 +158,8 @@ void Riscv::_or(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_and(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tand " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_and(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::AND, rd, rs1, rs2);
 }
 
 /**
@@ -149,8 +168,8 @@ void Riscv::_and(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_xor(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\txor " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_xor(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::XOR, rd, rs1, rs2);
 }
 
 /**
@@ -159,46 +178,38 @@ void Riscv::_xor(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_add(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tadd " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_add(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::ADD, rd, rs1, rs2);
 }
 
 /**
- * @brief 生成 addi 指令，即 rd = rs1 + imm，会自动处理 12 位立即数限制
+ * @brief 生成 sub 指令，即 rd = rs1 - rs2
  * @param[in] rd 目标寄存器
- * @param[in] rs1 源寄存器
- * @param[in] imm 立即数
- * @note 如果 imm 超过 12 位立即数限制，则会先将其存入一个临时寄存器，再进行加法运算
+ * @param[in] rs1 源寄存器 1
+ * @param[in] rs2 源寄存器 2
  */
-void Riscv::_addi(const string& rd, const string& rs1, const int& imm) {
-    if (imm >= -2048 && imm < 2048) {
-        riscv_ofs << "\taddi " << rd << ", " << rs1 << ", " << imm << endl;
-    }
-    else {
-        auto reg = register_manager.tmp_reg();
-        _li(reg, imm);
-        _add(rd, rs1, reg);
-    }
+void Riscv::_sub(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::SUB, rd, rs1, rs2);
 }
 
 /**
- * @brief 生成 sub 指令，即 rd = rs1 - rs2
+ * @brief 生成 mul 指令，即 rd = rs1 * rs2
  * @param[in] rd 目标寄存器
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_sub(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tsub " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_mul(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::MUL, rd, rs1, rs2);
 }
 
 /**
- * @brief 生成 mul 指令，即 rd = rs1 * rs2
+ * @brief 生成 mulh 指令，即 rd = (rs1 * rs2) >> 32，取有符号 64 位乘积的高 32 位
  * @param[in] rd 目标寄存器
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_mul(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tmul " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_mulh(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::MULH, rd, rs1, rs2);
 }
 
 /**
@@ -207,8 +218,8 @@ void Riscv::_mul(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_div(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tdiv " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_div(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::DIV, rd, rs1, rs2);
 }
 
 /**
@@ -217,8 +228,8 @@ void Riscv::_div(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_rem(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\trem " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_rem(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::REM, rd, rs1, rs2);
 }
 
 /**
@@ -227,8 +238,8 @@ void Riscv::_rem(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_sgt(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tsgt " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_sgt(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::SGT, rd, rs1, rs2);
 }
 
 /**
@@ -237,8 +248,8 @@ void Riscv::_sgt(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_slt(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tslt " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_slt(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::SLT, rd, rs1, rs2);
 }
 
 /**
@@ -247,8 +258,404 @@ void Riscv::_slt(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rs1 源寄存器 1
  * @param[in] rs2 源寄存器 2
  */
-void Riscv::_sll(const string& rd, const string& rs1, const string& rs2) {
-    riscv_ofs << "\tsll " << rd << ", " << rs1 << ", " << rs2 << endl;
+void Riscv::_sll(Reg rd, Reg rs1, Reg rs2) {
+    func.instrs.emplace_back(Opcode::SLL, rd, rs1, rs2);
+}
+
+/**
+ * @brief 生成 addi 指令，即 rd = rs1 + imm，会自动处理 12 位立即数限制
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] imm 立即数
+ * @note 如果 imm 超过 12 位立即数限制，则会先将其存入一个临时寄存器，再进行加法运算
+ */
+void Riscv::_addi(Reg rd, Reg rs1, const int& imm) {
+    if (is_imm12(imm)) {
+        func.instrs.emplace_back(Opcode::ADDI, rd, rs1, NO_REG, imm);
+    }
+    else {
+        auto reg = register_manager.tmp_reg();
+        _li(reg, imm);
+        _add(rd, rs1, reg);
+    }
+}
+
+/**
+ * @brief 生成 andi 指令，即 rd = rs1 & imm
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] imm 立即数，须在 12 位立即数范围内
+ */
+void Riscv::_andi(Reg rd, Reg rs1, const int& imm) {
+    assert(is_imm12(imm));
+    func.instrs.emplace_back(Opcode::ANDI, rd, rs1, NO_REG, imm);
+}
+
+/**
+ * @brief 生成 ori 指令，即 rd = rs1 | imm
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] imm 立即数，须在 12 位立即数范围内
+ */
+void Riscv::_ori(Reg rd, Reg rs1, const int& imm) {
+    assert(is_imm12(imm));
+    func.instrs.emplace_back(Opcode::ORI, rd, rs1, NO_REG, imm);
+}
+
+/**
+ * @brief 生成 xori 指令，即 rd = rs1 ^ imm
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] imm 立即数，须在 12 位立即数范围内
+ */
+void Riscv::_xori(Reg rd, Reg rs1, const int& imm) {
+    assert(is_imm12(imm));
+    func.instrs.emplace_back(Opcode::XORI, rd, rs1, NO_REG, imm);
+}
+
+/**
+ * @brief 生成 slti 指令，即 rd = rs1 < imm
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] imm 立即数，须在 12 位立即数范围内
+ */
+void Riscv::_slti(Reg rd, Reg rs1, const int& imm) {
+    assert(is_imm12(imm));
+    func.instrs.emplace_back(Opcode::SLTI, rd, rs1, NO_REG, imm);
+}
+
+/**
+ * @brief 生成 slli（立即数左移）指令，即 rd = rs1 << shamt
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] shamt 移位量，0 ~ 31
+ */
+void Riscv::_slli(Reg rd, Reg rs1, const int& shamt) {
+    assert(shamt >= 0 && shamt < 32);
+    func.instrs.emplace_back(Opcode::SLLI, rd, rs1, NO_REG, shamt);
+}
+
+/**
+ * @brief 生成 srli（立即数逻辑右移）指令，即 rd = rs1 >> shamt，高位补 0
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] shamt 移位量，0 ~ 31
+ */
+void Riscv::_srli(Reg rd, Reg rs1, const int& shamt) {
+    assert(shamt >= 0 && shamt < 32);
+    func.instrs.emplace_back(Opcode::SRLI, rd, rs1, NO_REG, shamt);
+}
+
+/**
+ * @brief 生成 srai（立即数算术右移）指令，即 rd = rs1 >> shamt，高位补符号位
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] shamt 移位量，0 ~ 31
+ */
+void Riscv::_srai(Reg rd, Reg rs1, const int& shamt) {
+    assert(shamt >= 0 && shamt < 32);
+    func.instrs.emplace_back(Opcode::SRAI, rd, rs1, NO_REG, shamt);
+}
+
+/**
+ * @brief 乘正常数 c 的移位加减序列，按最后一步递归描述
+ * @note - `cost`：序列的指令条数
+ * @note - `kind`：最后一步，`SHIFT` 为把乘 c >> shamt 的结果左移 shamt 位，`ADD` / `SUB` 为乘 c - 1 / c + 1 的结果加减被乘数，
+ *         `FACTOR` 为先乘因子 2^shamt ± 1（`minus` 表示减），再把结果乘剩下的 c / (2^shamt ± 1)
+ */
+class MulPlan {
+public:
+    enum class Kind { ONE, SHIFT, ADD, SUB, FACTOR };
+    int cost = 0;
+    Kind kind = Kind::ONE;
+    int shamt = 0;
+    bool minus = false;
+};
+
+/**
+ * @brief 求乘正常数 c 的最短移位加减序列，结果按 c 缓存
+ * @param[in] c 乘数，1 ~ 2^31
+ * @param[in] allow_factor 是否允许分解出 2^k ± 1 的因子，分解需要多用一个临时寄存器，因此只允许一次
+ * @return 序列的最后一步
+ */
+static MulPlan plan_mul(long long c, bool allow_factor) {
+    static unordered_map<long long, MulPlan> plans;
+    if (c == 1) {
+        return MulPlan();
+    }
+    auto key = c * 2 + allow_factor;
+    if (auto it = plans.find(key); it != plans.end()) {
+        return it->second;
+    }
+    MulPlan best;
+    if (c % 2 == 0) {
+        best.shamt = __builtin_ctzll(c);
+        best.kind = MulPlan::Kind::SHIFT;
+        best.cost = plan_mul(c >> best.shamt, allow_factor).cost + 1;
+    }
+    else {
+        best.kind = MulPlan::Kind::ADD;
+        best.cost = plan_mul(c - 1, allow_factor).cost + 1;
+        if (auto cost = plan_mul(c + 1, allow_factor).cost + 1; cost < best.cost) {
+            best.kind = MulPlan::Kind::SUB;
+            best.cost = cost;
+        }
+        // 2^k + 1 与 2^k - 1 形式的因子，如 45 = 5 * 9
+        for (int k = 1; allow_factor && (1ll << k) - 1 < c; k++) {
+            for (bool minus : { false, true }) {
+                auto factor = minus ? (1ll << k) - 1 : (1ll << k) + 1;
+                if (factor < 3 || factor >= c || c % factor != 0) {
+                    continue;
+                }
+                auto cost = plan_mul(c / factor, false).cost + 2;
+                if (cost < best.cost) {
+                    best.kind = MulPlan::Kind::FACTOR;
+                    best.cost = cost;
+                    best.shamt = k;
+                    best.minus = minus;
+                }
+            }
+        }
+    }
+    plans[key] = best;
+    return best;
+}
+
+/**
+ * @brief 按移位加减序列计算 rd = rs1 * c
+ * @param[in] rd 目标寄存器，除非 c 为 2 的幂次，否则不能与 rs1 相同
+ * @param[in] rs1 被乘数所在的寄存器
+ * @param[in] c 乘数，1 ~ 2^31
+ * @param[in] allow_factor 是否允许分解出因子，与求序列时一致
+ */
+void Riscv::mul_sequence(Reg rd, Reg rs1, long long c, bool allow_factor) {
+    auto plan = plan_mul(c, allow_factor);
+    switch (plan.kind) {
+    case MulPlan::Kind::ONE:
+        if (rd != rs1) {
+            _mv(rd, rs1);
+        }
+        break;
+    case MulPlan::Kind::SHIFT:
+        if ((c >> plan.shamt) == 1) {
+            _slli(rd, rs1, plan.shamt);
+        }
+        else {
+            mul_sequence(rd, rs1, c >> plan.shamt, allow_factor);
+            _slli(rd, rd, plan.shamt);
+        }
+        break;
+    case MulPlan::Kind::ADD:
+        mul_sequence(rd, rs1, c - 1, allow_factor);
+        _add(rd, rd, rs1);
+        break;
+    case MulPlan::Kind::SUB:
+        mul_sequence(rd, rs1, c + 1, allow_factor);
+        _sub(rd, rd, rs1);
+        break;
+    case MulPlan::Kind::FACTOR: {
+        // 先在另一个寄存器中乘因子，再以其为被乘数乘剩下的部分
+        auto factor = plan.minus ? (1ll << plan.shamt) - 1 : (1ll << plan.shamt) + 1;
+        auto reg = register_manager.new_reg();
+        _slli(reg, rs1, plan.shamt);
+        if (plan.minus) {
+            _sub(reg, reg, rs1);
+        }
+        else {
+            _add(reg, reg, rs1);
+        }
+        mul_sequence(rd, reg, c / factor, false);
+        break;
+    }
+    }
+}
+
+/**
+ * @brief 生成乘常数的指令，即 rd = rs1 * imm，移位加减序列比 li 加 mul 更快时改用序列
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] imm 乘数
+ * @param[in] allow_temp 是否允许额外占用临时寄存器，不允许时只使用 rd 计算
+ * @note - 序列的代价为指令条数，mul 的代价为 `mul_latency` 加上 li 的指令条数
+ * @note - 负数先乘绝对值再取反；rd 与 rs1 相同时序列需要先算到另一个寄存器中
+ */
+void Riscv::_muli(Reg rd, Reg rs1, const int& imm, bool allow_temp) {
+    long long c = imm;
+    bool negative = c < 0;
+    if (negative) {
+        c = -c;
+    }
+    if (c == 0) {
+        _li(rd, 0);
+        return;
+    }
+    // 乘 2 的幂次只需一条 slli，可以原地计算
+    bool need_copy = rd == rs1 && (c & (c - 1)) != 0;
+    int cost = plan_mul(c, allow_temp).cost + (negative || need_copy);
+    int mul_cost = mul_latency + (is_imm12(imm) ? 1 : 2);
+    if (cost < mul_cost && (allow_temp || !need_copy)) {
+        auto target = need_copy ? register_manager.new_reg() : rd;
+        mul_sequence(target, rs1, c, allow_temp);
+        if (negative) {
+            _sub(rd, X0, target);
+        }
+        else if (target != rd) {
+            _mv(rd, target);
+        }
+        return;
+    }
+    auto reg = register_manager.tmp_reg();
+    _li(reg, imm);
+    _mul(rd, rs1, reg);
+}
+
+/**
+ * @brief 求有符号除以常数 d 的魔数与移位量（Granlund–Montgomery），使 n / d = (mulh(n, magic) [+ n]) >> shift，再对负数加 1
+ * @param[in] d 除数，2 ~ 2^31 - 1，且不是 2 的幂次
+ * @return 魔数与移位量，魔数按有符号数为负时需要再加上被除数
+ * @note 参见 Hacker's Delight 第 10 章
+ */
+static pair<int, int> div_magic(int d) {
+    const uint32_t two31 = 0x80000000u;
+    uint32_t ad = d;
+    uint32_t anc = two31 - 1 - two31 % ad;
+    int p = 31;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+    uint32_t delta;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    return { static_cast<int>(q2 + 1), p - 32 };
+}
+
+/**
+ * @brief 计算 rs1 除以正常数 d 向零取整的商，被除数保持不变
+ * @param[in] q 存放商的寄存器，不能与 rs1 相同
+ * @param[in] rs1 被除数所在的寄存器
+ * @param[in] d 除数，2 ~ 2^30 之间
+ * @param[in] tmp 除数不是 2 的幂次时存放魔数的临时寄存器
+ * @note - 2 的幂次 2^k：负数先加上 2^k - 1 再算术右移，偏置由符号位逻辑右移得到
+ * @note - 其他除数：mulh 乘魔数取高位，必要时加上被除数，算术右移后对负数加 1
+ */
+void Riscv::div_quotient(Reg q, Reg rs1, int d, Reg tmp) {
+    auto power = is_power_of_two(d);
+    if (power != -1) {
+        if (power == 1) {
+            _srli(q, rs1, 31);
+        }
+        else {
+            _srai(q, rs1, 31);
+            _srli(q, q, 32 - power);
+        }
+        _add(q, q, rs1);
+        _srai(q, q, power);
+        return;
+    }
+    auto [magic, shift] = div_magic(d);
+    _li(tmp, magic);
+    _mulh(q, rs1, tmp);
+    if (magic < 0) {
+        _add(q, q, rs1);
+    }
+    if (shift > 0) {
+        _srai(q, q, shift);
+    }
+    _srli(tmp, rs1, 31);
+    _add(q, q, tmp);
+}
+
+/**
+ * @brief 生成除以常数的指令，即 rd = rs1 / imm，向零取整，避免使用很慢的 div
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] imm 除数
+ * @note - 负的除数先除以绝对值再取反；除以 ±1 为 mv 与取反
+ * @note - 除以 0 与 -2^31 仍然使用 div
+ */
+void Riscv::_divi(Reg rd, Reg rs1, const int& imm) {
+    if (imm == 0 || imm == INT32_MIN) {
+        auto reg = register_manager.tmp_reg();
+        _li(reg, imm);
+        _div(rd, rs1, reg);
+        return;
+    }
+    int d = imm < 0 ? -imm : imm;
+    auto q = rs1;
+    if (d != 1) {
+        q = rd != rs1 ? rd : register_manager.new_reg();
+        div_quotient(q, rs1, d, is_power_of_two(d) == -1 ? register_manager.new_reg() : NO_REG);
+    }
+    if (imm < 0) {
+        _sub(rd, X0, q);
+    }
+    else if (q != rd) {
+        _mv(rd, q);
+    }
+}
+
+/**
+ * @brief 生成对常数取余的指令，即 rd = rs1 % imm，结果与被除数同号，避免使用很慢的 rem
+ * @param[in] rd 目标寄存器
+ * @param[in] rs1 源寄存器
+ * @param[in] imm 除数
+ * @note - 余数与除数的符号无关，按绝对值计算，rd = rs1 - rs1 / d * d
+ * @note - 2 的幂次时把加上偏置的被除数低位清零即得 rs1 / d * d
+ * @note - 对 0 与 -2^31 取余仍然使用 rem
+ */
+void Riscv::_remi(Reg rd, Reg rs1, const int& imm) {
+    if (imm == 0 || imm == INT32_MIN) {
+        auto reg = register_manager.tmp_reg();
+        _li(reg, imm);
+        _rem(rd, rs1, reg);
+        return;
+    }
+    int d = imm < 0 ? -imm : imm;
+    if (d == 1) {
+        _li(rd, 0);
+        return;
+    }
+    auto power = is_power_of_two(d);
+    auto reg = rd != rs1 ? rd : register_manager.new_reg();
+    if (power != -1) {
+        // 与 div_quotient 相同的偏置，右移之前把低 power 位清零
+        if (power == 1) {
+            _srli(reg, rs1, 31);
+        }
+        else {
+            _srai(reg, rs1, 31);
+            _srli(reg, reg, 32 - power);
+        }
+        _add(reg, reg, rs1);
+        if (is_imm12(-d)) {
+            _andi(reg, reg, -d);
+        }
+        else {
+            _srai(reg, reg, power);
+            _slli(reg, reg, power);
+        }
+    }
+    else {
+        // 商乘回除数时复用存放魔数的寄存器
+        auto tmp = register_manager.new_reg();
+        div_quotient(reg, rs1, d, tmp);
+        _muli(tmp, reg, d, false);
+        reg = tmp;
+    }
+    _sub(rd, rs1, reg);
 }
 
 /**
@@ -256,8 +663,8 @@ void Riscv::_sll(const string& rd, const string& rs1, const string& rs2) {
  * @param[in] rd 目标寄存器
  * @param[in] imm 立即数
  */
-void Riscv::_li(const string& rd, const int& imm) {
-    riscv_ofs << "\tli " << rd << ", " << imm << endl;
+void Riscv::_li(Reg rd, const int& imm) {
+    func.instrs.emplace_back(Opcode::LI, rd, NO_REG, NO_REG, imm);
 }
 
 /**
@@ -265,17 +672,17 @@ void Riscv::_li(const string& rd, const int& imm) {
  * @param[in] rd 目标寄存器
  * @param[in] rs1 源寄存器
  */
-void Riscv::_mv(const string& rd, const string& rs1) {
-    riscv_ofs << "\tmv " << rd << ", " << rs1 << endl;
+void Riscv::_mv(Reg rd, Reg rs1) {
+    func.instrs.emplace_back(Opcode::MV, rd, rs1);
 }
 
 /**
- * @brief 生成 la（加载地址）指令，即 rd = rs1
+ * @brief 生成 la（加载地址）指令，即 rd = &symbol
  * @param[in] rd 目标寄存器
- * @param[in] rs1 源寄存器
+ * @param[in] symbol 全局变量名
  */
-void Riscv::_la(const string& rd, const string& rs1) {
-    riscv_ofs << "\tla " << rd << ", " << rs1 << endl;
+void Riscv::_la(Reg rd, const char* symbol) {
+    func.instrs.emplace_back(Opcode::LA, rd).symbol = symbol;
 }
 
 /**
@@ -285,16 +692,16 @@ void Riscv::_la(const string& rd, const string& rs1) {
  * @param[in] bias 偏移量
  * @note 会自动处理偏移量，若偏移量超过 12 位立即数限制，则先将其存入一个临时寄存器，再进行加法运算
  */
-void Riscv::_lw(const string& rd, const string& base, const int& bias) {
+void Riscv::_lw(Reg rd, Reg base, const int& bias) {
     // 检查偏移量是否在 12 位立即数范围内
-    if (bias >= -2048 && bias < 2048) {
-        riscv_ofs << "\tlw " << rd << ", " << bias << "(" << base << ")" << endl;
+    if (is_imm12(bias)) {
+        func.instrs.emplace_back(Opcode::LW, rd, base, NO_REG, bias);
     }
     else {
         auto reg = register_manager.tmp_reg();
         _li(reg, bias);
         _add(reg, base, reg);
-        riscv_ofs << "\tlw " << rd << ", " << "(" << reg << ")" << endl;
+        func.instrs.emplace_back(Opcode::LW, rd, reg, NO_REG, 0);
     }
 }
 
@@ -305,81 +712,95 @@ void Riscv::_lw(const string& rd, const string& base, const int& bias) {
  * @param[in] bias 偏移量
  * @note 会自动处理偏移量，若偏移量超过 12 位立即数限制，则先将其存入一个临时寄存器，再进行加法运算
  */
-void Riscv::_sw(const string& rs, const string& base, const int& bias) {
+void Riscv::_sw(Reg rs, Reg base, const int& bias) {
     // 检查偏移量是否在 12 位立即数范围内
-    if (bias >= -2048 && bias < 2048) {
-        riscv_ofs << "\tsw " << rs << ", " << bias << "(" << base << ")" << endl;
+    if (is_imm12(bias)) {
+        func.instrs.emplace_back(Opcode::SW, NO_REG, base, rs, bias);
     }
     else {
         auto reg = register_manager.tmp_reg();
         _li(reg, bias);
         _add(reg, base, reg);
-        riscv_ofs << "\tsw " << rs << ", " << "(" << reg << ")" << endl;
+        func.instrs.emplace_back(Opcode::SW, NO_REG, reg, rs, 0);
     }
 }
 
 /**
  * @brief 生成 bnez 指令，即 if (cond != 0) goto label
  * @param[in] cond 条件寄存器
- * @param[in] label 跳转目标标签
- * @note 会生成多个标签，将短跳转转为长跳转，避免跳转范围限制
+ * @param[in] label 跳转目标标号编号
+ * @note 先按短跳转生成，超出范围时在输出前由分支松弛改写为长跳转
  */
-void Riscv::_bnez(const string& cond, const string& label) {
-    auto target_1 = context_manager.get_branch_label();
-    auto target_2 = context_manager.get_branch_end_label();
-    riscv_ofs << "\tbnez " << cond << ", " << target_1 << endl;
-    _jump(target_2);
-    _label(target_1);
-    _jump(label);
-    _label(target_2);
+void Riscv::_bnez(Reg cond, int label) {
+    func.instrs.emplace_back(Opcode::BNEZ, NO_REG, cond).label = label;
 }
 
 /**
  * @brief 生成 beqz 指令，即 if (cond == 0) goto label
  * @param[in] cond 条件寄存器
- * @param[in] label 跳转目标标签
- * @note 会生成多个标签，将短跳转转为长跳转，避免跳转范围限制
+ * @param[in] label 跳转目标标号编号
+ * @note 先按短跳转生成，超出范围时在输出前由分支松弛改写为长跳转
  */
-void Riscv::_beqz(const string& cond, const string& label) {
-    auto target_1 = context_manager.get_branch_label();
-    auto target_2 = context_manager.get_branch_end_label();
-    riscv_ofs << "\tbeqz " << cond << ", " << target_1 << endl;
-    _jump(target_2);
-    _label(target_1);
-    _jump(label);
-    _label(target_2);
+void Riscv::_beqz(Reg cond, int label) {
+    func.instrs.emplace_back(Opcode::BEQZ, NO_REG, cond).label = label;
 }
 
 /**
- * @brief 生成 j（跳转）指令，即 goto label
- * @param[in] label 跳转目标标签
+ * @brief 生成 beq 指令，即 if (rs1 == rs2) goto label
+ * @param[in] rs1 源寄存器 1
+ * @param[in] rs2 源寄存器 2
+ * @param[in] label 跳转目标标号编号
  */
-void Riscv::_jump(const string& label) {
-    riscv_ofs << "\tj " << label << endl;
+void Riscv::_beq(Reg rs1, Reg rs2, int label) {
+    func.instrs.emplace_back(Opcode::BEQ, NO_REG, rs1, rs2).label = label;
 }
 
 /**
- * @brief 将一个值（value）存储到栈中 `stack_map` 中，这个值在后续编译时会使用
- * @param[in] value 指令结果
- * @param[in] bias 偏移量
- * @note 与 _sw 不同，_sw 是生成存储指令，而 push 是真的在表中记录
- * @note 请参见 visit(koopa_raw_value_t) 何时会传递 value
+ * @brief 生成 bne 指令，即 if (rs1 != rs2) goto label
+ * @param[in] rs1 源寄存器 1
+ * @param[in] rs2 源寄存器 2
+ * @param[in] label 跳转目标标号编号
+ */
+void Riscv::_bne(Reg rs1, Reg rs2, int label) {
+    func.instrs.emplace_back(Opcode::BNE, NO_REG, rs1, rs2).label = label;
+}
+
+/**
+ * @brief 生成 blt 指令，即 if (rs1 < rs2) goto label
+ * @param[in] rs1 源寄存器 1
+ * @param[in] rs2 源寄存器 2
+ * @param[in] label 跳转目标标号编号
+ */
+void Riscv::_blt(Reg rs1, Reg rs2, int label) {
+    func.instrs.emplace_back(Opcode::BLT, NO_REG, rs1, rs2).label = label;
+}
+
+/**
+ * @brief 生成 bge 指令，即 if (rs1 >= rs2) goto label
+ * @param[in] rs1 源寄存器 1
+ * @param[in] rs2 源寄存器 2
+ * @param[in] label 跳转目标标号编号
+ */
+void Riscv::_bge(Reg rs1, Reg rs2, int label) {
+    func.instrs.emplace_back(Opcode::BGE, NO_REG, rs1, rs2).label = label;
+}
+
+/**
+ * @brief 生成 j（跳转）指令，即 goto label
+ * @param[in] label 跳转目标标号编号
  */
-void Context::push(const koopa_raw_value_t& value, int bias) {
-    // string msg = "bias: " + to_string(bias) + " stack_size: " + to_string(stack_size);
-    // cout << msg << endl;
-    assert(bias < stack_size);
-    stack_map[value] = bias;
-    stack_used += 4;
+void Riscv::_jump(int label) {
+    func.instrs.emplace_back(Opcode::J).label = label;
 }
 
 /**
  * @brief 创建一个 Context 对象
  * @param[in] name 函数名
  * @param[in] stack_size 栈空间大小
+ * @param[in] value_count 函数内值的编号上界，用于开辟栈空间映射
  */
-void ContextManager::create_context(const string& name, int stack_size) {
-    context_map[name] = Context(stack_size);
+void ContextManager::create_context(const string& name, int stack_size, int value_count) {
+    context_map[name] = Context(stack_size, value_count);
 }
 
 /**
@@ -395,10 +816,13 @@ Context& ContextManager::get_context(const string& name) {
  * @brief 创建一个全局变量，并增加全局变量计数器
  * @param[in] value 全局变量
  */
-void ContextManager::create_global(const koopa_raw_value_t& value) {
-    auto global_name = "global_" + to_string(global_count);
+void ContextManager::create_global(const Value* value) {
+    global_names.push_back("global_" + to_string(global_count));
     global_count++;
-    global_map[value] = global_name;
+    if (value->id >= (int)global_map.size()) {
+        global_map.resize(value->id + 1);
+    }
+    global_map[value->id] = global_names.back().c_str();
 }
 
 /**
@@ -406,60 +830,99 @@ void ContextManager::create_global(const koopa_raw_value_t& value) {
  * @param[in] value 全局变量
  * @return 全局变量的名字
  */
-string ContextManager::get_global(const koopa_raw_value_t& value) {
-    return global_map[value];
+const char* ContextManager::get_global(const Value* value) {
+    assert(value->kind == Value::Kind::GLOBAL_ALLOC);
+    return global_map[value->id];
 }
 
 /**
- * @brief 获取一个分支标签，并增加分支计数器
- * @return 分支标签
+ * @brief 获取临时寄存器的下标
+ * @param[in] reg 寄存器
+ * @return 下标，不是 t0 ~ t3 时为 -1
  */
-string ContextManager::get_branch_label() {
-    return "branch_" + to_string(branch_count++);
+int RegisterManager::scratch_index(Reg reg) const {
+    for (int i = 0; i < SCRATCH_COUNT; i++) {
+        if (t_reg(i) == reg) {
+            return i;
+        }
+    }
+    return -1;
 }
 
 /**
- * @brief 获取一个分支结束标签
- * @return 分支结束标签
+ * @brief 选出一个当前指令未占用的临时寄存器，并清空其中缓存的值
+ * @return 临时寄存器的下标
+ * @note 依次优先选择空闲或缓存的值已无后续使用的、缓存的值已在栈上的、缓存的值尚未写回的，同类中选最久未使用的
  */
-string ContextManager::get_branch_end_label() {
-    return "branch_end_" + to_string(branch_count);
+int RegisterManager::pick_scratch() {
+    // x0 是一个特殊的寄存器, 它的值恒为 0, 且向它写入的任何数据都会被丢弃.
+    // t0 到 t3 寄存器保留给单条指令内的临时值，其余寄存器由寄存器分配器分配给跨指令的值.
+    auto rank = [&](int i) {
+        if (!cached[i] || uses_left[cached[i]->id] == 0) {
+            return 0;
+        }
+        return dirty[i] ? 2 : 1;
+    };
+    int best = -1;
+    for (int i = 0; i < SCRATCH_COUNT; i++) {
+        if (pinned[i]) {
+            continue;
+        }
+        if (best == -1 || rank(i) < rank(best) || (rank(i) == rank(best) && last_used[i] < last_used[best])) {
+            best = i;
+        }
+    }
+    assert(best != -1);
+    evict(best);
+    return best;
 }
 
 /**
- * @brief 获取当前寄存器
- * @return 当前寄存器
+ * @brief 清空临时寄存器中缓存的值，尚未写回且还有后续使用的值先写回栈上
+ * @param[in] index 临时寄存器的下标
  */
-string RegisterManager::cur_reg() {
-    // x0 是一个特殊的寄存器, 它的值恒为 0, 且向它写入的任何数据都会被丢弃.
-    // t0 到 t6 寄存器, 以及 a0 到 a7 寄存器可以用来存放临时值.
-    if (reg_count < 8) {
-        return "t" + to_string(reg_count);
-    }
-    else {
-        return "a" + to_string(reg_count - 8);
+void RegisterManager::evict(int index) {
+    auto value = cached[index];
+    if (value && dirty[index] && uses_left[value->id] > 0) {
+        riscv._sw(t_reg(index), SP, context.stack_map[value->id]);
     }
+    cached[index] = nullptr;
+    dirty[index] = false;
 }
 
 /**
- * @brief 获取一个新的寄存器，并增加寄存器计数器
+ * @brief 获取一个新的寄存器，在当前指令内不会再被分配出去
  * @return 新的寄存器
  */
-string RegisterManager::new_reg() {
-    string reg = cur_reg();
-    reg_count++;
-    return reg;
+Reg RegisterManager::new_reg() {
+    auto index = pick_scratch();
+    pinned[index] = true;
+    last_used[index] = ++clock;
+    return t_reg(index);
 }
 
 /**
- * @brief 获取一个临时寄存器，调用完后不会增加寄存器计数器
- * @return 临时寄存器
+ * @brief 获取一个临时寄存器，不会被当前指令占用
+ * @return 临时寄存器，只能在下一次调用 new_reg 之前使用
  */
-string RegisterManager::tmp_reg() {
-    reg_count++;
-    auto ret = cur_reg();
-    reg_count--;
-    return ret;
+Reg RegisterManager::tmp_reg() {
+    return t_reg(pick_scratch());
+}
+
+/**
+ * @brief 查找缓存了值的临时寄存器，找到时在当前指令内占用它
+ * @param[in] value 值
+ * @return 寄存器，未缓存时为 NO_REG
+ */
+Reg RegisterManager::find_cached(const Value* value) {
+    for (int i = 0; i < SCRATCH_COUNT; i++) {
+        if (cached[i] == value) {
+            pinned[i] = true;
+            last_used[i] = ++clock;
+            return t_reg(i);
+        }
+    }
+    return NO_REG;
 }
 
 /**
@@ -467,71 +930,257 @@ string RegisterManager::tmp_reg() {
  * @param[in] value 值
  * @return 是否额外使用寄存器，若可以推断出值是 0，则不使用寄存器，否则使用寄存器
  */
-bool RegisterManager::get_operand_reg(const koopa_raw_value_t& value) {
+bool RegisterManager::get_operand_reg(const Value* value) {
     // ---[DEBUG]---
     // 打印值的类型
-    // printf("get_operand_reg: %s\n", koopaRawValueTagToString(value->kind.tag).c_str());
+    // printf("get_operand_reg: %s\n", valueKindToString(value->kind).c_str());
     // ---[DEBUG END]---
+    auto& reg = reg_map[value->id];
+    // 运算数已经分配到寄存器，直接使用
+    auto allocated = register_allocator.get(value);
+    if (allocated != NO_REG) {
+        reg = allocated;
+        return true;
+    }
+    // 运算数溢出后需要重新计算
+    if (register_allocator.is_remat(value)) {
+        reg = new_reg();
+        rematerialize(reg, value);
+        return true;
+    }
     // 运算数为整数
-    if (value->kind.tag == KOOPA_RVT_INTEGER) {
-        if (value->kind.data.integer.value == 0) {
-            reg_map[value] = "x0";
+    if (value->kind == Value::Kind::INTEGER) {
+        auto integer = static_cast<const Integer*>(value)->value;
+        if (integer == 0) {
+            reg = X0;
             return false;
         }
         else {
-            reg_map[value] = new_reg();
-            riscv._li(reg_map[value], value->kind.data.integer.value);
+            reg = new_reg();
+            riscv._li(reg, integer);
             return true;
         }
     }
-    // 运算数为 load 指令，先加载
-    else if (value->kind.tag == KOOPA_RVT_LOAD) {
-        reg_map[value] = new_reg();
-        riscv._lw(reg_map[value], "sp", context.stack_map[value]);
-        return true;
-    }
-    // 运算数为二元运算的结果，也需要先加载
-    // 出现在形如 a = a + b + c 的式子中
-    else if (value->kind.tag == KOOPA_RVT_BINARY) {
-        reg_map[value] = new_reg();
-        riscv._lw(reg_map[value], "sp", context.stack_map[value]);
-        return true;
-    }
-    // 运算数为 call 指令的返回值
-    else if (value->kind.tag == KOOPA_RVT_CALL) {
-        reg_map[value] = new_reg();
-        riscv._lw(reg_map[value], "sp", context.stack_map[value]);
-        return true;
-    }
-    // 运算数为函数参数
-    else if (value->kind.tag == KOOPA_RVT_FUNC_ARG_REF) {
-        auto index = value->kind.data.func_arg_ref.index;
-        // 前 8 个参数放在 a0 到 a7 寄存器中
+    // 运算数为没有分配到寄存器的函数参数
+    else if (value->kind == Value::Kind::FUNC_ARG) {
+        auto index = static_cast<const Argument*>(value)->index;
+        reg = new_reg();
+        // 前 8 个参数在入口处存到了栈槽中
         if (index < 8) {
-            reg_map[value] = "a" + to_string(index);
+            riscv._lw(reg, SP, context.stack_map[value->id]);
         }
-        // 再后面的参数要从栈上找
+        // 再后面的参数要从上一个栈帧中获取
         else {
-            // 先获取当前栈帧大小
-            reg_map[value] = new_reg();
-            int stack_size = context.stack_size;
-            int offset = 4 * (index - 8);
-            // 从上一个栈帧中获取
-            riscv._lw(reg_map[value], "sp", stack_size + offset);
+            riscv._lw(reg, SP, context.stack_size + 4 * (index - 8));
+        }
+        return true;
+    }
+    // 运算数为 load、二元运算、call 的结果，或 getptr、getelemptr 计算出的指针
+    // 出现在形如 a = a + b + c 的式子中，优先复用缓存在临时寄存器中的值，否则从栈上加载
+    else if (Liveness::is_candidate(value)) {
+        reg = find_cached(value);
+        if (reg == NO_REG) {
+            reg = new_reg();
+            riscv._lw(reg, SP, context.stack_map[value->id]);
+            cached[scratch_index(reg)] = value;
         }
         return true;
     }
     // 其他情况，报错
     else {
-        auto msg = "Invalid operand: " + koopaRawValueTagToString(value->kind.tag);
+        auto msg = "Invalid operand: " + valueKindToString(value->kind);
         assert(false && msg.c_str());
     }
     return true;
 }
 
 /**
- * @brief 重置寄存器计数器
+ * @brief 将一个值放入指定的寄存器中
+ * @param[in] target 目标寄存器
+ * @param[in] value 值
+ * @note 与 get_operand_reg 不同，不会额外使用临时寄存器，用于准备参数与返回值
+ */
+void RegisterManager::load_operand(Reg target, const Value* value) {
+    auto allocated = register_allocator.get(value);
+    if (allocated != NO_REG) {
+        if (allocated != target) {
+            riscv._mv(target, allocated);
+        }
+    }
+    else if (register_allocator.is_remat(value)) {
+        rematerialize(target, value);
+    }
+    else if (value->kind == Value::Kind::INTEGER) {
+        riscv._li(target, static_cast<const Integer*>(value)->value);
+    }
+    else if (value->kind == Value::Kind::FUNC_ARG && static_cast<const Argument*>(value)->index < 8) {
+        riscv._lw(target, SP, context.stack_map[value->id]);
+    }
+    else if (value->kind == Value::Kind::FUNC_ARG) {
+        int offset = 4 * (static_cast<const Argument*>(value)->index - 8);
+        riscv._lw(target, SP, context.stack_size + offset);
+    }
+    else if (auto cached = find_cached(value); cached != NO_REG) {
+        riscv._mv(target, cached);
+    }
+    else {
+        riscv._lw(target, SP, context.stack_map[value->id]);
+    }
+}
+
+/**
+ * @brief 重新计算以常量下标从局部数组或全局变量算出的指针
+ * @param[in] target 目标寄存器
+ * @param[in] value getptr / getelemptr 指令
+ */
+void RegisterManager::rematerialize(Reg target, const Value* value) {
+    // 沿指针计算链找到局部数组或全局变量，累加常量偏移
+    int offset = 0;
+    auto root = value;
+    while (root->kind == Value::Kind::GET_ELEM_PTR || root->kind == Value::Kind::GET_PTR) {
+        auto inst = static_cast<const Instruction*>(root);
+        auto src = inst->operand(0);
+        int size = root->kind == Value::Kind::GET_ELEM_PTR ? src->ty->base->base->size() : src->ty->base->size();
+        offset += static_cast<const Integer*>(inst->operand(1))->value * size;
+        root = src;
+    }
+    if (root->kind == Value::Kind::ALLOC) {
+        riscv._addi(target, SP, context.stack_map[root->id] + offset);
+    }
+    else {
+        riscv._la(target, context_manager.get_global(root));
+        if (offset) {
+            riscv._addi(target, target, offset);
+        }
+    }
+}
+
+/**
+ * @brief 获取存放指令结果的寄存器
+ * @param[in] value 指令
+ * @return 分配到的寄存器，未分配时为一个新的临时寄存器
+ */
+Reg RegisterManager::result_reg(const Value* value) {
+    auto allocated = register_allocator.get(value);
+    return allocated != NO_REG ? allocated : new_reg();
+}
+
+/**
+ * @brief 保存指令结果，未分配到寄存器的值存到栈上
+ * @param[in] value 指令
+ * @param[in] reg 结果当前所在的寄存器
+ * @note - 分配到寄存器的值若不在其寄存器中，会补一条 mv 指令
+ * @note - 只在本基本块内使用的值先缓存在临时寄存器中，被替换或遇到函数调用时才写回栈上
+ */
+void RegisterManager::save_result(const Value* value, Reg reg) {
+    auto allocated = register_allocator.get(value);
+    if (allocated != NO_REG) {
+        if (allocated != reg) {
+            riscv._mv(allocated, reg);
+        }
+        return;
+    }
+    auto offset = context.stack_map[value->id];
+    // 延迟写回时不能再借用临时寄存器计算地址，因此偏移量需要在 12 位立即数范围内
+    if (!live_out[value->id] && offset < 2048) {
+        auto index = scratch_index(reg);
+        // 结果在 a0 等寄存器中，先挪到临时寄存器
+        if (index == -1) {
+            index = scratch_index(new_reg());
+            riscv._mv(t_reg(index), reg);
+        }
+        // 寄存器中缓存的是别的值，如 getelemptr 偏移为 0 时直接沿用基准值的寄存器
+        if (!cached[index] || cached[index] == value) {
+            cached[index] = value;
+            dirty[index] = true;
+            return;
+        }
+    }
+    riscv._sw(reg, SP, offset);
+}
+
+/**
+ * @brief 开始翻译新的指令，释放上一条指令占用的临时寄存器，缓存的值仍然保留
  */
 void RegisterManager::reset() {
-    reg_count = 0;
-}
\ No newline at end of file
+    fill(begin(pinned), end(pinned), false);
+}
+
+/**
+ * @brief 一条指令翻译完成，更新其操作数的剩余使用次数，不再使用的值不必继续缓存
+ * @param[in] inst 指令
+ */
+void RegisterManager::release(const Instruction* inst) {
+    // 与 br 合并的比较在 br 处才读取操作数，届时再一并更新
+    if (Liveness::is_branch_compare(inst)) {
+        return;
+    }
+    auto release_operands = [&](const Instruction* inst) {
+        for (int i = 0; i < inst->num_operands; i++) {
+            auto value = inst->operand(i);
+            if (Liveness::is_candidate(value) && --uses_left[value->id] == 0) {
+                for (int j = 0; j < SCRATCH_COUNT; j++) {
+                    if (cached[j] == value) {
+                        evict(j);
+                    }
+                }
+            }
+        }
+    };
+    if (inst->kind == Value::Kind::BRANCH && Liveness::is_branch_compare(inst->operand(0))) {
+        release_operands(static_cast<const Instruction*>(inst->operand(0)));
+    }
+    release_operands(inst);
+}
+
+/**
+ * @brief 写回并清空所有缓存的值，在函数调用前使用，因为调用会覆盖临时寄存器
+ */
+void RegisterManager::flush() {
+    for (int i = 0; i < SCRATCH_COUNT; i++) {
+        evict(i);
+    }
+}
+
+/**
+ * @brief 开始翻译新的基本块，清空缓存的值
+ * @note 缓存的都是只在所在基本块内使用的值，到基本块末尾时已经没有后续使用
+ */
+void RegisterManager::begin_block() {
+    for (int i = 0; i < SCRATCH_COUNT; i++) {
+        assert(!cached[i] || !dirty[i] || uses_left[cached[i]->id] == 0);
+        cached[i] = nullptr;
+        dirty[i] = false;
+        pinned[i] = false;
+    }
+}
+
+/**
+ * @brief 开始翻译新的函数，按函数内值的编号上界重新开辟寄存器映射，并统计每个值的使用情况
+ * @param[in] func 函数
+ */
+void RegisterManager::begin_function(const Function* func) {
+    // 上一个函数可能以丢弃返回值的调用结尾，调用结果仍缓存在临时寄存器中，
+    // 它的编号属于上一个函数，要在重新统计使用次数之前丢掉，而不是交给 begin_block 检查
+    fill(begin(cached), end(cached), nullptr);
+    fill(begin(dirty), end(dirty), false);
+    fill(begin(pinned), end(pinned), false);
+    reg_map.assign(func->value_count, NO_REG);
+    uses_left.assign(func->value_count, 0);
+    live_out.assign(func->value_count, false);
+    for (auto bb : func->bbs) {
+        // 基本块参数不会缓存为尚未写回的值，只需统计使用次数
+        for (auto param : bb->params) {
+            uses_left[param->id] = param->use_count();
+        }
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            for (auto use = inst->uses; use; use = use->next) {
+                uses_left[inst->id]++;
+                if (use->user->parent != bb) {
+                    live_out[inst->id] = true;
+                }
+            }
+        }
+    }
+    begin_block();
+}
@@ -0,0 +1,364 @@
+#include "include/builder.hpp"
+
+/**
+ * @brief 获取操作数对应的值
+ * @param[in] operand 操作数
+ * @return 值，立即数会新建一个整数常量
+ */
+Value* IRBuilder::value(const Operand& operand) {
+    // 具名符号，先找局部，再找全局
+    if (operand.is_symbol) {
+        auto it = symbols.find(operand.symbol);
+        if (it != symbols.end()) {
+            return it->second;
+        }
+        auto global = globals.find(operand.symbol);
+        assert(global != globals.end());
+        return global->second;
+    }
+    // 立即数
+    if (operand.result.type == Result::Type::IMM) {
+        return cur_func->integer(operand.result.value);
+    }
+    // 临时寄存器
+    assert(operand.result.value < (int)regs.size() && regs[operand.result.value]);
+    return regs[operand.result.value];
+}
+
+/**
+ * @brief 按名字获取当前函数的基本块，不存在则创建
+ * @param[in] name 基本块名，如 %then_0
+ * @return 基本块
+ */
+BasicBlock* IRBuilder::block(const string& name) {
+    auto& bb = block_map[name];
+    if (!bb) {
+        bb = cur_func->new_block(name);
+    }
+    return bb;
+}
+
+/**
+ * @brief 创建指令并追加到当前基本块末尾
+ * @param[in] num_operands 操作数个数
+ * @param[in] args 指令构造函数参数
+ * @return 指令
+ */
+template <typename T, typename... Args>
+T* IRBuilder::append(int num_operands, Args&&... args) {
+    assert(cur_bb);
+    auto inst = cur_func->create<T>(num_operands, std::forward<Args>(args)...);
+    cur_bb->insert(inst);
+    return inst;
+}
+
+/**
+ * @brief 记录前端临时寄存器 %n 对应的值
+ * @param[in] dst 临时寄存器
+ * @param[in] value 值
+ */
+void IRBuilder::define(const Result& dst, Value* value) {
+    assert(dst.type == Result::Type::REG);
+    if (dst.value >= (int)regs.size()) {
+        regs.resize(dst.value + 1, nullptr);
+    }
+    regs[dst.value] = value;
+}
+
+/**
+ * @brief 获取 i32 类型
+ * @return 类型
+ */
+const Type* IRBuilder::int_type() {
+    return program.int_type();
+}
+
+/**
+ * @brief 获取 unit 类型
+ * @return 类型
+ */
+const Type* IRBuilder::unit_type() {
+    return program.unit_type();
+}
+
+/**
+ * @brief 获取指向 base 的指针类型
+ * @param[in] base 指向的类型
+ * @return 类型
+ */
+const Type* IRBuilder::pointer_type(const Type* base) {
+    return program.pointer_type(base);
+}
+
+/**
+ * @brief 获取数组类型，输入 <2,3>，得到 [[i32, 3], 2]
+ * @param[in] indices 数组维度向量，正序
+ * @return 类型，对于空向量得到 i32
+ */
+const Type* IRBuilder::array_type(const vector<int>& indices) {
+    auto base = program.int_type();
+    // 倒序
+    for (int i = indices.size() - 1;i >= 0;i--) {
+        base = program.array_type(base, indices[i]);
+    }
+    return base;
+}
+
+/**
+ * @brief 声明库函数，如 decl @getint(): i32
+ * @param[in] name 函数名，带 @
+ * @param[in] params 参数类型
+ * @param[in] ret 返回值类型
+ */
+void IRBuilder::declare(const string& name, const vector<const Type*>& params, const Type* ret) {
+    function_map[name] = program.function(name, program.function_type(params, ret));
+}
+
+/**
+ * @brief 开始定义函数，之后的基本块与指令都属于该函数
+ * @param[in] name 函数名，带 @
+ * @param[in] params 参数名（带 @）与参数类型
+ * @param[in] ret 返回值类型
+ */
+void IRBuilder::begin_function(const string& name, const vector<pair<string, const Type*>>& params, const Type* ret) {
+    vector<const Type*> param_types;
+    for (auto& param : params) {
+        param_types.push_back(param.second);
+    }
+    // 先登记函数，保证函数体内可以递归调用自身
+    declare(name, param_types, ret);
+    cur_func = function_map[name];
+    symbols.clear();
+    block_map.clear();
+    regs.clear();
+    // 为参数引用命名
+    for (size_t i = 0; i < params.size(); i++) {
+        auto arg = cur_func->params[i];
+        arg->name = cur_func->arena.strdup(params[i].first);
+        symbols[params[i].first] = arg;
+    }
+}
+
+/**
+ * @brief 结束函数定义
+ */
+void IRBuilder::end_function() {
+    cur_func = nullptr;
+    cur_bb = nullptr;
+}
+
+/**
+ * @brief 创建全局整数常量
+ * @param[in] value 整数
+ * @return 值
+ */
+Value* IRBuilder::integer(int value) {
+    return program.integer(value);
+}
+
+/**
+ * @brief 创建零初始化值，即 zeroinit
+ * @param[in] ty 被初始化的类型
+ * @return 值
+ */
+Value* IRBuilder::zero_init(const Type* ty) {
+    return program.zero_init(ty);
+}
+
+/**
+ * @brief 创建初始化列表，即 {1, 2, 3}
+ * @param[in] ty 初始化列表的数组类型
+ * @param[in] elems 元素
+ * @return 值
+ */
+Value* IRBuilder::aggregate(const Type* ty, const vector<Value*>& elems) {
+    return program.aggregate(ty, elems);
+}
+
+/**
+ * @brief 创建全局变量，即 global @x = alloc T, init
+ * @param[in] name 全局变量名，带 @
+ * @param[in] ty 分配的类型
+ * @param[in] init 初始值
+ */
+void IRBuilder::global_alloc(const string& name, const Type* ty, Value* init) {
+    globals[name] = program.global_alloc(name, ty, init);
+}
+
+/**
+ * @brief 开始一个新的基本块，即 %name:
+ * @param[in] name 基本块名，带 %
+ */
+void IRBuilder::label(const string& name) {
+    cur_bb = block(name);
+    cur_func->bbs.push_back(cur_bb);
+}
+
+/**
+ * @brief 创建局部分配，即 @x = alloc T
+ * @param[in] name 变量名，带 @ 或 %
+ * @param[in] ty 分配的类型
+ */
+void IRBuilder::alloc(const string& name, const Type* ty) {
+    auto inst = append<Alloc>(0, program.pointer_type(ty));
+    inst->name = cur_func->arena.strdup(name);
+    symbols[name] = inst;
+}
+
+/**
+ * @brief 让临时寄存器直接指代已有的值，不生成指令，用于直接读取未被重新赋值的参数
+ * @param[in] dst 临时寄存器
+ * @param[in] src 已有的值，如 @x
+ */
+void IRBuilder::alias(const Result& dst, const Operand& src) {
+    define(dst, value(src));
+}
+
+/**
+ * @brief 创建 load 指令，即 %n = load src
+ * @param[in] dst 结果寄存器
+ * @param[in] src 地址
+ */
+void IRBuilder::load(const Result& dst, const Operand& src) {
+    auto src_value = value(src);
+    auto inst = append<Load>(1, src_value->ty->base);
+    inst->set_operand(0, src_value);
+    define(dst, inst);
+}
+
+/**
+ * @brief 创建 store 指令，即 store value, dest
+ * @param[in] value 要存储的值
+ * @param[in] dest 地址
+ */
+void IRBuilder::store(const Operand& value, const Operand& dest) {
+    auto value_value = this->value(value);
+    auto dest_value = this->value(dest);
+    auto inst = append<Store>(2, program.unit_type());
+    inst->set_operand(0, value_value);
+    inst->set_operand(1, dest_value);
+}
+
+/**
+ * @brief 创建 getptr 指令，即 %n = getptr src, index
+ * @param[in] dst 结果寄存器
+ * @param[in] src 指针
+ * @param[in] index 偏移
+ */
+void IRBuilder::get_ptr(const Result& dst, const Operand& src, const Operand& index) {
+    auto src_value = value(src);
+    auto index_value = value(index);
+    auto inst = append<GetPtr>(2, src_value->ty);
+    inst->set_operand(0, src_value);
+    inst->set_operand(1, index_value);
+    define(dst, inst);
+}
+
+/**
+ * @brief 创建 getelemptr 指令，即 %n = getelemptr src, index
+ * @param[in] dst 结果寄存器
+ * @param[in] src 数组指针
+ * @param[in] index 下标
+ */
+void IRBuilder::get_elem_ptr(const Result& dst, const Operand& src, const Operand& index) {
+    auto src_value = value(src);
+    auto index_value = value(index);
+    auto inst = append<GetElemPtr>(2, program.pointer_type(src_value->ty->base->base));
+    inst->set_operand(0, src_value);
+    inst->set_operand(1, index_value);
+    define(dst, inst);
+}
+
+/**
+ * @brief 创建二元运算指令，即 %n = op lhs, rhs
+ * @param[in] dst 结果寄存器
+ * @param[in] op 运算符
+ * @param[in] lhs 左操作数
+ * @param[in] rhs 右操作数
+ */
+void IRBuilder::binary(const Result& dst, BinaryOp op, const Operand& lhs, const Operand& rhs) {
+    auto lhs_value = value(lhs);
+    auto rhs_value = value(rhs);
+    auto inst = append<Binary>(2, program.int_type(), op);
+    inst->set_operand(0, lhs_value);
+    inst->set_operand(1, rhs_value);
+    define(dst, inst);
+}
+
+/**
+ * @brief 创建条件分支指令，即 br cond, %true, %false
+ * @param[in] cond 条件
+ * @param[in] true_label 条件成立时跳转的基本块名
+ * @param[in] false_label 条件不成立时跳转的基本块名
+ */
+void IRBuilder::branch(const Operand& cond, const string& true_label, const string& false_label) {
+    auto cond_value = value(cond);
+    auto inst = append<Branch>(1, program.unit_type());
+    inst->set_operand(0, cond_value);
+    inst->true_bb = block(true_label);
+    inst->false_bb = block(false_label);
+}
+
+/**
+ * @brief 创建无条件跳转指令，即 jump %label
+ * @param[in] label 目标基本块名
+ */
+void IRBuilder::jump(const string& label) {
+    auto inst = append<Jump>(0, program.unit_type());
+    inst->target = block(label);
+}
+
+/**
+ * @brief 创建有返回值的函数调用指令，即 %n = call @f(args)
+ * @param[in] dst 结果寄存器
+ * @param[in] callee 函数名，带 @
+ * @param[in] args 实参
+ */
+void IRBuilder::call(const Result& dst, const string& callee, const vector<Result>& args) {
+    call(callee, args);
+    define(dst, cur_bb->tail);
+}
+
+/**
+ * @brief 创建函数调用指令，即 call @f(args)，结果类型为被调函数的返回值类型
+ * @param[in] callee 函数名，带 @
+ * @param[in] args 实参
+ */
+void IRBuilder::call(const string& callee, const vector<Result>& args) {
+    auto it = function_map.find(callee);
+    assert(it != function_map.end());
+    vector<Value*> arg_values;
+    for (auto& arg : args) {
+        arg_values.push_back(value(arg));
+    }
+    auto inst = append<Call>(args.size(), it->second->ty->ret);
+    inst->callee = it->second;
+    for (size_t i = 0; i < arg_values.size(); i++) {
+        inst->set_operand(i, arg_values[i]);
+    }
+}
+
+/**
+ * @brief 创建带返回值的 return 指令，即 ret value
+ * @param[in] value 返回值
+ */
+void IRBuilder::ret(const Operand& value) {
+    auto ret_value = this->value(value);
+    auto inst = append<Return>(1, program.unit_type());
+    inst->set_operand(0, ret_value);
+}
+
+/**
+ * @brief 创建不带返回值的 return 指令，即 ret
+ */
+void IRBuilder::ret() {
+    append<Return>(0, program.unit_type());
+}
+
+/**
+ * @brief 构建完成，获取程序
+ * @return 程序，其中所有对象均由构建器持有
+ */
+Program& IRBuilder::build() {
+    return program;
+}
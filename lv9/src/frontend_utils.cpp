@@ -1,79 +1,167 @@
 #include "include/frontend_utils.hpp"
+#include "include/builder.hpp"
 
 /**
- * @brief 创建符号表，向符号表中添加符号
- * @param[in] ident 符号名
- * @param[in] symbol 符号
+ * @brief 获取标识符对应的字符串
+ * @return 字符串，生命周期与字符串池相同
  */
-void SymbolTable::create(const string& ident, Symbol symbol) {
-    // 保证当前层级不存在
-    assert(symbol_table.find(ident) == symbol_table.end());
-    symbol_table[ident] = symbol;
+const string& Ident::str() const {
+    return string_pool.str(id);
 }
 
 /**
- * @brief 读取符号表，从符号表中读取符号，若当前层级不存在，则向父级符号表中查找
- * @param[in] ident 符号名
- * @return 符号
+ * @brief 驻留一个标识符，已存在时直接返回已有的句柄
+ * @param[in] text 标识符首地址，如 lexer 的 yytext
+ * @param[in] len 标识符长度
+ * @return 标识符句柄
  */
-Symbol SymbolTable::read(const string& ident) {
-    if (symbol_table.find(ident) != symbol_table.end()) {
-        return symbol_table[ident];
-    }
-    else if (parent) {
-        return parent->read(ident);
-    }
-    else {
-        return Symbol();
+Ident StringPool::intern(const char* text, size_t len) {
+    auto it = index.find(string_view(text, len));
+    if (it != index.end()) {
+        return Ident{ it->second };
     }
+    int id = strings.size();
+    strings.emplace_back(text, len);
+    index.emplace(string_view(strings.back()), id);
+    return Ident{ id };
 }
 
 /**
- * @brief 判断符号是否存在，若当前层级不存在，则向父级符号表中查找
- * @param[in] ident 符号名
- * @return 符号是否存在
+ * @brief 驻留一个标识符，已存在时直接返回已有的句柄
+ * @param[in] text 标识符
+ * @return 标识符句柄
  */
-bool SymbolTable::exist(const string& ident) {
-    if (symbol_table.find(ident) != symbol_table.end()) {
-        return true;
-    }
-    else if (parent) {
-        return parent->exist(ident);
+Ident StringPool::intern(const string& text) {
+    return intern(text.data(), text.size());
+}
+
+/**
+ * @brief 按编号获取驻留的字符串
+ * @param[in] id 编号
+ * @return 字符串
+ */
+const string& StringPool::str(int id) const {
+    assert(id >= 0 && id < (int)strings.size());
+    return strings[id];
+}
+
+/**
+ * @brief 获取已驻留的标识符个数
+ * @return 个数
+ */
+int StringPool::size() const {
+    return strings.size();
+}
+
+/**
+ * @brief 查找标识符当前可见的最内层绑定
+ * @param[in] ident 标识符
+ * @return 绑定，不存在则为空
+ */
+const SymbolTable::Binding* SymbolTable::find(Ident ident) const {
+    if (ident.id >= (int)visible.size() || visible[ident.id] == -1) {
+        return nullptr;
     }
-    else {
-        return false;
+    return &bindings[visible[ident.id]];
+}
+
+/**
+ * @brief 获取当前作用域的深度，全局作用域为 0
+ * @return 深度
+ */
+int SymbolTable::depth() const {
+    return scopes.size() - 1;
+}
+
+/**
+ * @brief 进入新的作用域
+ */
+void SymbolTable::push_scope() {
+    scopes.push_back({ (int)bindings.size(), false });
+}
+
+/**
+ * @brief 退出当前作用域，按撤销日志弹出该作用域内创建的符号，恢复被遮蔽的外层符号
+ */
+void SymbolTable::pop_scope() {
+    assert(scopes.size() > 1);
+    while ((int)bindings.size() > scopes.back().mark) {
+        auto& binding = bindings.back();
+        visible[binding.ident.id] = binding.shadowed;
+        bindings.pop_back();
     }
+    scopes.pop_back();
 }
 
 /**
- * @brief 设置父级符号表，并设置当前符号表的深度为父级符号表的深度加 1
- * @param[in] parent 父级符号表的指针
+ * @brief 判断当前作用域是否已经存在 return 语句，用于判断是否需要生成后续语句
+ * @return 是否已经返回
  */
-void SymbolTable::set_parent(SymbolTable* parent) {
-    this->parent = parent;
-    this->depth = parent->depth + 1;
+bool SymbolTable::is_returned() const {
+    return scopes.back().is_returned;
 }
 
 /**
- * @brief 定位符号，若当前层级不存在，则向父级符号表中查找
- * @param[in] ident 符号名
- * @return 符号名
+ * @brief 设置当前作用域是否已经存在 return 语句
+ * @param[in] is_returned 是否已经返回
  */
-string SymbolTable::locate(const string& ident) {
-    string ident_with_suffix = ident + "_" + to_string(depth);
-    if (symbol_table.find(ident_with_suffix) == symbol_table.end() && parent) {
-        return parent->locate(ident);
+void SymbolTable::set_returned(bool is_returned) {
+    scopes.back().is_returned = is_returned;
+}
+
+/**
+ * @brief 在当前作用域中创建符号，会遮蔽外层作用域的同名符号
+ * @param[in] ident 标识符
+ * @param[in] symbol 符号
+ */
+void SymbolTable::create(Ident ident, Symbol symbol) {
+    if (ident.id >= (int)visible.size()) {
+        visible.resize(string_pool.size(), -1);
     }
-    return ident_with_suffix;
+    int shadowed = visible[ident.id];
+    // 保证当前层级不存在
+    assert(shadowed == -1 || bindings[shadowed].depth != depth());
+    bindings.push_back({ ident, assign(ident), symbol, depth(), shadowed });
+    visible[ident.id] = bindings.size() - 1;
+}
+
+/**
+ * @brief 判断符号在当前作用域是否可见
+ * @param[in] ident 标识符
+ * @return 符号是否存在
+ */
+bool SymbolTable::exist(Ident ident) const {
+    return find(ident) != nullptr;
+}
+
+/**
+ * @brief 读取当前可见的符号
+ * @param[in] ident 标识符
+ * @return 符号，不存在则为默认符号
+ */
+Symbol SymbolTable::read(Ident ident) const {
+    auto binding = find(ident);
+    return binding ? binding->symbol : Symbol();
+}
+
+/**
+ * @brief 定位符号，得到当前可见的符号在创建时分配的唯一标识符
+ * @param[in] ident 标识符
+ * @return 符号名，如 x_1
+ */
+const string& SymbolTable::locate(Ident ident) const {
+    auto binding = find(ident);
+    assert(binding);
+    return binding->name;
 }
 
 /**
- * @brief 分配符号，在当前符号表中为符号分配一个唯一的标识符，但尚未在符号表中创建
- * @param[in] ident 符号名
- * @return 符号名
+ * @brief 分配符号，在当前作用域中为符号分配一个唯一的标识符，但尚未在符号表中创建
+ * @param[in] ident 标识符
+ * @return 符号名，如 x_1
  */
-string SymbolTable::assign(const string& ident) {
-    return ident + "_" + to_string(depth);
+string SymbolTable::assign(Ident ident) const {
+    return ident.str() + "_" + to_string(depth());
 }
 
 /**
@@ -225,135 +313,120 @@ int EnvironmentManager::get_while_current() {
  * @brief 初始化库函数声明
  */
 void init_lib() {
-    koopa_ofs << "decl @getint(): i32" << endl;
-    koopa_ofs << "decl @getch(): i32" << endl;
-    koopa_ofs << "decl @getarray(*i32): i32" << endl;
+    auto i32 = ir_builder.int_type();
+    auto unit = ir_builder.unit_type();
+    auto ptr = ir_builder.pointer_type(i32);
+
+    ir_builder.declare("@getint", {}, i32);
+    ir_builder.declare("@getch", {}, i32);
+    ir_builder.declare("@getarray", { ptr }, i32);
     environment_manager.is_func_return["getint"] = true;
     environment_manager.is_func_return["getch"] = true;
     environment_manager.is_func_return["getarray"] = true;
 
-    koopa_ofs << "decl @putint(i32)" << endl;
-    koopa_ofs << "decl @putch(i32)" << endl;
-    koopa_ofs << "decl @putarray(i32, *i32)" << endl;
+    ir_builder.declare("@putint", { i32 }, unit);
+    ir_builder.declare("@putch", { i32 }, unit);
+    ir_builder.declare("@putarray", { i32, ptr }, unit);
 
-    koopa_ofs << "decl @starttime()" << endl;
-    koopa_ofs << "decl @stoptime()" << endl;
-    koopa_ofs << endl;
+    ir_builder.declare("@starttime", {}, unit);
+    ir_builder.declare("@stoptime", {}, unit);
 }
 
 /**
- * @brief 格式化数组类型，输入 <2,3>，输出 [[i32, 3], 2]
- * @param indices 数组维度向量，正序
- * @note 对于空向量，输出 i32
+ * @brief 构建全局数组初始化值 aggregate，如 {{1, 2, 3}, {4, 5, 6}}
+ * @param[in] indices 数组维度
+ * @param[in] array 初始化值
+ * @param[in] level 当前维度
+ * @param[in] index 当前值索引
+ * @return 当前维度对应的 aggregate
  */
-void format_array_type(const vector<int>& indices) {
-    if (indices.empty()) {
-        koopa_ofs << "i32";
+static Value* aggregate_array(const vector<int>& indices, int* array, int level, int& index) {
+    vector<Value*> elems;
+    for (int i = 0;i < indices[level];i++) {
+        // 最内层数组，直接放入整数
+        if (level == indices.size() - 1) {
+            elems.push_back(ir_builder.integer(array[index]));
+            index++;
+        }
+        // 非最内层数组，嵌套 aggregate
+        else {
+            elems.push_back(aggregate_array(indices, array, level + 1, index));
+        }
     }
-    else {
-        for (int i = 0;i < indices.size();i++) {
-            koopa_ofs << "[";
+    // 当前维度的类型，如 level = 1 时 <2,3> 对应 [i32, 3]
+    auto ty = ir_builder.array_type(vector<int>(indices.begin() + level, indices.end()));
+    return ir_builder.aggregate(ty, elems);
+}
+
+/**
+ * @brief 逐个元素初始化局部数组，生成 getelemptr 与 store 指令
+ * @param[in] ident 数组名
+ * @param[in] indices 数组维度
+ * @param[in] array 初始化值
+ * @param[in] level 当前维度
+ * @param[in] index 当前值索引
+ * @param[in] bases 基址
+ */
+static void store_array(const string& ident, const vector<int>& indices, int* array, int level, int& index, vector<int>& bases) {
+    int base = bases.back();
+    for (int i = 0;i < indices[level];i++) {
+        Result ptr = NEW_REG_;
+        if (base == -1) {
+            ir_builder.get_elem_ptr(ptr, "@" + ident, IMM_(i));
+        }
+        else {
+            ir_builder.get_elem_ptr(ptr, REG_(base), IMM_(i));
+        }
+        // 最内层数组
+        if (level == indices.size() - 1) {
+            ir_builder.store(IMM_(array[index]), ptr);
+            index++;
         }
-        koopa_ofs << "i32";
-        // 倒序
-        for (int i = indices.size() - 1;i >= 0;i--) {
-            koopa_ofs << ", " << indices[i] << "]";
+        // 非最内层数组，递归初始化
+        else {
+            bases.push_back(ptr.value);
+            store_array(ident, indices, array, level + 1, index, bases);
+            bases.pop_back();
         }
     }
 }
 
 /**
- * @brief 打印数组类型声明，如 @arr = alloc [[i32, 3], 2]
+ * @brief 定义带初始化值的数组，如 @arr = alloc [[i32, 3], 2]
  * @param[in] ident 数组名
  * @param[in] indices 数组维度
- * @note 会在其内判断是否为全局数组，并前加 global
+ * @param[in] array 初始化值
+ * @note 会在其内判断是否为全局数组，全局数组使用 aggregate 初始化，局部数组逐个 store
  */
-void print_array_type(const string& ident, const vector<int>& indices) {
+void print_array(const string& ident, const vector<int>& indices, int* array) {
+    auto ty = ir_builder.array_type(indices);
+    int index = 0;
+    // 全局数组
     if (environment_manager.is_global) {
-        koopa_ofs << "global @" << ident << " = alloc ";
+        ir_builder.global_alloc("@" + ident, ty, aggregate_array(indices, array, 0, index));
     }
+    // 局部数组
     else {
-        koopa_ofs << "\t@" << ident << " = alloc ";
+        ir_builder.alloc("@" + ident, ty);
+        // 基址初始化为 -1，方便后续特判最外层
+        vector<int> bases;
+        bases.push_back(-1);
+        store_array(ident, indices, array, 0, index, bases);
     }
-    format_array_type(indices);
 }
 
 /**
- * @brief 打印数组初始化值 aggregate，如 {{1, 2, 3}, {4, 5, 6}}
+ * @brief 定义不带初始化值的数组
  * @param[in] ident 数组名
  * @param[in] indices 数组维度
- * @param[in] array 初始化值
- * @param[in] level 当前维度
- * @param[in] index 当前值索引
- * @param[in] bases 基址
+ * @note 全局数组可以用 zeroinit 初始化，局部数组不能用 zeroinit 初始化
  */
-void print_array(const string& ident, const vector<int>& indices, int* array, int level, int& index, vector<int>& bases) {
-    // 全局数组
+void print_array(const string& ident, const vector<int>& indices) {
+    auto ty = ir_builder.array_type(indices);
     if (environment_manager.is_global) {
-        // 初始条件特判
-        if (index == 0 && level == 0) {
-            koopa_ofs << ", ";
-        }
-        // 最内层数组
-        if (level == indices.size() - 1) {
-            koopa_ofs << "{";
-            for (int i = 0;i < indices[level];i++) {
-                if (i != 0) {
-                    koopa_ofs << ", ";
-                }
-                koopa_ofs << array[index];
-                index++;
-            }
-            koopa_ofs << "}";
-        }
-        // 非最内层数组，嵌套 aggregate
-        else {
-            koopa_ofs << "{";
-            for (int i = 0;i < indices[level];i++) {
-                if (i != 0) {
-                    koopa_ofs << ", ";
-                }
-                print_array(ident, indices, array, level + 1, index, bases);
-            }
-            koopa_ofs << "}";
-        }
+        ir_builder.global_alloc("@" + ident, ty, ir_builder.zero_init(ty));
     }
-    // 局部数组
     else {
-        // 初始条件特判
-        if (index == 0 && level == 0) {
-            koopa_ofs << endl;
-        }
-        // 最内层数组
-        if (level == indices.size() - 1) {
-            int base = bases.back();
-            for (int i = 0;i < indices[level];i++) {
-                int ptr = environment_manager.get_temp_count();
-                if (base == -1) {
-                    koopa_ofs << "\t%" << ptr << " = getelemptr @" << ident << ", " << i << endl;
-                }
-                else {
-                    koopa_ofs << "\t%" << ptr << " = getelemptr %" << base << ", " << i << endl;
-                }
-                koopa_ofs << "\tstore " << array[index] << ", %" << ptr << endl;
-                index++;
-            }
-        }
-        // 非最内层数组，嵌套 aggregate
-        else {
-            int base = bases.back();
-            for (int i = 0;i < indices[level];i++) {
-                int ptr = environment_manager.get_temp_count();
-                if (base == -1) {
-                    koopa_ofs << "\t%" << ptr << " = getelemptr @" << ident << ", " << i << endl;
-                }
-                else {
-                    koopa_ofs << "\t%" << ptr << " = getelemptr %" << base << ", " << i << endl;
-                }
-                bases.push_back(ptr);
-                print_array(ident, indices, array, level + 1, index, bases);
-                bases.pop_back();
-            }
-        }
+        ir_builder.alloc("@" + ident, ty);
     }
 }
@@ -1,47 +1,74 @@
 #pragma once
 
-#include "koopa.h"
 #include <cassert>
 #include <cstring>
 #include <iostream>
 #include <fstream>
 #include <unordered_map>
+#include "include/ir.hpp"
 #include "include/backend_utils.hpp"
 #include "include/other_utils.hpp"
+#include "include/timer.hpp"
 
 using namespace std;
 
 // 文件读写流的全局变量
 
-extern ofstream koopa_ofs;
-extern ofstream riscv_ofs;
+extern OutputWriter riscv_ofs;
+
+// 编译模式与优化级别，-perf 模式下使用线性扫描分配寄存器，-O2 时使用图着色分配寄存器
+
+extern string mode;
+extern int opt_level;
+
+// 乘法指令的延迟，以单周期指令为单位，乘常数的移位加减序列比 li 加 mul 更快时才展开
+
+extern int mul_latency;
+
+// 是否输出统计信息，包括每个函数栈帧的缩减情况
+
+extern bool stats;
 
 // 不会存储值到栈上的指令
 
-void visit(const koopa_raw_program_t& program);
-void visit(const koopa_raw_slice_t& slice);
-void visit(const koopa_raw_function_t& func);
-void visit(const koopa_raw_basic_block_t& bb);
-void visit(const koopa_raw_value_t& value);
-void visit(const koopa_raw_aggregate_t& aggregate);
-void visit(const koopa_raw_store_t& store);
-void visit(const koopa_raw_return_t& ret);
-void visit(const koopa_raw_branch_t& branch);
-void visit(const koopa_raw_jump_t& jump);
+void visit(const Program& program);
+void visit(const Function* func);
+void visit(const BasicBlock* bb);
+void visit(const Instruction* inst);
+void visit(const Aggregate* aggregate);
+void visit(const Store* store);
+void visit(const Return* ret);
+void visit(const Branch* branch);
+void visit(const Jump* jump);
 
 // 会存储值到栈上的指令
 
-void visit(const koopa_raw_global_alloc_t& global_alloc, const koopa_raw_value_t& value);
-void visit(const koopa_raw_get_ptr_t& get_ptr, const koopa_raw_value_t& value);
-void visit(const koopa_raw_get_elem_ptr_t& get_elem_ptr, const koopa_raw_value_t& value);
-void visit(const koopa_raw_call_t& call, const koopa_raw_value_t& value);
-void visit(const koopa_raw_load_t& load, const koopa_raw_value_t& value);
-void visit(const koopa_raw_binary_t& binary, const koopa_raw_value_t& value);
+void visit(const GlobalAlloc* global_alloc);
+void visit(const GetPtr* get_ptr);
+void visit(const GetElemPtr* get_elem_ptr);
+void visit(const Call* call);
+void visit(const Load* load);
+void visit(const Binary* binary);
 
-// 没有数据体，但是会分配栈空间
+// 序言与尾声
 
-void alloc(const koopa_raw_value_t& value);
+void prologue();
+void epilogue();
 
-// 获取 value 所占用空间大小的辅助函数
+// 参数传递
+
+void parallel_move(const vector<pair<Reg, Reg>>& moves);
+void receive_params(const Function* func);
+void pass_block_args(const Jump* jump);
+
+// 立即数运算
+
+bool binary_imm(const Binary* binary);
+
+// 指针偏移计算
+
+Reg offset_pointer(const Value* value, Reg base, const Value* index, int size);
+
+// 没有数据体，但是会分配栈空间
 
-int get_alloc_size(const koopa_raw_type_t ty);
\ No newline at end of file
+void alloc(const Alloc* alloc);
\ No newline at end of file
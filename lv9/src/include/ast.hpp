@@ -11,29 +11,59 @@
 #include <cassert>
 #include <typeinfo>
 #include "include/frontend_utils.hpp"
+#include "include/builder.hpp"
 
 using namespace std;
 
 extern string mode;
-extern ofstream koopa_ofs;
-extern ofstream riscv_ofs;
+extern OutputWriter riscv_ofs;
 
 /**
  * @brief 所有 AST 的基类
+ * @note 所有 AST 节点都分配在 `ast_arena` 中，节点之间用裸指针相连，生成 IR 后随内存池一次性释放
  */
 class BaseAST {
 public:
     virtual ~BaseAST() = default;
     virtual Result print() const = 0;
+    // 按标识符编号标记语句中被赋值的变量名，不区分作用域
+    virtual void mark_assigned(vector<bool>& assigned) const {}
 };
 
+// AST 内存池，持有所有 AST 节点及节点列表
+extern Arena ast_arena;
+
+/**
+ * @brief AST 列表分配器，列表元素连续存放在 `ast_arena` 中
+ * @note 单个列表扩容时旧的缓冲区不单独归还，随内存池一次性释放
+ */
+template <typename T>
+class ASTAllocator {
+public:
+    using value_type = T;
+    ASTAllocator() = default;
+    template <typename U>
+    ASTAllocator(const ASTAllocator<U>&) {}
+    T* allocate(size_t n) {
+        return static_cast<T*>(ast_arena.allocate(sizeof(T) * n, alignof(T)));
+    }
+    void deallocate(T*, size_t) {}
+    template <typename U>
+    bool operator==(const ASTAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const ASTAllocator<U>&) const { return false; }
+};
+
+// AST 节点列表
+using ASTList = vector<BaseAST*, ASTAllocator<BaseAST*>>;
+
 /**
  * @brief 程序 AST 类
  */
 class ProgramAST : public BaseAST {
 public:
     //  程序单元，全局变量或函数定义
-    vector<unique_ptr<BaseAST>> comp_units;
+    ASTList comp_units;
     Result print() const override;
 };
 
@@ -49,11 +79,11 @@ public:
     };
     FuncType func_type;
     // 函数名
-    string ident;
+    Ident ident;
     // 函数参数列表
-    vector<unique_ptr<BaseAST>>* func_f_params;
+    ASTList* func_f_params;
     // 函数体
-    unique_ptr<BaseAST> block;
+    BaseAST* block = nullptr;
     Result print() const override;
 };
 
@@ -63,13 +93,15 @@ public:
 class FuncFParamAST : public BaseAST {
 public:
     // 参数名
-    string ident;
+    Ident ident;
     // 是否为数组参数
     bool is_array;
     // 数组下标
-    vector<unique_ptr<BaseAST>>* array_index;
+    ASTList* array_index;
+    // 是否在函数体内被重新赋值，未被赋值的普通参数直接使用传入的值
+    bool is_assigned = true;
     // 在函数签名内打印
-    void as_param() const;
+    const Type* as_param() const;
     // 在函数体内打印
     Result print() const override;
 };
@@ -80,8 +112,9 @@ public:
 class BlockAST : public BaseAST {
 public:
     // 基本块内容
-    vector<unique_ptr<BaseAST>> block_items;
+    ASTList block_items;
     Result print() const override;
+    void mark_assigned(vector<bool>& assigned) const override;
 };
 
 /**
@@ -90,7 +123,7 @@ public:
 class ConstDeclAST : public BaseAST {
 public:
     // 常量定义列表
-    vector<unique_ptr<BaseAST>> const_defs;
+    ASTList const_defs;
     Result print() const override;
 };
 
@@ -100,11 +133,11 @@ public:
 class ConstDefAST : public BaseAST {
 public:
     // 常量名
-    string ident;
+    Ident ident;
     // 数组下标列表
-    vector<unique_ptr<BaseAST>>* array_index;
+    ASTList* array_index;
     // 初始化常量值
-    unique_ptr<BaseAST> value;
+    BaseAST* value = nullptr;
     Result print() const override;
 };
 
@@ -114,9 +147,9 @@ public:
 class ConstInitValAST : public BaseAST {
 public:
     // 常量表达式
-    optional<unique_ptr<BaseAST>> const_exp;
+    optional<BaseAST*> const_exp;
     // 初始化常量值列表，即 KoopaIR 中的 aggregate
-    optional<vector<unique_ptr<BaseAST>>> init_values;
+    optional<ASTList> init_values;
     // 初始化数组常量值
     void init(const vector<int>& indices, int*& arr, int& cur, int align);
     // 打印数组常量初始化值
@@ -131,7 +164,7 @@ public:
 class ConstExpAST : public BaseAST {
 public:
     // 常量表达式
-    unique_ptr<BaseAST> exp;
+    BaseAST* exp = nullptr;
     Result print() const override;
 };
 
@@ -141,7 +174,7 @@ public:
 class VarDeclAST : public BaseAST {
 public:
     // 变量定义列表
-    vector<unique_ptr<BaseAST>> var_defs;
+    ASTList var_defs;
     Result print() const override;
 };
 
@@ -151,11 +184,11 @@ public:
 class VarDefAST : public BaseAST {
 public:
     // 变量名
-    string ident;
+    Ident ident;
     // 数组下标列表
-    vector<unique_ptr<BaseAST>>* array_index;
+    ASTList* array_index;
     // 初始化变量值，可为空
-    optional<unique_ptr<BaseAST>> value;
+    optional<BaseAST*> value;
     Result print() const override;
 };
 
@@ -165,9 +198,9 @@ public:
 class InitValAST : public BaseAST {
 public:
     // 初始化表达式
-    optional<unique_ptr<BaseAST>> exp;
+    optional<BaseAST*> exp;
     // 初始化值列表，即 KoopaIR 中的 aggregate
-    optional<vector<unique_ptr<BaseAST>>> init_values;
+    optional<ASTList> init_values;
     // 初始化数组变量值
     void init(const vector<int>& indices, int* arr, int& cur, int align);
     // 打印数组变量初始化值
@@ -182,12 +215,13 @@ public:
 class StmtIfAST : public BaseAST {
 public:
     // 条件表达式
-    unique_ptr<BaseAST> exp;
+    BaseAST* exp = nullptr;
     // then 语句块
-    unique_ptr<BaseAST> then_stmt;
+    BaseAST* then_stmt = nullptr;
     // else 语句块，可为空
-    optional<unique_ptr<BaseAST>> else_stmt;
+    optional<BaseAST*> else_stmt;
     Result print() const override;
+    void mark_assigned(vector<bool>& assigned) const override;
 };
 
 /**
@@ -196,10 +230,11 @@ public:
 class StmtWhileAST : public BaseAST {
 public:
     // 条件表达式
-    unique_ptr<BaseAST> exp;
+    BaseAST* exp = nullptr;
     // 循环体语句块
-    unique_ptr<BaseAST> stmt;
+    BaseAST* stmt = nullptr;
     Result print() const override;
+    void mark_assigned(vector<bool>& assigned) const override;
 };
 
 /**
@@ -225,10 +260,11 @@ public:
 class StmtAssignAST : public BaseAST {
 public:
     // 左值
-    unique_ptr<BaseAST> l_val;
+    BaseAST* l_val = nullptr;
     // 右值
-    unique_ptr<BaseAST> exp;
+    BaseAST* exp = nullptr;
     Result print() const override;
+    void mark_assigned(vector<bool>& assigned) const override;
 };
 
 /**
@@ -237,7 +273,7 @@ public:
 class StmtExpAST : public BaseAST {
 public:
     // 表达式，可为空，即单条 ';' 语句
-    optional<unique_ptr<BaseAST>> exp;
+    optional<BaseAST*> exp;
     Result print() const override;
 };
 
@@ -247,7 +283,7 @@ public:
 class StmtReturnAST : public BaseAST {
 public:
     // 返回值，可为空
-    optional<unique_ptr<BaseAST>> exp;
+    optional<BaseAST*> exp;
     Result print() const override;
 };
 
@@ -257,9 +293,9 @@ public:
 class LValAST : public BaseAST {
 public:
     // 变量名
-    string ident;
+    Ident ident;
     // 数组下标列表，可为空列表
-    vector<unique_ptr<BaseAST>>* array_index;
+    ASTList* array_index;
     // 打印左值
     Result print() const override;
 };
@@ -270,7 +306,7 @@ public:
 class ExpAST : public BaseAST {
 public:
     // 逻辑或表达式
-    unique_ptr<BaseAST> l_or_exp;
+    BaseAST* l_or_exp = nullptr;
     Result print() const override;
 };
 
@@ -280,7 +316,7 @@ public:
 class LOrExpAST : public BaseAST {
 public:
     // 逻辑与表达式
-    unique_ptr<BaseAST> l_and_exp;
+    BaseAST* l_and_exp = nullptr;
     Result print() const override;
 };
 
@@ -290,7 +326,7 @@ public:
 class LAndExpAST : public BaseAST {
 public:
     // 等值表达式
-    unique_ptr<BaseAST> eq_exp;
+    BaseAST* eq_exp = nullptr;
     Result print() const override;
 };
 
@@ -306,9 +342,9 @@ public:
     };
     LogicalOp logical_op;
     // 左操作数
-    unique_ptr<BaseAST> left;
+    BaseAST* left = nullptr;
     // 右操作数
-    unique_ptr<BaseAST> right;
+    BaseAST* right = nullptr;
     Result print() const override;
 };
 
@@ -318,7 +354,7 @@ public:
 class EqExpAST : public BaseAST {
 public:
     // 关系表达式
-    unique_ptr<BaseAST> rel_exp;
+    BaseAST* rel_exp = nullptr;
     Result print() const override;
 };
 
@@ -334,11 +370,11 @@ public:
     };
     EqOp eq_op;
     // 左操作数
-    unique_ptr<BaseAST> left;
+    BaseAST* left = nullptr;
     // 右操作数
-    unique_ptr<BaseAST> right;
-    // 将字符串形式的运算符转换为等值运算符
-    EqOp convert(const string& op) const;
+    BaseAST* right = nullptr;
+    // 将 lexer 返回的运算符转换为等值运算符
+    EqOp convert(Operator op) const;
     Result print() const override;
 };
 
@@ -348,7 +384,7 @@ public:
 class RelExpAST : public BaseAST {
 public:
     // 加法表达式
-    unique_ptr<BaseAST> add_exp;
+    BaseAST* add_exp = nullptr;
     Result print() const override;
 };
 
@@ -366,11 +402,11 @@ public:
     };
     RelOp rel_op;
     // 左操作数
-    unique_ptr<BaseAST> left;
+    BaseAST* left = nullptr;
     // 右操作数
-    unique_ptr<BaseAST> right;
-    // 将字符串形式的运算符转换为关系运算符
-    RelOp convert(const string& op) const;
+    BaseAST* right = nullptr;
+    // 将 lexer 返回的运算符转换为关系运算符
+    RelOp convert(Operator op) const;
     Result print() const override;
 };
 
@@ -380,7 +416,7 @@ public:
 class AddExpAST : public BaseAST {
 public:
     // 乘法表达式
-    unique_ptr<BaseAST> mul_exp;
+    BaseAST* mul_exp = nullptr;
     Result print() const override;
 };
 
@@ -396,11 +432,11 @@ public:
     };
     AddOp add_op;
     // 左操作数
-    unique_ptr<BaseAST> left;
+    BaseAST* left = nullptr;
     // 右操作数
-    unique_ptr<BaseAST> right;
-    // 将字符串形式的运算符转换为加法运算符
-    AddOp convert(const string& op) const;
+    BaseAST* right = nullptr;
+    // 将 lexer 返回的运算符转换为加法运算符
+    AddOp convert(Operator op) const;
     Result print() const override;
 };
 
@@ -410,7 +446,7 @@ public:
 class MulExpAST : public BaseAST {
 public:
     // 一元表达式
-    unique_ptr<BaseAST> unary_exp;
+    BaseAST* unary_exp = nullptr;
     Result print() const override;
 };
 
@@ -427,11 +463,11 @@ public:
     };
     MulOp mul_op;
     // 左操作数
-    unique_ptr<BaseAST> left;
+    BaseAST* left = nullptr;
     // 右操作数
-    unique_ptr<BaseAST> right;
-    // 将字符串形式的运算符转换为乘法运算符
-    MulOp convert(const string& op) const;
+    BaseAST* right = nullptr;
+    // 将 lexer 返回的运算符转换为乘法运算符
+    MulOp convert(Operator op) const;
     Result print() const override;
 };
 
@@ -441,7 +477,7 @@ public:
 class UnaryExpAST : public BaseAST {
 public:
     // 优先表达式
-    unique_ptr<BaseAST> primary_exp;
+    BaseAST* primary_exp = nullptr;
     Result print() const override;
 };
 
@@ -458,9 +494,9 @@ public:
     };
     UnaryOp unary_op;
     // 一元表达式
-    unique_ptr<BaseAST> unary_exp;
-    // 将字符串形式的运算符转换为一元运算符
-    UnaryOp convert(const string& op) const;
+    BaseAST* unary_exp = nullptr;
+    // 将 lexer 返回的运算符转换为一元运算符
+    UnaryOp convert(Operator op) const;
     Result print() const override;
 };
 
@@ -470,9 +506,9 @@ public:
 class UnaryExpWithFuncCallAST : public BaseAST {
 public:
     // 函数名
-    string ident;
+    Ident ident;
     // 函数实参列表
-    vector<unique_ptr<BaseAST>>* func_r_params;
+    ASTList* func_r_params;
     Result print() const override;
 };
 
@@ -482,7 +518,7 @@ public:
 class PrimaryExpAST : public BaseAST {
 public:
     // 表达式
-    unique_ptr<BaseAST> exp;
+    BaseAST* exp = nullptr;
     Result print() const override;
 };
 
@@ -502,6 +538,6 @@ public:
 class PrimaryExpWithLValAST : public BaseAST {
 public:
     // 左值
-    unique_ptr<BaseAST> l_val;
+    BaseAST* l_val = nullptr;
     Result print() const override;
 };
\ No newline at end of file
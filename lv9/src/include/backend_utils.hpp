@@ -1,81 +1,118 @@
 #pragma once
-#include "koopa.h"
 #include <cassert>
 #include <cstring>
 #include <iostream>
 #include <fstream> 
 #include <cmath>
 #include <unordered_map>
+#include <deque>
+#include "include/ir.hpp"
 #include "include/other_utils.hpp"
+#include "include/machine.hpp"
+#include "include/regalloc.hpp"
 #include "include/asm.hpp"
 
 using namespace std;
 
-void parse_riscv(const char* koopa_ir);
+void generate_riscv(const Program& program);
 int is_power_of_two(int x);
+bool is_imm12(int imm);
 
 /**
  * @brief Riscv 类，用于生成 Riscv 汇编代码
- * @note - 包含 Riscv 汇编代码的生成方法
+ * @note - 数据段的宏直接输出，代码段的指令先追加到当前函数的机器指令列表 `func` 中，函数翻译完成后统一输出
  * @note - 会自动处理偏置量，使之不超过 12 位限制
  */
 class Riscv {
 public:
-    // 特殊语句
+    // 当前正在翻译的函数
+    MachineFunction func;
+
+    void begin_function(const Function* func);
+    void end_function();
+    int block_label(const BasicBlock* bb);
+
+    // 数据段
 
     void _data();
-    void _text();
     void _globl(const string& name);
     void _word(const int& value);
     void _zero(const int& len);
     void _label(const string& name);
 
+    // 标号
+
+    void _label(int label);
+
     // 单目运算
 
-    void _seqz(const string& rd, const string& rs1);
-    void _snez(const string& rd, const string& rs1);
-    void _li(const string& rd, const int& imm);
-    void _mv(const string& rd, const string& rs1);
-    void _la(const string& rd, const string& rs1);
+    void _seqz(Reg rd, Reg rs1);
+    void _snez(Reg rd, Reg rs1);
+    void _li(Reg rd, const int& imm);
+    void _mv(Reg rd, Reg rs1);
+    void _la(Reg rd, const char* symbol);
 
     // 双目运算
 
-    void _or(const string& rd, const string& rs1, const string& rs2);
-    void _and(const string& rd, const string& rs1, const string& rs2);
-    void _xor(const string& rd, const string& rs1, const string& rs2);
-    void _add(const string& rd, const string& rs1, const string& rs2);
-    void _addi(const string& rd, const string& rs1, const int& imm);
-    void _sub(const string& rd, const string& rs1, const string& rs2);
-    void _mul(const string& rd, const string& rs1, const string& rs2);
-    void _div(const string& rd, const string& rs1, const string& rs2);
-    void _rem(const string& rd, const string& rs1, const string& rs2);
-    void _sgt(const string& rd, const string& rs1, const string& rs2);
-    void _slt(const string& rd, const string& rs1, const string& rs2);
-    void _sll(const string& rd, const string& rs1, const string& rs2);
+    void _or(Reg rd, Reg rs1, Reg rs2);
+    void _and(Reg rd, Reg rs1, Reg rs2);
+    void _xor(Reg rd, Reg rs1, Reg rs2);
+    void _add(Reg rd, Reg rs1, Reg rs2);
+    void _sub(Reg rd, Reg rs1, Reg rs2);
+    void _mul(Reg rd, Reg rs1, Reg rs2);
+    void _mulh(Reg rd, Reg rs1, Reg rs2);
+    void _div(Reg rd, Reg rs1, Reg rs2);
+    void _rem(Reg rd, Reg rs1, Reg rs2);
+    void _sgt(Reg rd, Reg rs1, Reg rs2);
+    void _slt(Reg rd, Reg rs1, Reg rs2);
+    void _sll(Reg rd, Reg rs1, Reg rs2);
+
+    // 立即数运算
+
+    void _addi(Reg rd, Reg rs1, const int& imm);
+    void _andi(Reg rd, Reg rs1, const int& imm);
+    void _ori(Reg rd, Reg rs1, const int& imm);
+    void _xori(Reg rd, Reg rs1, const int& imm);
+    void _slti(Reg rd, Reg rs1, const int& imm);
+    void _slli(Reg rd, Reg rs1, const int& shamt);
+    void _srli(Reg rd, Reg rs1, const int& shamt);
+    void _srai(Reg rd, Reg rs1, const int& shamt);
+    void _muli(Reg rd, Reg rs1, const int& imm, bool allow_temp = true);
+    void _divi(Reg rd, Reg rs1, const int& imm);
+    void _remi(Reg rd, Reg rs1, const int& imm);
 
     // 访存
 
-    void _lw(const string& rd, const string& base, const int& bias);
-    void _sw(const string& rs, const string& base, const int& bias);
+    void _lw(Reg rd, Reg base, const int& bias);
+    void _sw(Reg rs, Reg base, const int& bias);
 
     // 分支
 
-    void _bnez(const string& cond, const string& label);
-    void _beqz(const string& cond, const string& label);
-    void _jump(const string& label);
+    void _bnez(Reg cond, int label);
+    void _beqz(Reg cond, int label);
+    void _beq(Reg rs1, Reg rs2, int label);
+    void _bne(Reg rs1, Reg rs2, int label);
+    void _blt(Reg rs1, Reg rs2, int label);
+    void _bge(Reg rs1, Reg rs2, int label);
+    void _jump(int label);
 
     // 调用与返回
 
-    void _call(const string& ident);
+    void _call(const char* ident);
     void _ret();
+
+private:
+    void mul_sequence(Reg rd, Reg rs1, long long c, bool allow_factor);
+    void div_quotient(Reg q, Reg rs1, int d, Reg tmp);
 };
 
 /**
  * @brief Context 类，用于管理栈空间
  * @note - `stack_size`：栈空间大小
  * @note - `stack_used`：栈空间已使用大小
- * @note - `save_ra`：是否需要保存返回地址，即内部是否有函数调用
- * @note - `stack_map`：栈空间映射，用于存储先前的计算值到栈上的偏移量
+ * @note - `saved_regs`：序言中保存、返回前恢复的寄存器及其栈偏移，包括返回地址 ra 与用到的被调用者保存寄存器
+ * @note - `stack_map`：栈空间映射，按值的编号存储先前的计算值到栈上的偏移量
+ * @note - `frame_block` / `framed`：序言所在的基本块编号，以及按基本块编号标记是否在序言之后执行
  */
 class Context {
 public:
@@ -83,15 +120,17 @@ public:
     int stack_size;
     // 栈空间已使用大小
     int stack_used = 0;
-    // 是否需要保存返回地址
-    bool save_ra = false;
-    // 栈空间映射，用于存储先前的计算值到栈上的偏移量
-    unordered_map<koopa_raw_value_t, int> stack_map;
+    // 序言中保存的寄存器及其栈偏移
+    vector<pair<Reg, int>> saved_regs;
+    // 栈空间映射，按值的编号存储先前的计算值到栈上的偏移量
+    vector<int> stack_map;
+    // 序言所在的基本块编号
+    int frame_block = 0;
+    // 按基本块编号标记是否在序言之后执行
+    vector<bool> framed;
     // 构造函数
     Context() : stack_size(0) {}
-    Context(int stack_size) : stack_size(stack_size) {}
-    // 将 value 推入栈中，并记录其偏移量
-    void push(const koopa_raw_value_t& value, int bias);
+    Context(int stack_size, int value_count) : stack_size(stack_size), stack_map(value_count, 0) {}
 };
 
 /**
@@ -101,41 +140,63 @@ public:
 class ContextManager {
 private:
     int global_count = 0;
-    // bnez 和 beqz 使用，目的是防止跳转范围过大，转换为 jump 指令
-    int branch_count = 0;
 public:
     // Context 映射，用于管理 Context 的使用情况，函数名映射到 Context
     unordered_map<string, Context> context_map;
-    // 全局变量映射，用于管理全局变量的使用情况，遇到 global_alloc 指令时会存储
-    unordered_map<koopa_raw_value_t, string> global_map;
-    void create_context(const string& name, int stack_size);
-    void create_global(const koopa_raw_value_t& value);
+    // 全局变量名，deque 追加时不会移动已有的名字，机器指令可以直接引用
+    deque<string> global_names;
+    // 全局变量映射，按全局变量的编号存储其汇编标号，遇到 global_alloc 指令时会存储
+    vector<const char*> global_map;
+    void create_context(const string& name, int stack_size, int value_count);
+    void create_global(const Value* value);
     Context& get_context(const string& name);
-    string get_global(const koopa_raw_value_t& value);
-    string get_branch_label();
-    string get_branch_end_label();
+    const char* get_global(const Value* value);
 };
 
 /**
  * @brief RegisterManager 类，用于管理寄存器
- * @note - `reg_count`：寄存器计数器
- * @note - `reg_map`：寄存器映射，用于管理指令到寄存器的映射。
+ * @note - `reg_map`：寄存器映射，按值的编号管理指令到寄存器的映射。
+ * @note - 临时寄存器 t0 ~ t3 在基本块内缓存最近计算或加载的值，后续指令可以直接复用，不必再从栈上加载
+ * @note - `uses_left` / `live_out`：按值的编号存储剩余使用次数，以及是否在其他基本块中使用
  */
 class RegisterManager {
+public:
+    // 单条指令内可用的临时寄存器个数，即 t0 ~ t3
+    static constexpr int SCRATCH_COUNT = 4;
 private:
-    // 寄存器计数器
-    int reg_count = 0;
+    // 临时寄存器中缓存的值，空闲时为空
+    const Value* cached[SCRATCH_COUNT] = {};
+    // 缓存的值是否尚未写回栈上
+    bool dirty[SCRATCH_COUNT] = {};
+    // 是否被当前指令占用
+    bool pinned[SCRATCH_COUNT] = {};
+    // 最近一次被使用的时刻
+    int last_used[SCRATCH_COUNT] = {};
+    int clock = 0;
+    vector<int> uses_left;
+    vector<bool> live_out;
+    int scratch_index(Reg reg) const;
+    int pick_scratch();
+    void evict(int index);
 public:
-    // 寄存器映射，用于管理指令到寄存器的映射，一般是在连续调用时使用
-    unordered_map<koopa_raw_value_t, string> reg_map;
-    string cur_reg();
-    string new_reg();
-    string tmp_reg();
-    bool get_operand_reg(const koopa_raw_value_t& value);
+    // 寄存器映射，按值的编号管理指令到寄存器的映射，一般是在连续调用时使用
+    vector<Reg> reg_map;
+    Reg new_reg();
+    Reg tmp_reg();
+    Reg find_cached(const Value* value);
+    bool get_operand_reg(const Value* value);
+    void load_operand(Reg target, const Value* value);
+    void rematerialize(Reg target, const Value* value);
+    Reg result_reg(const Value* value);
+    void save_result(const Value* value, Reg reg);
     void reset();
+    void release(const Instruction* inst);
+    void flush();
+    void begin_block();
+    void begin_function(const Function* func);
 };
 
-extern ofstream riscv_ofs;
+extern OutputWriter riscv_ofs;
 extern Riscv riscv;
 extern Context context;
 extern ContextManager context_manager;
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cassert>
+#include "include/ir.hpp"
+#include "include/frontend_utils.hpp"
+
+using namespace std;
+
+/**
+ * @brief 操作数类，统一表示前端指令的操作数
+ * @note - `result`：前端计算结果，立即数 IMM / 临时寄存器 REG
+ * @note - `symbol`：具名符号，如 @x_1、@x、%short_result_0
+ * @note - `is_symbol`：是否为具名符号
+ */
+class Operand {
+public:
+    Result result;
+    string symbol;
+    bool is_symbol;
+    Operand(const Result& result) : result(result), is_symbol(false) {}
+    Operand(const string& symbol) : symbol(symbol), is_symbol(true) {}
+};
+
+/**
+ * @brief IR 构建器，由 AST 直接在内存中构建 Program
+ * @note - 前端的临时寄存器 %n 通过 `regs` 映射到对应的值
+ * @note - 具名符号先在当前函数的 `symbols` 中查找，再在 `globals` 中查找
+ * @note - 基本块按名字惰性创建，遇到 label 时才按顺序加入当前函数
+ */
+class IRBuilder {
+private:
+    Program program;
+
+    // 全局符号：函数与全局变量
+    unordered_map<string, Function*> function_map;
+    unordered_map<string, Value*> globals;
+
+    // 当前函数的状态
+    Function* cur_func = nullptr;
+    BasicBlock* cur_bb = nullptr;
+    unordered_map<string, Value*> symbols;
+    unordered_map<string, BasicBlock*> block_map;
+    vector<Value*> regs;
+
+    Value* value(const Operand& operand);
+    BasicBlock* block(const string& name);
+    template <typename T, typename... Args>
+    T* append(int num_operands, Args&&... args);
+    void define(const Result& dst, Value* value);
+public:
+    // 类型
+
+    const Type* int_type();
+    const Type* unit_type();
+    const Type* pointer_type(const Type* base);
+    const Type* array_type(const vector<int>& indices);
+
+    // 全局定义
+
+    void declare(const string& name, const vector<const Type*>& params, const Type* ret);
+    void begin_function(const string& name, const vector<pair<string, const Type*>>& params, const Type* ret);
+    void end_function();
+    Value* integer(int value);
+    Value* zero_init(const Type* ty);
+    Value* aggregate(const Type* ty, const vector<Value*>& elems);
+    void global_alloc(const string& name, const Type* ty, Value* init);
+
+    // 基本块与指令
+
+    void label(const string& name);
+    void alloc(const string& name, const Type* ty);
+    void alias(const Result& dst, const Operand& src);
+    void load(const Result& dst, const Operand& src);
+    void store(const Operand& value, const Operand& dest);
+    void get_ptr(const Result& dst, const Operand& src, const Operand& index);
+    void get_elem_ptr(const Result& dst, const Operand& src, const Operand& index);
+    void binary(const Result& dst, BinaryOp op, const Operand& lhs, const Operand& rhs);
+    void branch(const Operand& cond, const string& true_label, const string& false_label);
+    void jump(const string& label);
+    void call(const Result& dst, const string& callee, const vector<Result>& args);
+    void call(const string& callee, const vector<Result>& args);
+    void ret(const Operand& value);
+    void ret();
+
+    // 构建完成
+
+    Program& build();
+};
+
+extern IRBuilder ir_builder;
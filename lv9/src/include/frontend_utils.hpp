@@ -7,16 +7,71 @@
 #include <optional>
 #include <vector>
 #include <unordered_map>
+#include <deque>
+#include <string_view>
 #include <cassert>
 
 using namespace std;
 
+/**
+ * @brief 运算符，由 lexer 直接返回，parser 无需再比较字符串
+ */
+enum class Operator {
+    EQ,
+    NEQ,
+    LT,
+    GT,
+    LE,
+    GE,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    NOT,
+    AND,
+    OR
+};
+
+/**
+ * @brief 标识符，字符串池中驻留的句柄，相同的标识符句柄相同
+ * @note - `id`：标识符在字符串池中的编号，可用于按编号开辟辅助表
+ * @note 需要放在 parser 的 union 中，所以保持为平凡类型
+ */
+class Ident {
+public:
+    int id;
+    const string& str() const;
+    operator const string& () const { return str(); }
+    bool operator==(const Ident& other) const { return id == other.id; }
+    bool operator!=(const Ident& other) const { return id != other.id; }
+};
+
+/**
+ * @brief 字符串池，整个编译过程中驻留所有标识符，每个不同的标识符只存一份
+ * @note - `strings`：驻留的字符串，deque 保证追加时已有元素地址不变
+ * @note - `index`：字符串到编号的索引，键引用 `strings` 中的字符串
+ */
+class StringPool {
+private:
+    deque<string> strings;
+    unordered_map<string_view, int> index;
+public:
+    Ident intern(const char* text, size_t len);
+    Ident intern(const string& text);
+    const string& str(int id) const;
+    int size() const;
+};
+
+extern StringPool string_pool;
+
 /**
  * @brief 符号类，表示变量或常量
- * @note - `type`：符号的类型，变量 VAR / 常量 VAL / 数组 ARR / 指针 PTR
+ * @note - `type`：符号的类型，变量 VAR / 常量 VAL / 数组 ARR / 指针 PTR / 参数 ARG
  * @note - `value`：符号的值
  * @note    1. 对于 ARR 和 PTR 类型，value 表示数组或指针的维度
  * @note    2. 对于 VAR 和 VAL 类型，value 表示变量或常量的值
+ * @note    3. ARG 为函数体内没有被重新赋值的普通参数，直接使用传入的值，不分配栈空间
  */
 class Symbol {
 public:
@@ -24,7 +79,8 @@ public:
         VAR,
         VAL,
         ARR,
-        PTR
+        PTR,
+        ARG
     };
     Type type;
     // 对于 ARR 和 PTR 类型，value 表示数组或指针的维度
@@ -41,28 +97,48 @@ public:
 #define VAL_(value) Symbol(Symbol::Type::VAL, value)
 #define ARR_(value) Symbol(Symbol::Type::ARR, value)
 #define PTR_(value) Symbol(Symbol::Type::PTR, value)
+#define ARG_ Symbol(Symbol::Type::ARG, 0)
 
  /**
-  * @brief 符号表类，管理变量名和符号，实现为单向链表
-  * @note - `symbol_table`：符号表，存储变量名和符号
-  * @note - `depth`：符号表的深度
-  * @note - `is_returned`：包含符号表是否已经存在 return 语句，用于判断是否需要生成后续语句
-  * @note - `parent`：指向父级符号表的指针
+  * @brief 符号表类，所有作用域共用一张扁平的表，按标识符编号 O(1) 查找，退出作用域时按撤销日志恢复
+  * @note - `bindings`：绑定栈，同时也是撤销日志，每创建一个符号压入一条绑定，退出作用域时弹出
+  * @note - `visible`：按标识符编号索引，记录当前可见的最内层绑定在 `bindings` 中的下标，-1 表示不可见
+  * @note - `scopes`：作用域栈，记录进入作用域时绑定栈的高度，以及该作用域是否已经存在 return 语句
   */
 class SymbolTable {
 private:
-    unordered_map<string, Symbol> symbol_table;
+    struct Binding {
+        // 标识符
+        Ident ident;
+        // 带层级后缀的符号名，如 x_1
+        string name;
+        Symbol symbol;
+        // 所在作用域的深度
+        int depth;
+        // 被遮蔽的外层绑定下标，-1 表示没有
+        int shadowed;
+    };
+    struct Scope {
+        int mark;
+        bool is_returned;
+    };
+    vector<Binding> bindings;
+    vector<int> visible;
+    vector<Scope> scopes = { { 0, false } };
+
+    const Binding* find(Ident ident) const;
 public:
-    int depth = 0;
-    bool is_returned = false;
-    SymbolTable* parent = nullptr;
-
-    void create(const string& ident, Symbol symbol);
-    bool exist(const string& ident);
-    Symbol read(const string& ident);
-    void set_parent(SymbolTable* parent);
-    string locate(const string& ident);
-    string assign(const string& ident);
+    int depth() const;
+    void push_scope();
+    void pop_scope();
+    bool is_returned() const;
+    void set_returned(bool is_returned);
+
+    void create(Ident ident, Symbol symbol);
+    bool exist(Ident ident) const;
+    Symbol read(Ident ident) const;
+    const string& locate(Ident ident) const;
+    string assign(Ident ident) const;
 };
 
 /**
@@ -172,9 +248,6 @@ extern EnvironmentManager environment_manager;
 #define NEW_REG_ REG_(environment_manager.temp_count++)
 #define CUR_REG_ REG_(environment_manager.temp_count - 1)
 
-extern ofstream koopa_ofs;
-
 void init_lib();
-void format_array_type(const vector<int>& indices);
-void print_array_type(const string& ident, const vector<int>& indices);
-void print_array(const string& ident, const vector<int>& indices, int* array, int level, int& index, vector<int>& bases);
+void print_array(const string& ident, const vector<int>& indices, int* array);
+void print_array(const string& ident, const vector<int>& indices);
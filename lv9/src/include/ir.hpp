@@ -0,0 +1,463 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+#include <map>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+#include "include/writer.hpp"
+
+using namespace std;
+
+/**
+ * @brief 内存池（bump allocator），按块向系统申请内存，对象依次从块中切出，随内存池整体释放
+ * @note - `chunks`：已申请的内存块
+ * @note - `cur` / `end`：当前内存块中尚未使用的区间
+ * @note - `destructors`：需要析构的对象，释放内存池时逆序调用其析构函数
+ * @note - `alloc_count` / `byte_count`：已分配对象的个数与字节数，用于统计
+ */
+class Arena {
+private:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+    vector<char*> chunks;
+    char* cur = nullptr;
+    char* end = nullptr;
+    vector<pair<void (*)(void*), void*>> destructors;
+    size_t alloc_count = 0;
+    size_t byte_count = 0;
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+
+    void* allocate(size_t size, size_t align);
+    const char* strdup(const string& str);
+    void clear();
+    size_t allocations() const;
+    size_t bytes() const;
+
+    /**
+     * @brief 在内存池中构造一个对象，非平凡析构的对象会在释放内存池时析构
+     * @param[in] args 构造函数参数
+     * @return 对象指针
+     */
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if (!is_trivially_destructible<T>::value) {
+            destructors.push_back({ [](void* ptr) { static_cast<T*>(ptr)->~T(); }, obj });
+        }
+        return obj;
+    }
+
+    /**
+     * @brief 在内存池中分配一段连续数组，元素默认构造，要求元素可平凡析构
+     * @param[in] len 数组长度
+     * @return 数组首地址，长度为 0 时返回 nullptr
+     */
+    template <typename T>
+    T* make_array(size_t len) {
+        static_assert(is_trivially_destructible<T>::value, "arena arrays must be trivially destructible");
+        if (len == 0) {
+            return nullptr;
+        }
+        T* arr = static_cast<T*>(allocate(sizeof(T) * len, alignof(T)));
+        for (size_t i = 0; i < len; i++) {
+            new (arr + i) T();
+        }
+        return arr;
+    }
+};
+
+/**
+ * @brief 二元运算符，与 Koopa IR 的二元运算一一对应
+ */
+enum class BinaryOp {
+    NOT_EQ,
+    EQ,
+    GT,
+    LT,
+    GE,
+    LE,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    AND,
+    OR,
+    XOR,
+    SHL,
+    SHR,
+    SAR
+};
+
+/**
+ * @brief 类型，由 Program 统一创建并去重，相同结构的类型指针相同
+ * @note - `tag`：类型种类，整数 INT32 / 空 UNIT / 数组 ARRAY / 指针 POINTER / 函数 FUNCTION
+ * @note - `base`：数组元素类型或指针指向的类型
+ * @note - `len`：数组长度
+ * @note - `params` / `ret`：函数参数类型与返回值类型
+ */
+class Type {
+public:
+    enum class Tag {
+        INT32,
+        UNIT,
+        ARRAY,
+        POINTER,
+        FUNCTION
+    };
+    Tag tag;
+    const Type* base = nullptr;
+    int len = 0;
+    vector<const Type*> params;
+    const Type* ret = nullptr;
+    Type(Tag tag) : tag(tag) {}
+    int size() const;
+};
+
+class Value;
+class Instruction;
+class BasicBlock;
+class Function;
+
+/**
+ * @brief 一次使用（use），连接使用者指令与被使用的值
+ * @note - `value`：被使用的值
+ * @note - `user`：使用者指令
+ * @note - `prev` / `next`：被使用的值的使用者链表
+ */
+class Use {
+public:
+    Value* value = nullptr;
+    Instruction* user = nullptr;
+    Use* prev = nullptr;
+    Use* next = nullptr;
+    void set(Value* value);
+};
+
+/**
+ * @brief 值，IR 中所有可被使用的对象的基类
+ * @note - `kind`：值的种类，INSTRUCTION 及之后的种类均为指令
+ * @note - `ty`：值的类型
+ * @note - `name`：具名值的名字（带 @ 或 %），匿名值为 nullptr
+ * @note - `id`：稠密编号，函数内的值在函数内从 0 编号，全局变量在程序内从 0 编号
+ * @note - `uses`：使用者链表头
+ */
+class Value {
+public:
+    enum class Kind {
+        INTEGER,
+        ZERO_INIT,
+        AGGREGATE,
+        FUNC_ARG,
+        BLOCK_ARG,
+        GLOBAL_ALLOC,
+        // 以下均为指令
+        ALLOC,
+        LOAD,
+        STORE,
+        GET_PTR,
+        GET_ELEM_PTR,
+        BINARY,
+        BRANCH,
+        JUMP,
+        CALL,
+        RETURN
+    };
+    Kind kind;
+    const Type* ty;
+    const char* name = nullptr;
+    int id = -1;
+    Use* uses = nullptr;
+    Value(Kind kind, const Type* ty) : kind(kind), ty(ty) {}
+    bool is_inst() const;
+    int use_count() const;
+    void replace_all_uses_with(Value* value);
+};
+
+/**
+ * @brief 整数常量
+ */
+class Integer : public Value {
+public:
+    int value;
+    Integer(const Type* ty, int value) : Value(Kind::INTEGER, ty), value(value) {}
+};
+
+/**
+ * @brief 零初始化，即 zeroinit
+ */
+class ZeroInit : public Value {
+public:
+    ZeroInit(const Type* ty) : Value(Kind::ZERO_INIT, ty) {}
+};
+
+/**
+ * @brief 初始化列表，即 {1, 2, 3}
+ */
+class Aggregate : public Value {
+public:
+    Value** elems = nullptr;
+    int len = 0;
+    Aggregate(const Type* ty) : Value(Kind::AGGREGATE, ty) {}
+};
+
+/**
+ * @brief 函数参数引用
+ */
+class Argument : public Value {
+public:
+    int index;
+    Argument(const Type* ty, int index) : Value(Kind::FUNC_ARG, ty), index(index) {}
+};
+
+/**
+ * @brief 基本块参数引用，相当于 SSA 形式中的 phi，由各前驱的 jump 传入实参
+ * @note - `parent`：所属基本块
+ * @note - `index`：在所属基本块参数中的下标
+ */
+class BlockArg : public Value {
+public:
+    BasicBlock* parent;
+    int index;
+    BlockArg(const Type* ty, BasicBlock* parent, int index) : Value(Kind::BLOCK_ARG, ty), parent(parent), index(index) {}
+};
+
+/**
+ * @brief 全局变量，即 global @x = alloc T, init
+ */
+class GlobalAlloc : public Value {
+public:
+    Value* init;
+    GlobalAlloc(const Type* ty, Value* init) : Value(Kind::GLOBAL_ALLOC, ty), init(init) {}
+};
+
+/**
+ * @brief 指令，所有指令的基类
+ * @note - `operands` / `num_operands`：操作数，每个操作数都是一次 Use
+ * @note - `parent`：所在基本块
+ * @note - `prev` / `next`：所在基本块的指令链表
+ */
+class Instruction : public Value {
+public:
+    Use* operands = nullptr;
+    int num_operands = 0;
+    BasicBlock* parent = nullptr;
+    Instruction* prev = nullptr;
+    Instruction* next = nullptr;
+    Instruction(Kind kind, const Type* ty) : Value(kind, ty) {}
+    Value* operand(int index) const;
+    void set_operand(int index, Value* value);
+    bool is_terminator() const;
+    void erase();
+};
+
+/**
+ * @brief 局部分配，即 @x = alloc T
+ */
+class Alloc : public Instruction {
+public:
+    Alloc(const Type* ty) : Instruction(Kind::ALLOC, ty) {}
+};
+
+/**
+ * @brief 加载，即 %n = load src
+ */
+class Load : public Instruction {
+public:
+    Load(const Type* ty) : Instruction(Kind::LOAD, ty) {}
+    Value* src() const { return operand(0); }
+};
+
+/**
+ * @brief 存储，即 store value, dest
+ */
+class Store : public Instruction {
+public:
+    Store(const Type* ty) : Instruction(Kind::STORE, ty) {}
+    Value* value() const { return operand(0); }
+    Value* dest() const { return operand(1); }
+};
+
+/**
+ * @brief 指针计算，即 %n = getptr src, index
+ */
+class GetPtr : public Instruction {
+public:
+    GetPtr(const Type* ty) : Instruction(Kind::GET_PTR, ty) {}
+    Value* src() const { return operand(0); }
+    Value* index() const { return operand(1); }
+};
+
+/**
+ * @brief 元素指针计算，即 %n = getelemptr src, index
+ */
+class GetElemPtr : public Instruction {
+public:
+    GetElemPtr(const Type* ty) : Instruction(Kind::GET_ELEM_PTR, ty) {}
+    Value* src() const { return operand(0); }
+    Value* index() const { return operand(1); }
+};
+
+/**
+ * @brief 二元运算，即 %n = op lhs, rhs
+ */
+class Binary : public Instruction {
+public:
+    BinaryOp op;
+    Binary(const Type* ty, BinaryOp op) : Instruction(Kind::BINARY, ty), op(op) {}
+    Value* lhs() const { return operand(0); }
+    Value* rhs() const { return operand(1); }
+};
+
+/**
+ * @brief 条件分支，即 br cond, %true, %false
+ * @note 不向目标基本块传递实参，目标基本块有参数时需要经由 jump 进入
+ */
+class Branch : public Instruction {
+public:
+    BasicBlock* true_bb = nullptr;
+    BasicBlock* false_bb = nullptr;
+    Branch(const Type* ty) : Instruction(Kind::BRANCH, ty) {}
+    Value* cond() const { return operand(0); }
+};
+
+/**
+ * @brief 无条件跳转，即 jump %target(args)，操作数均为传给目标基本块参数的实参
+ */
+class Jump : public Instruction {
+public:
+    BasicBlock* target = nullptr;
+    Jump(const Type* ty) : Instruction(Kind::JUMP, ty) {}
+    Value* arg(int index) const { return operand(index); }
+};
+
+/**
+ * @brief 函数调用，即 %n = call @f(args)，操作数均为实参
+ */
+class Call : public Instruction {
+public:
+    Function* callee = nullptr;
+    Call(const Type* ty) : Instruction(Kind::CALL, ty) {}
+    Value* arg(int index) const { return operand(index); }
+};
+
+/**
+ * @brief 返回，即 ret value，无返回值时没有操作数
+ */
+class Return : public Instruction {
+public:
+    Return(const Type* ty) : Instruction(Kind::RETURN, ty) {}
+    Value* value() const { return num_operands ? operand(0) : nullptr; }
+};
+
+/**
+ * @brief 基本块，指令以双向链表组织
+ * @note - `name`：基本块名，带 %
+ * @note - `id`：函数内稠密编号
+ * @note - `parent`：所在函数
+ * @note - `params`：基本块参数
+ * @note - `head` / `tail`：指令链表头尾
+ */
+class BasicBlock {
+public:
+    const char* name = nullptr;
+    int id = -1;
+    Function* parent = nullptr;
+    vector<BlockArg*> params;
+    Instruction* head = nullptr;
+    Instruction* tail = nullptr;
+    void insert(Instruction* inst, Instruction* pos = nullptr);
+    void remove(Instruction* inst);
+    vector<BasicBlock*> successors() const;
+};
+
+/**
+ * @brief 函数，其中所有的值、基本块与操作数都分配在函数自己的内存池中
+ * @note - `name`：函数名，带 @
+ * @note - `ty`：函数类型
+ * @note - `i32`：整数类型，创建整数常量时使用
+ * @note - `params`：参数引用
+ * @note - `bbs`：按顺序排列的基本块，库函数声明没有基本块
+ * @note - `value_count` / `block_count`：已分配的值与基本块编号上界，用于按编号开辟辅助表
+ */
+class Function {
+public:
+    const char* name;
+    const Type* ty;
+    const Type* i32;
+    vector<Argument*> params;
+    vector<BasicBlock*> bbs;
+    Arena arena;
+    int value_count = 0;
+    int block_count = 0;
+    Function(const char* name, const Type* ty, const Type* i32) : name(name), ty(ty), i32(i32) {}
+    bool is_decl() const;
+    BasicBlock* new_block(const string& name);
+    BlockArg* new_param(BasicBlock* bb, const Type* ty);
+    Integer* integer(int value);
+
+    /**
+     * @brief 创建一条指令，尚未插入任何基本块
+     * @param[in] num_operands 操作数个数
+     * @param[in] args 指令构造函数参数
+     * @return 指令
+     */
+    template <typename T, typename... Args>
+    T* create(int num_operands, Args&&... args) {
+        T* inst = arena.make<T>(std::forward<Args>(args)...);
+        inst->id = value_count++;
+        inst->operands = arena.make_array<Use>(num_operands);
+        inst->num_operands = num_operands;
+        for (int i = 0; i < num_operands; i++) {
+            inst->operands[i].user = inst;
+        }
+        return inst;
+    }
+};
+
+/**
+ * @brief 程序，持有类型、全局变量与函数
+ * @note - `globals`：全局变量，按定义顺序排列
+ * @note - `funcs`：函数（含库函数声明），按定义顺序排列
+ */
+class Program {
+private:
+    Arena arena;
+    const Type* i32 = nullptr;
+    const Type* unit = nullptr;
+    unordered_map<const Type*, const Type*> pointer_types;
+    map<pair<const Type*, int>, const Type*> array_types;
+public:
+    vector<GlobalAlloc*> globals;
+    vector<Function*> funcs;
+
+    // 类型
+
+    const Type* int_type();
+    const Type* unit_type();
+    const Type* pointer_type(const Type* base);
+    const Type* array_type(const Type* base, int len);
+    const Type* function_type(const vector<const Type*>& params, const Type* ret);
+
+    // 全局定义
+
+    Integer* integer(int value);
+    ZeroInit* zero_init(const Type* ty);
+    Aggregate* aggregate(const Type* ty, const vector<Value*>& elems);
+    GlobalAlloc* global_alloc(const string& name, const Type* ty, Value* init);
+    Function* function(const string& name, const Type* ty);
+};
+
+extern OutputWriter koopa_ofs;
+
+void dump_koopa(const Program& program);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cassert>
+#include "include/writer.hpp"
+
+using namespace std;
+
+/**
+ * @brief 寄存器编号
+ * @note - 0 ~ 31 为物理寄存器 x0 ~ x31，按 RISC-V 的编号排列
+ * @note - 从 `VREG_BASE` 开始为虚拟寄存器，需在输出前分配为物理寄存器
+ * @note - `NO_REG` 表示不使用寄存器
+ */
+using Reg = int;
+
+/**
+ * @brief 物理寄存器，按 ABI 名称命名
+ */
+enum PhysReg : Reg {
+    X0, RA, SP, GP, TP, T0, T1, T2,
+    S0, S1, A0, A1, A2, A3, A4, A5,
+    A6, A7, S2, S3, S4, S5, S6, S7,
+    S8, S9, S10, S11, T3, T4, T5, T6
+};
+
+constexpr Reg NO_REG = -1;
+constexpr Reg VREG_BASE = 32;
+
+bool is_virtual(Reg reg);
+Reg t_reg(int index);
+Reg a_reg(int index);
+const char* reg_name(Reg reg);
+
+/**
+ * @brief 机器指令的操作码
+ * @note `LABEL` 为伪指令，表示一个标号的位置
+ */
+enum class Opcode {
+    LABEL,
+    // 单目运算
+    SEQZ, SNEZ, LI, MV, LA,
+    // 双目运算
+    OR, AND, XOR, ADD, SUB, MUL, MULH, DIV, REM, SGT, SLT, SLL,
+    // 立即数运算
+    ADDI, ANDI, ORI, XORI, SLTI, SLLI, SRLI, SRAI,
+    // 访存
+    LW, SW,
+    // 分支
+    BNEZ, BEQZ, BEQ, BNE, BLT, BGE, J,
+    // 调用与返回
+    CALL, RET
+};
+
+const char* opcode_name(Opcode op);
+
+/**
+ * @brief 机器指令，在一个函数翻译完成后统一输出
+ * @note - `rd` / `rs1` / `rs2`：目标寄存器与源寄存器，sw 的 `rs1` 为基址，`rs2` 为要存储的值
+ * @note - `imm`：立即数，lw / sw 中为偏移量
+ * @note - `label`：分支与跳转的目标，或 `LABEL` 伪指令所表示的标号，为所在函数的标号编号
+ * @note - `symbol`：call 的函数名，或 la 的全局变量名，指向的字符串在输出前必须一直有效
+ */
+class MachineInstr {
+public:
+    Opcode op;
+    Reg rd = NO_REG;
+    Reg rs1 = NO_REG;
+    Reg rs2 = NO_REG;
+    int imm = 0;
+    int label = -1;
+    const char* symbol = nullptr;
+    MachineInstr(Opcode op, Reg rd = NO_REG, Reg rs1 = NO_REG, Reg rs2 = NO_REG, int imm = 0)
+        : op(op), rd(rd), rs1(rs1), rs2(rs2), imm(imm) {}
+};
+
+/**
+ * @brief 机器函数，按顺序持有一个函数的全部机器指令
+ * @note - `labels`：标号编号到标号名的映射，编号小于基本块个数的标号与基本块编号一一对应
+ * @note - `vreg_count`：已分配的虚拟寄存器个数
+ * @note - 输出前先删去跳到下一条指令的 j，再做分支松弛，只有超出条件分支范围的分支才改写为长跳转
+ */
+class MachineFunction {
+public:
+    const char* name = nullptr;
+    vector<MachineInstr> instrs;
+    vector<string> labels;
+    int vreg_count = 0;
+
+    void reset(const char* name, int block_count);
+    int new_label(const string& name);
+    Reg new_vreg();
+    void remove_fallthrough_jumps();
+    void relax_branches();
+    void print(OutputWriter& ofs) const;
+};
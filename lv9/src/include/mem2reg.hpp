@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cassert>
+#include "include/ir.hpp"
+#include "include/regalloc.hpp"
+
+using namespace std;
+
+/**
+ * @brief 把只被 load / store 直接访问的局部标量 alloc 提升为 SSA 值，汇合处的值用基本块参数表示
+ * @note - 先删去不可达的基本块，再按支配边界迭代放置参数，沿支配树重命名，最后删去平凡的与无用的参数
+ * @note - br 不能传递实参，目标基本块有参数时在该边上插入一个只含 jump 的基本块
+ * @note - `phis`：按基本块编号存储参数，`incoming` 与 `edges` 中同一基本块的入边一一对应，nullptr 表示未定义
+ * @note - `edges`：按基本块编号存储入边，即前驱与其后继下标；`edge_index` 按基本块编号存储每条出边在目标入边中的下标
+ * @note - `split_count`：插入的基本块个数，基本块名会成为汇编标号，因此在整个程序内编号
+ */
+class Mem2Reg {
+public:
+    void run(Function* func);
+
+private:
+    struct Phi {
+        BlockArg* param;
+        int var;
+        vector<Value*> incoming;
+        bool alive = true;
+    };
+
+    Function* func = nullptr;
+    Liveness liveness;
+    vector<Alloc*> allocs;
+    vector<int> var_of;
+    vector<vector<Phi>> phis;
+    vector<vector<pair<BasicBlock*, int>>> edges;
+    vector<vector<int>> edge_index;
+    int split_count = 0;
+
+    void remove_unreachable();
+    void collect_allocs();
+    int variable(const Value* ptr) const;
+    void compute_edges();
+    void place_params();
+    void rename();
+    void replace(Value* value, Value* with);
+    void remove_trivial_params();
+    void remove_dead_params();
+    void pass_args();
+};
+
+void mem2reg(Program& program);
@@ -1,14 +1,12 @@
 #pragma once
 
 #include <string>
-#include "koopa.h"
+#include "include/ir.hpp"
 
 using namespace std;
 
-string koopaRawValueTagToString(int tag);
+string valueKindToString(Value::Kind kind);
 
-string koopaRawBinaryOpToString(int op);
+string binaryOpToString(BinaryOp op);
 
-string koopaRawSliceKindItemToString(int kind);
-
-string koopaRawTypeTagToString(int tag);
\ No newline at end of file
+string typeTagToString(Type::Tag tag);
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <unordered_set>
+#include <queue>
+#include "include/ir.hpp"
+#include "include/machine.hpp"
+
+using namespace std;
+
+/**
+ * @brief 活跃区间，按指令编号表示值从定义到最后一次使用的范围，跨基本块时取凸包
+ * @note - `value`：值
+ * @note - `start` / `end`：区间起止的指令编号，闭区间，参数的区间从 -1 开始
+ * @note - `cross_call`：区间内是否有值仍然活跃的函数调用，跨调用的值只能分配被调用者保存寄存器
+ */
+class LiveInterval {
+public:
+    const Value* value;
+    int start;
+    int end;
+    bool cross_call = false;
+};
+
+/**
+ * @brief 活跃性分析，按基本块顺序为指令编号，并计算每个寄存器候选值的活跃区间
+ * @note - `position`：按值的编号存储指令的编号，非指令为 -1
+ * @note - `block_start` / `block_end`：按基本块编号存储基本块首尾指令的编号
+ * @note - `intervals`：用到的参数与寄存器候选值的活跃区间，按起点升序排列
+ * @note - `calls`：函数调用指令的编号，升序
+ * @note - `preds`：按基本块编号存储前驱
+ * @note - `live_out`：按基本块编号存储出口处活跃的寄存器候选值与参数
+ * @note - `loop_depth`：按基本块编号存储循环嵌套深度，用于估计执行频率
+ * @note - `idom` / `rpo_index`：按基本块编号存储直接支配结点与逆后序编号，不可达的基本块为 -1
+ */
+class Liveness {
+public:
+    vector<int> position;
+    vector<int> block_start;
+    vector<int> block_end;
+    vector<LiveInterval> intervals;
+    vector<int> calls;
+    vector<vector<const BasicBlock*>> preds;
+    vector<vector<const Value*>> live_out;
+    vector<int> loop_depth;
+    vector<int> idom;
+    vector<int> rpo_index;
+
+    static bool is_candidate(const Value* value);
+    static bool is_branch_compare(const Value* value);
+    void compute(const Function* func);
+    void compute_preds(const Function* func);
+    void compute_loop_depth(const Function* func);
+    void compute_dominators(const Function* func);
+    int common_dominator(int a, int b) const;
+};
+
+/**
+ * @brief 迭代寄存器合并（Iterated Register Coalescing）图着色分配
+ * @note - 结点 0 ~ 31 为物理寄存器，预着色；之后的结点依次对应用到的参数与寄存器候选值
+ * @note - 传递关系来自 a0 ~ a7 到前 8 个参数、实参到 a0 ~ a7、返回值到 a0、call 结果来自 a0、jump 的实参到基本块参数，能合并时省去 mv 指令
+ * @note - 溢出的值不需要改写程序，仍由指令选择借助 t0 ~ t3 在栈上读写，因此只需一轮着色
+ * @note - 溢出代价为定值与使用次数按 10 的循环深度次幂加权，可重算的值代价减半
+ */
+class GraphColoring {
+public:
+    void run(const Function* func, vector<Reg>& assignment, const vector<bool>& remat);
+
+private:
+    enum class NodeState { PRECOLORED, INITIAL, SIMPLIFY, FREEZE, SPILL, SPILLED, COALESCED, COLORED, SELECT };
+    enum class MoveState { WORKLIST, ACTIVE, COALESCED, CONSTRAINED, FROZEN };
+    struct Move {
+        int dst;
+        int src;
+        MoveState state;
+    };
+
+    int node_count = 0;
+    vector<const Value*> values;
+    vector<int> node_of;
+    unordered_set<uint64_t> adj_set;
+    vector<vector<int>> adj_list;
+    vector<int> degree;
+    vector<int> alias;
+    vector<Reg> color;
+    vector<double> spill_cost;
+    vector<NodeState> state;
+    vector<Move> moves;
+    vector<vector<int>> move_list;
+    vector<int> simplify_worklist;
+    vector<int> freeze_worklist;
+    vector<int> spill_worklist;
+    vector<int> worklist_moves;
+    vector<int> select_stack;
+
+    void build(const Function* func, const vector<bool>& remat);
+    void add_edge(int u, int v);
+    bool adjacent(int u, int v) const;
+    void add_move(int dst, int src);
+    void make_worklist();
+    template <typename F>
+    void for_adjacent(int n, F f);
+    bool move_related(int n);
+    void push_node(int n, NodeState target);
+    void simplify();
+    void decrement_degree(int m);
+    void enable_moves(int n);
+    void coalesce();
+    void add_worklist(int u);
+    bool ok(int t, int r);
+    bool conservative(int u, int v);
+    int get_alias(int n);
+    void combine(int u, int v);
+    void freeze();
+    void freeze_moves(int u);
+    void select_spill();
+    void assign_colors();
+};
+
+/**
+ * @brief 寄存器分配器，为函数内的值分配物理寄存器，未分配到寄存器的值仍然存放在栈上
+ * @note - `assignment`：按值的编号存储分配到的寄存器，NO_REG 表示存放在栈上，第 8 个以后的参数则留在调用者的栈帧中
+ * @note - `callee_saved`：用到的被调用者保存寄存器，需要在序言中保存、在返回前恢复
+ * @note - `remat`：按值的编号标记溢出后在每次使用处重新计算的值，不占用栈空间
+ * @note - `slot` / `slot_count`：按值的编号存储未分配到寄存器的值所在的栈槽，活跃区间不重叠的值共享栈槽；
+ *         前 8 个参数溢出时也占用栈槽，在入口处存入
+ * @note - t0 ~ t3 保留给指令选择作为临时寄存器，不参与分配
+ */
+class RegisterAllocator {
+public:
+    vector<Reg> assignment;
+    vector<Reg> callee_saved;
+    vector<bool> remat;
+    vector<int> slot;
+    int slot_count = 0;
+
+    static const Reg allocatable[];
+    static const int allocatable_count;
+    static bool is_caller_saved(Reg reg);
+    static bool rematerializable(const Value* value);
+    void reset(const Function* func);
+    void linear_scan(const Function* func, bool cross_call_only = false);
+    void graph_coloring(const Function* func);
+    void assign_stack_slots(const Function* func);
+    Reg get(const Value* value) const;
+    bool is_remat(const Value* value) const;
+
+private:
+    void collect_callee_saved();
+};
+
+/**
+ * @brief 栈帧布局，决定栈槽与 alloc 分配的空间在栈帧中的位置，访问越频繁越靠近 sp
+ * @note - `offset`：按值的编号存储相对于布局起点的偏移量，不在栈上的值为 -1
+ * @note - `size`：布局的总大小
+ * @note - `frame_block` / `framed`：序言所在的基本块编号，以及按基本块编号标记是否在序言之后执行
+ */
+class FrameLayout {
+public:
+    vector<int> offset;
+    int size = 0;
+    int frame_block = 0;
+    vector<bool> framed;
+
+    void compute(const Function* func, const RegisterAllocator& allocator);
+    void shrink_wrap(const Function* func, const RegisterAllocator& allocator);
+};
+
+extern RegisterAllocator register_allocator;
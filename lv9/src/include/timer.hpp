@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cassert>
+
+using namespace std;
+
+/**
+ * @brief 编译阶段计时器，用于 -time-passes 报告与 -trace 导出
+ * @note - `records`：按开始顺序记录的所有计时区间，`depth` 为嵌套深度
+ * @note - `stack`：当前尚未结束的计时区间在 `records` 中的下标
+ * @note - 未开启任何输出时，计时区间不做任何记录
+ */
+class PassTimer {
+private:
+    struct Record {
+        string name;
+        const char* category;
+        int depth;
+        // 相对编译开始的微秒数
+        double start;
+        double wall;
+        double cpu;
+        // 结束时进程的峰值常驻内存，单位 KB
+        long peak_rss;
+    };
+    vector<Record> records;
+    vector<int> stack;
+    chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+    bool report_enabled = false;
+    string trace_path;
+
+    double now() const;
+public:
+    bool enabled() const;
+    void enable_report();
+    void enable_trace(const string& path);
+
+    void begin(const string& name, const char* category);
+    void end();
+
+    void report() const;
+    void write_trace() const;
+};
+
+extern PassTimer pass_timer;
+
+/**
+ * @brief 计时区间，构造时开始计时，析构时结束计时
+ */
+class TimeRegion {
+private:
+    bool active;
+public:
+    TimeRegion(const char* name, const char* category);
+    TimeRegion(const TimeRegion&) = delete;
+    TimeRegion& operator=(const TimeRegion&) = delete;
+    ~TimeRegion();
+};
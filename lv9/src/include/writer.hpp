@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief 输出写入器，用于输出 Koopa IR 与 Riscv 汇编文本
+ * @note - 所有输出先追加到一块固定大小的缓冲区中，缓冲区写满或关闭文件时才调用一次 write 写出
+ * @note - 行尾直接写入 '\n'，不会像 `endl` 那样每行刷新一次
+ * @note - 整数直接格式化到缓冲区中，不经过 locale 与 iostream 的格式化状态
+ */
+class OutputWriter {
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+    unique_ptr<char[]> buffer;
+    size_t size = 0;
+    int fd = -1;
+    // 统计信息
+    size_t total_bytes = 0;
+    int write_count = 0;
+
+    void write(const char* data, size_t len);
+public:
+    OutputWriter() = default;
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+    ~OutputWriter();
+
+    void open(const char* path);
+    void flush();
+    void close();
+
+    size_t bytes() const;
+    int writes() const;
+
+    OutputWriter& operator<<(string_view str);
+    OutputWriter& operator<<(const char* str);
+    OutputWriter& operator<<(const string& str);
+    OutputWriter& operator<<(char c);
+    OutputWriter& operator<<(int value);
+};
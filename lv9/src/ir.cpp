@@ -0,0 +1,717 @@
+#include "include/ir.hpp"
+
+/**
+ * @brief 释放内存池，逆序析构对象后归还所有内存块
+ */
+Arena::~Arena() {
+    clear();
+}
+
+/**
+ * @brief 从内存池中切出一段内存
+ * @param[in] size 字节数
+ * @param[in] align 对齐要求
+ * @return 内存首地址
+ * @note 较大的请求单独申请一块内存，避免浪费当前块的剩余空间
+ */
+void* Arena::allocate(size_t size, size_t align) {
+    alloc_count++;
+    byte_count += size;
+    if (size > CHUNK_SIZE / 4) {
+        char* chunk = static_cast<char*>(::operator new(size));
+        chunks.push_back(chunk);
+        return chunk;
+    }
+    size_t offset = (align - reinterpret_cast<uintptr_t>(cur) % align) % align;
+    if (cur == nullptr || cur + offset + size > end) {
+        cur = static_cast<char*>(::operator new(CHUNK_SIZE));
+        end = cur + CHUNK_SIZE;
+        chunks.push_back(cur);
+        offset = 0;
+    }
+    void* ptr = cur + offset;
+    cur += offset + size;
+    return ptr;
+}
+
+/**
+ * @brief 复制字符串到内存池中
+ * @param[in] str 字符串
+ * @return 以 '\0' 结尾的字符串，生命周期与内存池相同
+ */
+const char* Arena::strdup(const string& str) {
+    char* ptr = static_cast<char*>(allocate(str.size() + 1, 1));
+    str.copy(ptr, str.size());
+    ptr[str.size()] = '\0';
+    return ptr;
+}
+
+/**
+ * @brief 一次性释放内存池中的所有对象，统计数据保留
+ */
+void Arena::clear() {
+    for (auto it = destructors.rbegin(); it != destructors.rend(); ++it) {
+        it->first(it->second);
+    }
+    destructors.clear();
+    for (auto chunk : chunks) {
+        ::operator delete(chunk);
+    }
+    chunks.clear();
+    cur = end = nullptr;
+}
+
+/**
+ * @brief 获取累计分配次数
+ * @return 分配次数
+ */
+size_t Arena::allocations() const {
+    return alloc_count;
+}
+
+/**
+ * @brief 获取累计分配字节数
+ * @return 字节数
+ */
+size_t Arena::bytes() const {
+    return byte_count;
+}
+
+/**
+ * @brief 计算类型所占用的空间大小，对于数组可以递归处理
+ * @return 字节数
+ */
+int Type::size() const {
+    switch (tag) {
+        // 空类型与函数类型不占用空间
+    case Tag::UNIT:
+    case Tag::FUNCTION:
+        return 0;
+        // 32 位整数与指针均占用 4 字节
+    case Tag::INT32:
+    case Tag::POINTER:
+        return 4;
+        // 数组类型占用空间为数组长度乘以数组元素类型占用空间
+    case Tag::ARRAY:
+        return len * base->size();
+    default:
+        assert(false);
+    }
+    return 0;
+}
+
+/**
+ * @brief 修改被使用的值，同时维护新旧两个值的使用者链表
+ * @param[in] value 新的值
+ */
+void Use::set(Value* value) {
+    // 从旧值的使用者链表中摘除
+    if (this->value) {
+        if (prev) {
+            prev->next = next;
+        }
+        else {
+            this->value->uses = next;
+        }
+        if (next) {
+            next->prev = prev;
+        }
+    }
+    prev = next = nullptr;
+    this->value = value;
+    // 插入新值的使用者链表头部
+    if (value) {
+        next = value->uses;
+        if (next) {
+            next->prev = this;
+        }
+        value->uses = this;
+    }
+}
+
+/**
+ * @brief 判断值是否为指令
+ * @return 是否为指令
+ */
+bool Value::is_inst() const {
+    return kind >= Kind::ALLOC;
+}
+
+/**
+ * @brief 统计值被使用的次数
+ * @return 使用次数
+ */
+int Value::use_count() const {
+    int count = 0;
+    for (auto use = uses; use; use = use->next) {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief 将所有对当前值的使用替换为对另一个值的使用
+ * @param[in] value 替换后的值
+ */
+void Value::replace_all_uses_with(Value* value) {
+    assert(value != this);
+    while (uses) {
+        uses->set(value);
+    }
+}
+
+/**
+ * @brief 获取操作数
+ * @param[in] index 操作数下标
+ * @return 操作数
+ */
+Value* Instruction::operand(int index) const {
+    assert(index < num_operands);
+    return operands[index].value;
+}
+
+/**
+ * @brief 设置操作数
+ * @param[in] index 操作数下标
+ * @param[in] value 操作数
+ */
+void Instruction::set_operand(int index, Value* value) {
+    assert(index < num_operands);
+    operands[index].set(value);
+}
+
+/**
+ * @brief 判断指令是否为基本块的结束指令
+ * @return 是否为 br / jump / ret
+ */
+bool Instruction::is_terminator() const {
+    return kind == Kind::BRANCH || kind == Kind::JUMP || kind == Kind::RETURN;
+}
+
+/**
+ * @brief 删除指令，解除其所有操作数的使用，并从所在基本块中移除
+ * @note 指令本身的内存随函数内存池释放
+ */
+void Instruction::erase() {
+    assert(uses == nullptr);
+    for (int i = 0; i < num_operands; i++) {
+        operands[i].set(nullptr);
+    }
+    if (parent) {
+        parent->remove(this);
+    }
+}
+
+/**
+ * @brief 插入指令
+ * @param[in] inst 指令
+ * @param[in] pos 插入到该指令之前，为 nullptr 时追加到末尾
+ */
+void BasicBlock::insert(Instruction* inst, Instruction* pos) {
+    assert(inst->parent == nullptr);
+    inst->parent = this;
+    inst->next = pos;
+    inst->prev = pos ? pos->prev : tail;
+    if (inst->prev) {
+        inst->prev->next = inst;
+    }
+    else {
+        head = inst;
+    }
+    if (pos) {
+        pos->prev = inst;
+    }
+    else {
+        tail = inst;
+    }
+}
+
+/**
+ * @brief 从基本块中移除指令，不解除其操作数的使用
+ * @param[in] inst 指令
+ */
+void BasicBlock::remove(Instruction* inst) {
+    assert(inst->parent == this);
+    if (inst->prev) {
+        inst->prev->next = inst->next;
+    }
+    else {
+        head = inst->next;
+    }
+    if (inst->next) {
+        inst->next->prev = inst->prev;
+    }
+    else {
+        tail = inst->prev;
+    }
+    inst->parent = nullptr;
+    inst->prev = inst->next = nullptr;
+}
+
+/**
+ * @brief 获取后继基本块
+ * @return 后继基本块，按 true / false 的顺序排列
+ */
+vector<BasicBlock*> BasicBlock::successors() const {
+    if (tail == nullptr) {
+        return {};
+    }
+    if (tail->kind == Value::Kind::BRANCH) {
+        auto branch = static_cast<Branch*>(tail);
+        return { branch->true_bb, branch->false_bb };
+    }
+    if (tail->kind == Value::Kind::JUMP) {
+        return { static_cast<Jump*>(tail)->target };
+    }
+    return {};
+}
+
+/**
+ * @brief 判断是否为库函数声明
+ * @return 是否没有函数体
+ */
+bool Function::is_decl() const {
+    return bbs.empty();
+}
+
+/**
+ * @brief 创建基本块，尚未加入函数的基本块列表
+ * @param[in] name 基本块名，带 %
+ * @return 基本块
+ */
+BasicBlock* Function::new_block(const string& name) {
+    auto bb = arena.make<BasicBlock>();
+    bb->name = arena.strdup(name);
+    bb->id = block_count++;
+    bb->parent = this;
+    return bb;
+}
+
+/**
+ * @brief 为基本块追加一个参数
+ * @param[in] bb 基本块
+ * @param[in] ty 参数类型
+ * @return 参数引用
+ */
+BlockArg* Function::new_param(BasicBlock* bb, const Type* ty) {
+    auto param = arena.make<BlockArg>(ty, bb, bb->params.size());
+    param->id = value_count++;
+    bb->params.push_back(param);
+    return param;
+}
+
+/**
+ * @brief 创建函数内的整数常量，每次使用都创建新的常量
+ * @param[in] value 整数
+ * @return 整数常量
+ */
+Integer* Function::integer(int value) {
+    auto ret = arena.make<Integer>(i32, value);
+    ret->id = value_count++;
+    return ret;
+}
+
+/**
+ * @brief 获取 i32 类型
+ * @return 类型
+ */
+const Type* Program::int_type() {
+    if (!i32) {
+        i32 = arena.make<Type>(Type::Tag::INT32);
+    }
+    return i32;
+}
+
+/**
+ * @brief 获取 unit 类型
+ * @return 类型
+ */
+const Type* Program::unit_type() {
+    if (!unit) {
+        unit = arena.make<Type>(Type::Tag::UNIT);
+    }
+    return unit;
+}
+
+/**
+ * @brief 获取指向 base 的指针类型
+ * @param[in] base 指向的类型
+ * @return 类型
+ */
+const Type* Program::pointer_type(const Type* base) {
+    auto& ty = pointer_types[base];
+    if (!ty) {
+        auto ptr = arena.make<Type>(Type::Tag::POINTER);
+        ptr->base = base;
+        ty = ptr;
+    }
+    return ty;
+}
+
+/**
+ * @brief 获取数组类型 [base, len]
+ * @param[in] base 元素类型
+ * @param[in] len 数组长度
+ * @return 类型
+ */
+const Type* Program::array_type(const Type* base, int len) {
+    auto& ty = array_types[{ base, len }];
+    if (!ty) {
+        auto arr = arena.make<Type>(Type::Tag::ARRAY);
+        arr->base = base;
+        arr->len = len;
+        ty = arr;
+    }
+    return ty;
+}
+
+/**
+ * @brief 创建函数类型
+ * @param[in] params 参数类型
+ * @param[in] ret 返回值类型
+ * @return 类型
+ */
+const Type* Program::function_type(const vector<const Type*>& params, const Type* ret) {
+    auto ty = arena.make<Type>(Type::Tag::FUNCTION);
+    ty->params = params;
+    ty->ret = ret;
+    return ty;
+}
+
+/**
+ * @brief 创建全局整数常量，用于全局变量初始化
+ * @param[in] value 整数
+ * @return 整数常量
+ */
+Integer* Program::integer(int value) {
+    return arena.make<Integer>(int_type(), value);
+}
+
+/**
+ * @brief 创建零初始化值
+ * @param[in] ty 被初始化的类型
+ * @return 零初始化值
+ */
+ZeroInit* Program::zero_init(const Type* ty) {
+    return arena.make<ZeroInit>(ty);
+}
+
+/**
+ * @brief 创建初始化列表
+ * @param[in] ty 数组类型
+ * @param[in] elems 元素
+ * @return 初始化列表
+ */
+Aggregate* Program::aggregate(const Type* ty, const vector<Value*>& elems) {
+    auto ret = arena.make<Aggregate>(ty);
+    ret->len = elems.size();
+    ret->elems = arena.make_array<Value*>(elems.size());
+    for (size_t i = 0; i < elems.size(); i++) {
+        ret->elems[i] = elems[i];
+    }
+    return ret;
+}
+
+/**
+ * @brief 创建全局变量
+ * @param[in] name 全局变量名，带 @
+ * @param[in] ty 全局变量类型（非指针）
+ * @param[in] init 初始值
+ * @return 全局变量，其类型为指向 ty 的指针
+ */
+GlobalAlloc* Program::global_alloc(const string& name, const Type* ty, Value* init) {
+    auto global = arena.make<GlobalAlloc>(pointer_type(ty), init);
+    global->name = arena.strdup(name);
+    global->id = globals.size();
+    globals.push_back(global);
+    return global;
+}
+
+/**
+ * @brief 创建函数，参数引用随函数一同创建
+ * @param[in] name 函数名，带 @
+ * @param[in] ty 函数类型
+ * @return 函数
+ */
+Function* Program::function(const string& name, const Type* ty) {
+    auto func = arena.make<Function>(arena.strdup(name), ty, int_type());
+    for (size_t i = 0; i < ty->params.size(); i++) {
+        auto arg = func->arena.make<Argument>(ty->params[i], i);
+        arg->id = func->value_count++;
+        func->params.push_back(arg);
+    }
+    funcs.push_back(func);
+    return func;
+}
+
+/**
+ * @brief 输出类型，如 i32 / *i32 / [[i32, 3], 2]
+ * @param[in] ty 类型
+ */
+static void dump_type(const Type* ty) {
+    switch (ty->tag) {
+    case Type::Tag::INT32:
+        koopa_ofs << "i32";
+        break;
+    case Type::Tag::POINTER:
+        koopa_ofs << "*";
+        dump_type(ty->base);
+        break;
+    case Type::Tag::ARRAY:
+        koopa_ofs << "[";
+        dump_type(ty->base);
+        koopa_ofs << ", " << ty->len << "]";
+        break;
+    default:
+        assert(false);
+    }
+}
+
+/**
+ * @brief 输出初始化值，如 1 / zeroinit / {1, 2, 3}
+ * @param[in] init 初始化值
+ */
+static void dump_init(const Value* init) {
+    switch (init->kind) {
+    case Value::Kind::INTEGER:
+        koopa_ofs << static_cast<const Integer*>(init)->value;
+        break;
+    case Value::Kind::ZERO_INIT:
+        koopa_ofs << "zeroinit";
+        break;
+    case Value::Kind::AGGREGATE: {
+        auto aggregate = static_cast<const Aggregate*>(init);
+        koopa_ofs << "{";
+        for (int i = 0; i < aggregate->len; i++) {
+            if (i != 0) {
+                koopa_ofs << ", ";
+            }
+            dump_init(aggregate->elems[i]);
+        }
+        koopa_ofs << "}";
+        break;
+    }
+    default:
+        assert(false);
+    }
+}
+
+/**
+ * @brief 输出操作数，整数直接输出，具名值输出名字，匿名值输出 %n
+ * @param[in] value 操作数
+ * @param[in] ids 匿名值在文本中的编号，按值的稠密编号索引
+ */
+static void dump_operand(const Value* value, const vector<int>& ids) {
+    if (value->kind == Value::Kind::INTEGER) {
+        koopa_ofs << static_cast<const Integer*>(value)->value;
+    }
+    else if (value->name) {
+        koopa_ofs << value->name;
+    }
+    else {
+        koopa_ofs << "%" << ids[value->id];
+    }
+}
+
+/**
+ * @brief 输出 jump 的目标，目标基本块有参数时带上实参，如 %end_0(%3, 1)
+ * @param[in] jump 跳转指令
+ * @param[in] ids 匿名值在文本中的编号
+ */
+static void dump_target(const Jump* jump, const vector<int>& ids) {
+    koopa_ofs << jump->target->name;
+    if (jump->num_operands) {
+        koopa_ofs << "(";
+        for (int i = 0; i < jump->num_operands; i++) {
+            if (i != 0) {
+                koopa_ofs << ", ";
+            }
+            dump_operand(jump->arg(i), ids);
+        }
+        koopa_ofs << ")";
+    }
+}
+
+/**
+ * @brief 输出一条指令
+ * @param[in] inst 指令
+ * @param[in] ids 匿名值在文本中的编号
+ */
+static void dump_inst(const Instruction* inst, const vector<int>& ids) {
+    static const char* binary_ops[] = {
+        "ne", "eq", "gt", "lt", "ge", "le", "add", "sub", "mul",
+        "div", "mod", "and", "or", "xor", "shl", "shr", "sar"
+    };
+    koopa_ofs << "\t";
+    // 有结果的指令先输出 %n = 或 @x =
+    if (inst->ty->tag != Type::Tag::UNIT) {
+        dump_operand(inst, ids);
+        koopa_ofs << " = ";
+    }
+    switch (inst->kind) {
+    case Value::Kind::ALLOC:
+        koopa_ofs << "alloc ";
+        dump_type(inst->ty->base);
+        break;
+    case Value::Kind::LOAD:
+        koopa_ofs << "load ";
+        dump_operand(static_cast<const Load*>(inst)->src(), ids);
+        break;
+    case Value::Kind::STORE: {
+        auto store = static_cast<const Store*>(inst);
+        koopa_ofs << "store ";
+        dump_operand(store->value(), ids);
+        koopa_ofs << ", ";
+        dump_operand(store->dest(), ids);
+        break;
+    }
+    case Value::Kind::GET_PTR: {
+        auto get_ptr = static_cast<const GetPtr*>(inst);
+        koopa_ofs << "getptr ";
+        dump_operand(get_ptr->src(), ids);
+        koopa_ofs << ", ";
+        dump_operand(get_ptr->index(), ids);
+        break;
+    }
+    case Value::Kind::GET_ELEM_PTR: {
+        auto get_elem_ptr = static_cast<const GetElemPtr*>(inst);
+        koopa_ofs << "getelemptr ";
+        dump_operand(get_elem_ptr->src(), ids);
+        koopa_ofs << ", ";
+        dump_operand(get_elem_ptr->index(), ids);
+        break;
+    }
+    case Value::Kind::BINARY: {
+        auto binary = static_cast<const Binary*>(inst);
+        koopa_ofs << binary_ops[(int)binary->op] << " ";
+        dump_operand(binary->lhs(), ids);
+        koopa_ofs << ", ";
+        dump_operand(binary->rhs(), ids);
+        break;
+    }
+    case Value::Kind::BRANCH: {
+        auto branch = static_cast<const Branch*>(inst);
+        koopa_ofs << "br ";
+        dump_operand(branch->cond(), ids);
+        koopa_ofs << ", " << branch->true_bb->name << ", " << branch->false_bb->name;
+        break;
+    }
+    case Value::Kind::JUMP:
+        koopa_ofs << "jump ";
+        dump_target(static_cast<const Jump*>(inst), ids);
+        break;
+    case Value::Kind::CALL: {
+        auto call = static_cast<const Call*>(inst);
+        koopa_ofs << "call " << call->callee->name << "(";
+        for (int i = 0; i < call->num_operands; i++) {
+            if (i != 0) {
+                koopa_ofs << ", ";
+            }
+            dump_operand(call->arg(i), ids);
+        }
+        koopa_ofs << ")";
+        break;
+    }
+    case Value::Kind::RETURN: {
+        auto ret = static_cast<const Return*>(inst);
+        koopa_ofs << "ret";
+        if (ret->value()) {
+            koopa_ofs << " ";
+            dump_operand(ret->value(), ids);
+        }
+        break;
+    }
+    default:
+        assert(false);
+    }
+    koopa_ofs << "\n";
+}
+
+/**
+ * @brief 输出函数签名，如 @f(@x: i32, @arr: *i32): i32
+ * @param[in] func 函数
+ * @param[in] with_names 是否输出参数名，声明时只输出参数类型
+ */
+static void dump_signature(const Function* func, bool with_names) {
+    koopa_ofs << func->name << "(";
+    for (size_t i = 0; i < func->params.size(); i++) {
+        if (i != 0) {
+            koopa_ofs << ", ";
+        }
+        if (with_names) {
+            koopa_ofs << func->params[i]->name << ": ";
+        }
+        dump_type(func->params[i]->ty);
+    }
+    koopa_ofs << ")";
+    if (func->ty->ret->tag != Type::Tag::UNIT) {
+        koopa_ofs << ": ";
+        dump_type(func->ty->ret);
+    }
+}
+
+/**
+ * @brief 将程序输出为 Koopa IR 文本，仅 -koopa 模式使用
+ * @param[in] program 程序
+ */
+void dump_koopa(const Program& program) {
+    // 先输出库函数声明
+    for (auto func : program.funcs) {
+        if (func->is_decl()) {
+            koopa_ofs << "decl ";
+            dump_signature(func, false);
+            koopa_ofs << "\n";
+        }
+    }
+    koopa_ofs << "\n";
+    // 再输出全局变量
+    for (auto global : program.globals) {
+        koopa_ofs << "global " << global->name << " = alloc ";
+        dump_type(global->ty->base);
+        koopa_ofs << ", ";
+        dump_init(global->init);
+        koopa_ofs << "\n";
+    }
+    // 最后输出函数定义
+    for (auto func : program.funcs) {
+        if (func->is_decl()) {
+            continue;
+        }
+        // 匿名值编号在函数内从 0 开始，基本块参数可能在文本中先被使用，因此先统一编号
+        vector<int> ids(func->value_count, -1);
+        int count = 0;
+        for (auto bb : func->bbs) {
+            for (auto param : bb->params) {
+                ids[param->id] = count++;
+            }
+            for (auto inst = bb->head; inst; inst = inst->next) {
+                if (inst->ty->tag != Type::Tag::UNIT && !inst->name) {
+                    ids[inst->id] = count++;
+                }
+            }
+        }
+        koopa_ofs << "\nfun ";
+        dump_signature(func, true);
+        koopa_ofs << " {\n";
+        for (auto bb : func->bbs) {
+            koopa_ofs << bb->name;
+            if (!bb->params.empty()) {
+                koopa_ofs << "(";
+                for (auto param : bb->params) {
+                    if (param->index != 0) {
+                        koopa_ofs << ", ";
+                    }
+                    dump_operand(param, ids);
+                    koopa_ofs << ": ";
+                    dump_type(param->ty);
+                }
+                koopa_ofs << ")";
+            }
+            koopa_ofs << ":\n";
+            for (auto inst = bb->head; inst; inst = inst->next) {
+                dump_inst(inst, ids);
+            }
+        }
+        koopa_ofs << "}\n";
+    }
+}
@@ -0,0 +1,362 @@
+#include "include/machine.hpp"
+
+/**
+ * @brief 判断寄存器是否为虚拟寄存器
+ * @param[in] reg 寄存器
+ * @return 是否为虚拟寄存器
+ */
+bool is_virtual(Reg reg) {
+    return reg >= VREG_BASE;
+}
+
+/**
+ * @brief 获取第 index 个临时寄存器 t0 ~ t6
+ * @param[in] index 下标
+ * @return 寄存器
+ */
+Reg t_reg(int index) {
+    assert(index >= 0 && index < 7);
+    return index < 3 ? T0 + index : T3 + index - 3;
+}
+
+/**
+ * @brief 获取第 index 个参数寄存器 a0 ~ a7
+ * @param[in] index 下标
+ * @return 寄存器
+ */
+Reg a_reg(int index) {
+    assert(index >= 0 && index < 8);
+    return A0 + index;
+}
+
+/**
+ * @brief 获取物理寄存器的 ABI 名称
+ * @param[in] reg 寄存器
+ * @return 名称
+ */
+const char* reg_name(Reg reg) {
+    static const char* names[] = {
+        "x0", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+        "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+        "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+        "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"
+    };
+    assert(reg >= 0 && reg < VREG_BASE);
+    return names[reg];
+}
+
+/**
+ * @brief 开始翻译新的函数，清空指令，并为每个基本块预留一个标号
+ * @param[in] name 函数名，不带 @
+ * @param[in] block_count 基本块编号上界
+ */
+void MachineFunction::reset(const char* name, int block_count) {
+    this->name = name;
+    instrs.clear();
+    labels.assign(block_count, "");
+    vreg_count = 0;
+}
+
+/**
+ * @brief 创建一个新的标号
+ * @param[in] name 标号名
+ * @return 标号编号
+ */
+int MachineFunction::new_label(const string& name) {
+    labels.push_back(name);
+    return labels.size() - 1;
+}
+
+/**
+ * @brief 分配一个新的虚拟寄存器
+ * @return 虚拟寄存器
+ */
+Reg MachineFunction::new_vreg() {
+    return VREG_BASE + vreg_count++;
+}
+
+/**
+ * @brief 判断指令是否为条件分支
+ * @param[in] instr 机器指令
+ * @return 是否为 bnez / beqz / beq / bne / blt / bge
+ */
+static bool is_cond_branch(const MachineInstr& instr) {
+    return instr.op >= Opcode::BNEZ && instr.op <= Opcode::BGE;
+}
+
+/**
+ * @brief 获取条件相反的分支操作码
+ * @param[in] op 条件分支操作码
+ * @return 条件相反的操作码，如 bnez 与 beqz、blt 与 bge
+ */
+static Opcode invert_branch(Opcode op) {
+    switch (op) {
+    case Opcode::BNEZ:
+        return Opcode::BEQZ;
+    case Opcode::BEQZ:
+        return Opcode::BNEZ;
+    case Opcode::BEQ:
+        return Opcode::BNE;
+    case Opcode::BNE:
+        return Opcode::BEQ;
+    case Opcode::BLT:
+        return Opcode::BGE;
+    default:
+        return Opcode::BLT;
+    }
+}
+
+/**
+ * @brief 判断 index 之后紧接着的标号中是否有 label，即跳到 label 等于顺序执行下去
+ * @param[in] instrs 机器指令
+ * @param[in] index 下标
+ * @param[in] label 标号编号
+ * @return 是否紧接着 label
+ */
+static bool falls_through(const vector<MachineInstr>& instrs, int index, int label) {
+    for (int i = index + 1; i < (int)instrs.size() && instrs[i].op == Opcode::LABEL; i++) {
+        if (instrs[i].label == label) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 删去跳到紧接着的标号的 j，以及条件分支越过的 j
+ * @note - `j L` 后紧接着 `L:` 时直接删去
+ * @note - `bnez c, T` / `j F` 后紧接着 `T:` 时改写为 `beqz c, F`，其他条件分支同理
+ */
+void MachineFunction::remove_fallthrough_jumps() {
+    vector<MachineInstr> result;
+    for (int i = 0; i < (int)instrs.size(); i++) {
+        auto& instr = instrs[i];
+        if (instr.op == Opcode::J && falls_through(instrs, i, instr.label)) {
+            continue;
+        }
+        if (is_cond_branch(instr) && i + 1 < (int)instrs.size() && instrs[i + 1].op == Opcode::J
+            && falls_through(instrs, i + 1, instr.label)) {
+            auto inverted = instr;
+            inverted.op = invert_branch(instr.op);
+            inverted.label = instrs[i + 1].label;
+            result.push_back(inverted);
+            i++;
+            continue;
+        }
+        result.push_back(instr);
+    }
+    instrs = move(result);
+}
+
+/**
+ * @brief 获取机器指令汇编后的字节数，li 的立即数超出 12 位时展开为 lui 与 addi，la 与 call 展开为两条指令
+ * @param[in] instr 机器指令
+ * @return 字节数
+ */
+static int instr_size(const MachineInstr& instr) {
+    switch (instr.op) {
+    case Opcode::LABEL:
+        return 0;
+    case Opcode::LI:
+        return instr.imm >= -2048 && instr.imm < 2048 ? 4 : 8;
+    case Opcode::LA:
+    case Opcode::CALL:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+/**
+ * @brief 分支松弛，把目标超出条件分支范围（±4 KiB）的条件分支改写为相反条件的短分支越过一条 j
+ * @note - 改写会使代码变长，可能让其他分支也超出范围，因此反复计算地址直到不再有分支需要改写
+ * @note - 越过的 j 后紧接着标号时直接跳到该标号，否则新建一个标号
+ */
+void MachineFunction::relax_branches() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        // 计算每条指令与每个标号的地址
+        vector<int> address(instrs.size());
+        vector<int> label_address(labels.size(), 0);
+        int pc = 0;
+        for (int i = 0; i < (int)instrs.size(); i++) {
+            address[i] = pc;
+            if (instrs[i].op == Opcode::LABEL) {
+                label_address[instrs[i].label] = pc;
+            }
+            pc += instr_size(instrs[i]);
+        }
+        vector<MachineInstr> result;
+        for (int i = 0; i < (int)instrs.size(); i++) {
+            auto& instr = instrs[i];
+            int distance = is_cond_branch(instr) ? label_address[instr.label] - address[i] : 0;
+            if (distance >= -4096 && distance < 4096) {
+                result.push_back(instr);
+                continue;
+            }
+            // bnez c, T 改写为 beqz c, next / j T / next:
+            int next;
+            bool has_label = i + 1 < (int)instrs.size() && instrs[i + 1].op == Opcode::LABEL;
+            if (has_label) {
+                next = instrs[i + 1].label;
+            }
+            else {
+                next = new_label(string(name) + "_far_" + to_string(labels.size()));
+            }
+            auto inverted = instr;
+            inverted.op = invert_branch(instr.op);
+            inverted.label = next;
+            result.push_back(inverted);
+            result.emplace_back(Opcode::J).label = instr.label;
+            if (!has_label) {
+                result.emplace_back(Opcode::LABEL).label = next;
+            }
+            changed = true;
+        }
+        instrs = move(result);
+    }
+}
+
+/**
+ * @brief 机器指令的输出格式
+ */
+enum class Format {
+    // name:
+    LABEL,
+    // op rd, imm
+    RD_IMM,
+    // op rd, symbol
+    RD_SYMBOL,
+    // op rd, rs1
+    RD_RS1,
+    // op rd, rs1, imm
+    RD_RS1_IMM,
+    // op rd, rs1, rs2
+    RD_RS1_RS2,
+    // op rd, imm(rs1)
+    LOAD,
+    // op rs2, imm(rs1)
+    STORE,
+    // op rs1, label
+    RS1_TARGET,
+    // op rs1, rs2, label
+    RS1_RS2_TARGET,
+    // op label
+    TARGET,
+    // op symbol
+    SYMBOL,
+    // op
+    NONE
+};
+
+/**
+ * @brief 操作码的助记符与输出格式，按 Opcode 的顺序排列
+ */
+static const struct {
+    const char* mnemonic;
+    Format format;
+} opcode_info[] = {
+    { "", Format::LABEL },
+    { "seqz", Format::RD_RS1 },
+    { "snez", Format::RD_RS1 },
+    { "li", Format::RD_IMM },
+    { "mv", Format::RD_RS1 },
+    { "la", Format::RD_SYMBOL },
+    { "or", Format::RD_RS1_RS2 },
+    { "and", Format::RD_RS1_RS2 },
+    { "xor", Format::RD_RS1_RS2 },
+    { "add", Format::RD_RS1_RS2 },
+    { "sub", Format::RD_RS1_RS2 },
+    { "mul", Format::RD_RS1_RS2 },
+    { "mulh", Format::RD_RS1_RS2 },
+    { "div", Format::RD_RS1_RS2 },
+    { "rem", Format::RD_RS1_RS2 },
+    { "sgt", Format::RD_RS1_RS2 },
+    { "slt", Format::RD_RS1_RS2 },
+    { "sll", Format::RD_RS1_RS2 },
+    { "addi", Format::RD_RS1_IMM },
+    { "andi", Format::RD_RS1_IMM },
+    { "ori", Format::RD_RS1_IMM },
+    { "xori", Format::RD_RS1_IMM },
+    { "slti", Format::RD_RS1_IMM },
+    { "slli", Format::RD_RS1_IMM },
+    { "srli", Format::RD_RS1_IMM },
+    { "srai", Format::RD_RS1_IMM },
+    { "lw", Format::LOAD },
+    { "sw", Format::STORE },
+    { "bnez", Format::RS1_TARGET },
+    { "beqz", Format::RS1_TARGET },
+    { "beq", Format::RS1_RS2_TARGET },
+    { "bne", Format::RS1_RS2_TARGET },
+    { "blt", Format::RS1_RS2_TARGET },
+    { "bge", Format::RS1_RS2_TARGET },
+    { "j", Format::TARGET },
+    { "call", Format::SYMBOL },
+    { "ret", Format::NONE }
+};
+
+static_assert(sizeof(opcode_info) / sizeof(opcode_info[0]) == (int)Opcode::RET + 1, "opcode_info must cover every opcode");
+
+/**
+ * @brief 获取操作码的助记符
+ * @param[in] op 操作码
+ * @return 助记符
+ */
+const char* opcode_name(Opcode op) {
+    return opcode_info[(int)op].mnemonic;
+}
+
+/**
+ * @brief 输出函数的汇编代码
+ * @param[in] ofs 输出写入器
+ */
+void MachineFunction::print(OutputWriter& ofs) const {
+    ofs << "\n\t.text\n\t.globl " << name << '\n' << name << ":\n";
+    for (auto& instr : instrs) {
+        auto& info = opcode_info[(int)instr.op];
+        if (info.format == Format::LABEL) {
+            ofs << labels[instr.label] << ":\n";
+            continue;
+        }
+        ofs << '\t' << info.mnemonic;
+        switch (info.format) {
+        case Format::RD_IMM:
+            ofs << ' ' << reg_name(instr.rd) << ", " << instr.imm;
+            break;
+        case Format::RD_SYMBOL:
+            ofs << ' ' << reg_name(instr.rd) << ", " << instr.symbol;
+            break;
+        case Format::RD_RS1:
+            ofs << ' ' << reg_name(instr.rd) << ", " << reg_name(instr.rs1);
+            break;
+        case Format::RD_RS1_IMM:
+            ofs << ' ' << reg_name(instr.rd) << ", " << reg_name(instr.rs1) << ", " << instr.imm;
+            break;
+        case Format::RD_RS1_RS2:
+            ofs << ' ' << reg_name(instr.rd) << ", " << reg_name(instr.rs1) << ", " << reg_name(instr.rs2);
+            break;
+        case Format::LOAD:
+            ofs << ' ' << reg_name(instr.rd) << ", " << instr.imm << '(' << reg_name(instr.rs1) << ')';
+            break;
+        case Format::STORE:
+            ofs << ' ' << reg_name(instr.rs2) << ", " << instr.imm << '(' << reg_name(instr.rs1) << ')';
+            break;
+        case Format::RS1_TARGET:
+            ofs << ' ' << reg_name(instr.rs1) << ", " << labels[instr.label];
+            break;
+        case Format::RS1_RS2_TARGET:
+            ofs << ' ' << reg_name(instr.rs1) << ", " << reg_name(instr.rs2) << ", " << labels[instr.label];
+            break;
+        case Format::TARGET:
+            ofs << ' ' << labels[instr.label];
+            break;
+        case Format::SYMBOL:
+            ofs << ' ' << instr.symbol;
+            break;
+        default:
+            break;
+        }
+        ofs << '\n';
+    }
+}
@@ -7,6 +7,8 @@
 #include <sstream>
 #include "include/ast.hpp"
 #include "include/asm.hpp"
+#include "include/mem2reg.hpp"
+#include "include/timer.hpp"
 
 using namespace std;
 
@@ -16,57 +18,108 @@ using namespace std;
 // 你的代码编辑器/IDE 很可能找不到这个文件, 然后会给你报错 (虽然编译不会出错)
 // 看起来会很烦人, 于是干脆采用这种看起来 dirty 但实际很有效的手段
 extern FILE* yyin;
-extern int yyparse(unique_ptr<BaseAST>& ast);
+extern int yyparse(BaseAST*& ast);
 
 string mode = "-debug";
+int opt_level = 0;
+int mul_latency = 3;
+bool stats = false;
 
-ofstream koopa_ofs;
-ofstream riscv_ofs;
+OutputWriter koopa_ofs;
+OutputWriter riscv_ofs;
 
 int main(int argc, const char* argv[]) {
 	// 解析命令行参数. 测试脚本/评测平台要求你的编译器能接收如下参数:
-	// compiler 模式 输入文件 -o 输出文件
-	assert(argc == 5);
+	// compiler 模式 输入文件 -o 输出文件 [-O2] [-stats] [-time-passes] [-trace=FILE] [-mul-latency=N]
+	assert(argc >= 5);
 	mode = argv[1];
 	auto input = argv[2];
 	auto output = argv[4];
+	// 额外的选项
+	// -O2 使用图着色分配寄存器
+	// -stats 输出内存分配、输出写入与栈帧大小统计
+	// -time-passes 输出各阶段的耗时与峰值内存
+	// -trace=FILE 导出 Chrome trace 文件
+	// -mul-latency=N 乘法指令的延迟，决定乘常数时是否改用移位与加减
+	for (int i = 5; i < argc; i++) {
+		string option = argv[i];
+		if (option == "-O2") {
+			opt_level = 2;
+		}
+		else if (option == "-stats") {
+			stats = true;
+		}
+		else if (option == "-time-passes") {
+			pass_timer.enable_report();
+		}
+		else if (option.rfind("-trace=", 0) == 0) {
+			pass_timer.enable_trace(option.substr(7));
+		}
+		else if (option.rfind("-mul-latency=", 0) == 0) {
+			mul_latency = stoi(option.substr(13));
+		}
+	}
 
-	// 打开输入文件, 并且指定 lexer 在解析的时候读取这个文件
-	yyin = fopen(input, "r");
-	assert(yyin);
+	{
+		TimeRegion compile_region("compile", "phase");
 
-	// 调用 parser 函数, parser 函数会进一步调用 lexer 解析输入文件的
-	unique_ptr<BaseAST> ast;
-	auto ret = yyparse(ast);
-	assert(!ret);
-	// 输出解析得到的 AST, 其实就是个字符串
+		// 打开输入文件, 并且指定 lexer 在解析的时候读取这个文件
+		yyin = fopen(input, "r");
+		assert(yyin);
 
-	if (mode == "-koopa") {
-		koopa_ofs.open(output);
-		ast->print();
-		koopa_ofs.close();
-	}
-	else if (mode == "-riscv") {
-		koopa_ofs.open("ir.koopa");
-		ast->print();
-		koopa_ofs.close();
-		char koopa_ir[1 << 20];
-		ifstream koopa_ifs("ir.koopa");
-		koopa_ifs.read(koopa_ir, sizeof(koopa_ir));
-		riscv_ofs.open(output);
-		parse_riscv(koopa_ir);
-		riscv_ofs.close();
-	}
-	else if (mode == "-perf") {
-		koopa_ofs.open("ir.koopa");
-		ast->print();
-		koopa_ofs.close();
-		char koopa_ir[1 << 20];
-		ifstream koopa_ifs("ir.koopa");
-		koopa_ifs.read(koopa_ir, sizeof(koopa_ir));
-		riscv_ofs.open(output);
-		parse_riscv(koopa_ir);
-		riscv_ofs.close();
+		// 调用 parser 函数, parser 函数会进一步调用 lexer 解析输入文件的
+		BaseAST* ast = nullptr;
+		{
+			TimeRegion region("parse", "phase");
+			auto ret = yyparse(ast);
+			assert(!ret);
+		}
+
+		// 由 AST 直接在内存中构建 IR
+		{
+			TimeRegion region("irgen", "phase");
+			ast->print();
+		}
+		auto& program = ir_builder.build();
+		// IR 构建完成后 AST 不再使用，随内存池一次性释放
+		{
+			TimeRegion region("free ast", "phase");
+			ast = nullptr;
+			ast_arena.clear();
+		}
+		if (stats) {
+			cerr << "ast: " << ast_arena.allocations() << " allocations, " << ast_arena.bytes() << " bytes" << endl;
+		}
+
+		// 把局部标量变量提升为 SSA 值，-koopa 输出与后端都使用提升后的 IR
+		{
+			TimeRegion region("mem2reg", "phase");
+			mem2reg(program);
+		}
+
+		if (mode == "-koopa") {
+			// 仅 -koopa 模式需要输出 Koopa IR 文本
+			TimeRegion region("koopa", "phase");
+			koopa_ofs.open(output);
+			dump_koopa(program);
+			koopa_ofs.close();
+			if (stats) {
+				cerr << "koopa: " << koopa_ofs.bytes() << " bytes, " << koopa_ofs.writes() << " writes" << endl;
+			}
+		}
+		else if (mode == "-riscv" || mode == "-perf") {
+			// 后端直接读取 IR，不再经过文本解析，每个函数单独计时
+			TimeRegion region("riscv", "phase");
+			riscv_ofs.open(output);
+			generate_riscv(program);
+			riscv_ofs.close();
+			if (stats) {
+				cerr << "riscv: " << riscv_ofs.bytes() << " bytes, " << riscv_ofs.writes() << " writes" << endl;
+			}
+		}
 	}
+
+	pass_timer.report();
+	pass_timer.write_trace();
 	return 0;
 }
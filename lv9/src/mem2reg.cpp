@@ -0,0 +1,449 @@
+#include "include/mem2reg.hpp"
+
+/**
+ * @brief 判断两个值是否相同，整数常量每次使用都是新的对象，按数值比较，未定义的值按 0 处理
+ * @param[in] a 值，nullptr 表示未定义
+ * @param[in] b 值，nullptr 表示未定义
+ * @return 是否相同
+ */
+static bool same_value(const Value* a, const Value* b) {
+    if (a == b) {
+        return true;
+    }
+    auto constant = [](const Value* value, int& imm) {
+        if (value == nullptr) {
+            imm = 0;
+            return true;
+        }
+        if (value->kind == Value::Kind::INTEGER) {
+            imm = static_cast<const Integer*>(value)->value;
+            return true;
+        }
+        return false;
+    };
+    int x, y;
+    return constant(a, x) && constant(b, y) && x == y;
+}
+
+/**
+ * @brief 对一个函数执行 mem2reg
+ * @param[in] func 函数
+ */
+void Mem2Reg::run(Function* func) {
+    this->func = func;
+    remove_unreachable();
+    liveness.compute_preds(func);
+    // 入口基本块没有地方放参数
+    if (!liveness.preds[func->bbs.front()->id].empty()) {
+        return;
+    }
+    collect_allocs();
+    if (allocs.empty()) {
+        return;
+    }
+    liveness.compute_dominators(func);
+    compute_edges();
+    place_params();
+    rename();
+    remove_trivial_params();
+    remove_dead_params();
+    pass_args();
+    for (auto alloc : allocs) {
+        alloc->erase();
+    }
+}
+
+/**
+ * @brief 删去从入口不可达的基本块，并解除其中指令对操作数的使用
+ * @note 前端在 return / break / continue 之后新开的基本块通常不可达，
+ *       它们跳往可达的基本块时会多出前驱，也会留下对 alloc 的使用
+ */
+void Mem2Reg::remove_unreachable() {
+    vector<bool> reachable(func->block_count, false);
+    vector<BasicBlock*> stack = { func->bbs.front() };
+    reachable[func->bbs.front()->id] = true;
+    while (!stack.empty()) {
+        auto bb = stack.back();
+        stack.pop_back();
+        for (auto succ : bb->successors()) {
+            if (!reachable[succ->id]) {
+                reachable[succ->id] = true;
+                stack.push_back(succ);
+            }
+        }
+    }
+    vector<BasicBlock*> bbs;
+    for (auto bb : func->bbs) {
+        if (reachable[bb->id]) {
+            bbs.push_back(bb);
+            continue;
+        }
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            for (int i = 0; i < inst->num_operands; i++) {
+                inst->set_operand(i, nullptr);
+            }
+        }
+    }
+    func->bbs = bbs;
+}
+
+/**
+ * @brief 找出可以提升的 alloc，即类型为 i32、所有使用都是 load 的地址或 store 的目标
+ */
+void Mem2Reg::collect_allocs() {
+    allocs.clear();
+    var_of.assign(func->value_count, -1);
+    for (auto bb : func->bbs) {
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            if (inst->kind != Value::Kind::ALLOC) {
+                continue;
+            }
+            if (inst->ty->base->tag != Type::Tag::INT32) {
+                continue;
+            }
+            bool promotable = true;
+            for (auto use = inst->uses; use && promotable; use = use->next) {
+                auto user = use->user;
+                promotable = user->kind == Value::Kind::LOAD
+                    || (user->kind == Value::Kind::STORE && use == &user->operands[1]);
+            }
+            if (promotable) {
+                var_of[inst->id] = allocs.size();
+                allocs.push_back(static_cast<Alloc*>(inst));
+            }
+        }
+    }
+}
+
+/**
+ * @brief 获取地址对应的被提升的变量
+ * @param[in] ptr load 的地址或 store 的目标
+ * @return 变量下标，不是被提升的 alloc 时为 -1
+ * @note 全局变量在程序内编号，与函数内的值编号无关，不能直接查表
+ */
+int Mem2Reg::variable(const Value* ptr) const {
+    return ptr->kind == Value::Kind::ALLOC ? var_of[ptr->id] : -1;
+}
+
+/**
+ * @brief 按基本块编号整理入边，并记录每条出边在目标入边中的下标
+ */
+void Mem2Reg::compute_edges() {
+    edges.assign(func->block_count, {});
+    edge_index.assign(func->block_count, {});
+    for (auto bb : func->bbs) {
+        auto succs = bb->successors();
+        for (int i = 0; i < (int)succs.size(); i++) {
+            edge_index[bb->id].push_back(edges[succs[i]->id].size());
+            edges[succs[i]->id].push_back({ bb, i });
+        }
+    }
+}
+
+/**
+ * @brief 在定值所在基本块的迭代支配边界上放置参数
+ * @note 只处理在某个基本块中先读后写的变量，其余变量的值不会跨基本块汇合
+ */
+void Mem2Reg::place_params() {
+    auto& idom = liveness.idom;
+    // 支配边界：从有多个入边的基本块的每个前驱沿支配树上溯，直到其直接支配结点
+    vector<vector<BasicBlock*>> frontier(func->block_count);
+    for (auto bb : func->bbs) {
+        if (edges[bb->id].size() < 2) {
+            continue;
+        }
+        for (auto& edge : edges[bb->id]) {
+            for (int runner = edge.first->id; runner != idom[bb->id]; runner = idom[runner]) {
+                if (frontier[runner].empty() || frontier[runner].back() != bb) {
+                    frontier[runner].push_back(bb);
+                }
+            }
+        }
+    }
+    // 每个变量的定值基本块，以及是否在某个基本块入口处活跃
+    int var_count = allocs.size();
+    vector<vector<BasicBlock*>> def_blocks(var_count);
+    vector<bool> exposed(var_count, false);
+    vector<int> stored(var_count, -1);
+    for (auto bb : func->bbs) {
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            if (inst->kind == Value::Kind::LOAD) {
+                int var = variable(static_cast<Load*>(inst)->src());
+                if (var != -1 && stored[var] != bb->id) {
+                    exposed[var] = true;
+                }
+            }
+            else if (inst->kind == Value::Kind::STORE) {
+                int var = variable(static_cast<Store*>(inst)->dest());
+                if (var != -1 && stored[var] != bb->id) {
+                    stored[var] = bb->id;
+                    def_blocks[var].push_back(bb);
+                }
+            }
+        }
+    }
+    phis.assign(func->block_count, {});
+    vector<int> placed(func->block_count, -1);
+    vector<int> queued(func->block_count, -1);
+    vector<BasicBlock*> worklist;
+    for (int var = 0; var < var_count; var++) {
+        if (!exposed[var]) {
+            continue;
+        }
+        for (auto bb : def_blocks[var]) {
+            queued[bb->id] = var;
+            worklist.push_back(bb);
+        }
+        while (!worklist.empty()) {
+            auto bb = worklist.back();
+            worklist.pop_back();
+            for (auto target : frontier[bb->id]) {
+                if (placed[target->id] == var) {
+                    continue;
+                }
+                placed[target->id] = var;
+                auto param = func->new_param(target, allocs[var]->ty->base);
+                phis[target->id].push_back({ param, var, vector<Value*>(edges[target->id].size(), nullptr) });
+                if (queued[target->id] != var) {
+                    queued[target->id] = var;
+                    worklist.push_back(target);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 将值的所有使用替换为另一个值，整数常量每次使用都创建新的常量
+ * @param[in] value 被替换的值
+ * @param[in] with 替换后的值，nullptr 表示未定义，按 0 处理
+ */
+void Mem2Reg::replace(Value* value, Value* with) {
+    if (with && with->kind != Value::Kind::INTEGER) {
+        value->replace_all_uses_with(with);
+        return;
+    }
+    int imm = with ? static_cast<Integer*>(with)->value : 0;
+    while (value->uses) {
+        value->uses->set(func->integer(imm));
+    }
+}
+
+/**
+ * @brief 沿支配树深度优先重命名：load 替换为变量的当前值，store 更新当前值，并记录每条入边传给参数的实参
+ * @note 用显式栈代替递归，离开基本块时按日志撤销在其中压入的当前值
+ */
+void Mem2Reg::rename() {
+    auto& idom = liveness.idom;
+    auto entry = func->bbs.front();
+    vector<vector<BasicBlock*>> children(func->block_count);
+    for (auto bb : func->bbs) {
+        if (bb != entry) {
+            children[idom[bb->id]].push_back(bb);
+        }
+    }
+    vector<vector<Value*>> current(allocs.size());
+    vector<int> log;
+    auto top = [&](int var) -> Value* {
+        return current[var].empty() ? nullptr : current[var].back();
+    };
+    // 第二项为进入基本块时的日志长度，-1 表示尚未进入
+    vector<pair<BasicBlock*, int>> stack = { { entry, -1 } };
+    while (!stack.empty()) {
+        auto bb = stack.back().first;
+        int mark = stack.back().second;
+        if (mark != -1) {
+            while ((int)log.size() > mark) {
+                current[log.back()].pop_back();
+                log.pop_back();
+            }
+            stack.pop_back();
+            continue;
+        }
+        stack.back().second = log.size();
+        for (auto& phi : phis[bb->id]) {
+            current[phi.var].push_back(phi.param);
+            log.push_back(phi.var);
+        }
+        for (auto inst = bb->head; inst;) {
+            auto next = inst->next;
+            if (inst->kind == Value::Kind::LOAD) {
+                int var = variable(static_cast<Load*>(inst)->src());
+                if (var != -1) {
+                    replace(inst, top(var));
+                    inst->erase();
+                }
+            }
+            else if (inst->kind == Value::Kind::STORE) {
+                auto store = static_cast<Store*>(inst);
+                int var = variable(store->dest());
+                if (var != -1) {
+                    current[var].push_back(store->value());
+                    log.push_back(var);
+                    inst->erase();
+                }
+            }
+            inst = next;
+        }
+        auto succs = bb->successors();
+        for (int i = 0; i < (int)succs.size(); i++) {
+            for (auto& phi : phis[succs[i]->id]) {
+                phi.incoming[edge_index[bb->id][i]] = top(phi.var);
+            }
+        }
+        for (auto it = children[bb->id].rbegin(); it != children[bb->id].rend(); ++it) {
+            stack.push_back({ *it, -1 });
+        }
+    }
+}
+
+/**
+ * @brief 反复删去平凡的参数，即除自身外所有实参都相同的参数，用该实参代替
+ * @note 未定义的实参按 0 处理而不是任意值，否则代替参数的值未必支配参数的使用
+ */
+void Mem2Reg::remove_trivial_params() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto bb : func->bbs) {
+            for (auto& phi : phis[bb->id]) {
+                if (!phi.alive) {
+                    continue;
+                }
+                Value* same = nullptr;
+                bool found = false;
+                bool trivial = true;
+                for (auto value : phi.incoming) {
+                    if (value == phi.param) {
+                        continue;
+                    }
+                    if (!found) {
+                        same = value;
+                        found = true;
+                    }
+                    else if (!same_value(value, same)) {
+                        trivial = false;
+                        break;
+                    }
+                }
+                if (!trivial) {
+                    continue;
+                }
+                phi.alive = false;
+                changed = true;
+                replace(phi.param, same);
+                for (auto other : func->bbs) {
+                    for (auto& user : phis[other->id]) {
+                        for (auto& value : user.incoming) {
+                            if (value == phi.param) {
+                                value = same;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 删去无用的参数，即没有被指令使用、也没有经由其他有用参数的实参间接使用的参数
+ */
+void Mem2Reg::remove_dead_params() {
+    vector<Phi*> worklist;
+    vector<bool> live(func->value_count, false);
+    for (auto bb : func->bbs) {
+        for (auto& phi : phis[bb->id]) {
+            if (phi.alive && phi.param->uses) {
+                live[phi.param->id] = true;
+                worklist.push_back(&phi);
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        auto phi = worklist.back();
+        worklist.pop_back();
+        for (auto value : phi->incoming) {
+            if (value && value->kind == Value::Kind::BLOCK_ARG && !live[value->id]) {
+                auto param = static_cast<BlockArg*>(value);
+                live[param->id] = true;
+                worklist.push_back(&phis[param->parent->id][param->index]);
+            }
+        }
+    }
+    for (auto bb : func->bbs) {
+        for (auto& phi : phis[bb->id]) {
+            phi.alive = phi.alive && live[phi.param->id];
+        }
+    }
+}
+
+/**
+ * @brief 重建基本块参数列表，并让每条入边传递实参：jump 直接带上实参，br 则经由新插入的基本块
+ * @note 新基本块放在目标基本块之前，这样它的 jump 可以直接落到目标基本块
+ */
+void Mem2Reg::pass_args() {
+    vector<vector<BasicBlock*>> splits(func->block_count);
+    for (auto bb : func->bbs) {
+        bb->params.clear();
+        for (auto& phi : phis[bb->id]) {
+            if (phi.alive) {
+                phi.param->index = bb->params.size();
+                bb->params.push_back(phi.param);
+            }
+        }
+        if (bb->params.empty()) {
+            continue;
+        }
+        for (int e = 0; e < (int)edges[bb->id].size(); e++) {
+            auto pred = edges[bb->id][e].first;
+            auto jump = func->create<Jump>(bb->params.size(), pred->tail->ty);
+            jump->target = bb;
+            int i = 0;
+            for (auto& phi : phis[bb->id]) {
+                if (phi.alive) {
+                    auto value = phi.incoming[e];
+                    if (value == nullptr || value->kind == Value::Kind::INTEGER) {
+                        value = func->integer(value ? static_cast<Integer*>(value)->value : 0);
+                    }
+                    jump->set_operand(i++, value);
+                }
+            }
+            if (pred->tail->kind == Value::Kind::JUMP) {
+                auto old = pred->tail;
+                pred->insert(jump, old);
+                old->erase();
+                continue;
+            }
+            auto branch = static_cast<Branch*>(pred->tail);
+            auto split = func->new_block("%split_" + to_string(split_count++));
+            split->insert(jump);
+            if (edges[bb->id][e].second == 0) {
+                branch->true_bb = split;
+            }
+            else {
+                branch->false_bb = split;
+            }
+            splits[bb->id].push_back(split);
+        }
+    }
+    vector<BasicBlock*> bbs;
+    for (auto bb : func->bbs) {
+        bbs.insert(bbs.end(), splits[bb->id].begin(), splits[bb->id].end());
+        bbs.push_back(bb);
+    }
+    func->bbs = bbs;
+}
+
+/**
+ * @brief 对程序中每个有函数体的函数执行 mem2reg
+ * @param[in] program 程序
+ */
+void mem2reg(Program& program) {
+    Mem2Reg pass;
+    for (auto func : program.funcs) {
+        if (!func->is_decl()) {
+            pass.run(func);
+        }
+    }
+}
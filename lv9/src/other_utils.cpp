@@ -1,133 +1,113 @@
 #include "include/other_utils.hpp"
 
 /**
- * @brief 将 koopa_raw_value_tag_t 转换为字符串
- * @param[in] tag koopa_raw_value_tag_t
+ * @brief 将 Value::Kind 转换为字符串
+ * @param[in] kind Value::Kind
  * @return 字符串
  */
-string koopaRawValueTagToString(int tag) {
-    switch (tag) {
-    case koopa_raw_value_tag_t::KOOPA_RVT_INTEGER:
-        return "KOOPA_RVT_INTEGER";
-    case koopa_raw_value_tag_t::KOOPA_RVT_ZERO_INIT:
-        return "KOOPA_RVT_ZERO_INIT";
-    case koopa_raw_value_tag_t::KOOPA_RVT_UNDEF:
-        return "KOOPA_RVT_UNDEF";
-    case koopa_raw_value_tag_t::KOOPA_RVT_AGGREGATE:
-        return "KOOPA_RVT_AGGREGATE";
-    case koopa_raw_value_tag_t::KOOPA_RVT_FUNC_ARG_REF:
-        return "KOOPA_RVT_FUNC_ARG_REF";
-    case koopa_raw_value_tag_t::KOOPA_RVT_BLOCK_ARG_REF:
-        return "KOOPA_RVT_BLOCK_ARG_REF";
-    case koopa_raw_value_tag_t::KOOPA_RVT_ALLOC:
-        return "KOOPA_RVT_ALLOC";
-    case koopa_raw_value_tag_t::KOOPA_RVT_GLOBAL_ALLOC:
-        return "KOOPA_RVT_GLOBAL_ALLOC";
-    case koopa_raw_value_tag_t::KOOPA_RVT_LOAD:
-        return "KOOPA_RVT_LOAD";
-    case koopa_raw_value_tag_t::KOOPA_RVT_STORE:
-        return "KOOPA_RVT_STORE";
-    case koopa_raw_value_tag_t::KOOPA_RVT_GET_PTR:
-        return "KOOPA_RVT_GET_PTR";
-    case koopa_raw_value_tag_t::KOOPA_RVT_GET_ELEM_PTR:
-        return "KOOPA_RVT_GET_ELEM_PTR";
-    case koopa_raw_value_tag_t::KOOPA_RVT_BINARY:
-        return "KOOPA_RVT_BINARY";
-    case koopa_raw_value_tag_t::KOOPA_RVT_BRANCH:
-        return "KOOPA_RVT_BRANCH";
-    case koopa_raw_value_tag_t::KOOPA_RVT_JUMP:
-        return "KOOPA_RVT_JUMP";
-    case koopa_raw_value_tag_t::KOOPA_RVT_CALL:
-        return "KOOPA_RVT_CALL";
-    case koopa_raw_value_tag_t::KOOPA_RVT_RETURN:
-        return "KOOPA_RVT_RETURN";
+string valueKindToString(Value::Kind kind) {
+    switch (kind) {
+    case Value::Kind::INTEGER:
+        return "INTEGER";
+    case Value::Kind::ZERO_INIT:
+        return "ZERO_INIT";
+    case Value::Kind::AGGREGATE:
+        return "AGGREGATE";
+    case Value::Kind::FUNC_ARG:
+        return "FUNC_ARG";
+    case Value::Kind::BLOCK_ARG:
+        return "BLOCK_ARG";
+    case Value::Kind::GLOBAL_ALLOC:
+        return "GLOBAL_ALLOC";
+    case Value::Kind::ALLOC:
+        return "ALLOC";
+    case Value::Kind::LOAD:
+        return "LOAD";
+    case Value::Kind::STORE:
+        return "STORE";
+    case Value::Kind::GET_PTR:
+        return "GET_PTR";
+    case Value::Kind::GET_ELEM_PTR:
+        return "GET_ELEM_PTR";
+    case Value::Kind::BINARY:
+        return "BINARY";
+    case Value::Kind::BRANCH:
+        return "BRANCH";
+    case Value::Kind::JUMP:
+        return "JUMP";
+    case Value::Kind::CALL:
+        return "CALL";
+    case Value::Kind::RETURN:
+        return "RETURN";
     default:
-        return "UNKNOWN_TAG";
+        return "UNKNOWN_KIND";
     }
 }
 
 /**
- * @brief 将 koopa_raw_binary_op_t 转换为字符串
- * @param[in] op koopa_raw_binary_op_t
+ * @brief 将 BinaryOp 转换为字符串
+ * @param[in] op BinaryOp
  * @return 字符串
  */
-string koopaRawBinaryOpToString(int op) {
+string binaryOpToString(BinaryOp op) {
     switch (op) {
-    case koopa_raw_binary_op_t::KOOPA_RBO_EQ:
-        return "KOOPA_RBO_EQ";
-    case koopa_raw_binary_op_t::KOOPA_RBO_NOT_EQ:
-        return "KOOPA_RBO_NOT_EQ";
-    case koopa_raw_binary_op_t::KOOPA_RBO_GT:
-        return "KOOPA_RBO_GT";
-    case koopa_raw_binary_op_t::KOOPA_RBO_LT:
-        return "KOOPA_RBO_LT";
-    case koopa_raw_binary_op_t::KOOPA_RBO_GE:
-        return "KOOPA_RBO_GE";
-    case koopa_raw_binary_op_t::KOOPA_RBO_LE:
-        return "KOOPA_RBO_LE";
-    case koopa_raw_binary_op_t::KOOPA_RBO_ADD:
-        return "KOOPA_RBO_ADD";
-    case koopa_raw_binary_op_t::KOOPA_RBO_SUB:
-        return "KOOPA_RBO_SUB";
-    case koopa_raw_binary_op_t::KOOPA_RBO_MUL:
-        return "KOOPA_RBO_MUL";
-    case koopa_raw_binary_op_t::KOOPA_RBO_DIV:
-        return "KOOPA_RBO_DIV";
-    case koopa_raw_binary_op_t::KOOPA_RBO_MOD:
-        return "KOOPA_RBO_MOD";
-    case koopa_raw_binary_op_t::KOOPA_RBO_AND:
-        return "KOOPA_RBO_AND";
-    case koopa_raw_binary_op_t::KOOPA_RBO_OR:
-        return "KOOPA_RBO_OR";
-    case koopa_raw_binary_op_t::KOOPA_RBO_XOR:
-        return "KOOPA_RBO_XOR";
-    case koopa_raw_binary_op_t::KOOPA_RBO_SHL:
-        return "KOOPA_RBO_SHL";
-    case koopa_raw_binary_op_t::KOOPA_RBO_SHR:
-        return "KOOPA_RBO_SHR";
-    case koopa_raw_binary_op_t::KOOPA_RBO_SAR:
-        return "KOOPA_RBO_SAR";
+    case BinaryOp::EQ:
+        return "EQ";
+    case BinaryOp::NOT_EQ:
+        return "NOT_EQ";
+    case BinaryOp::GT:
+        return "GT";
+    case BinaryOp::LT:
+        return "LT";
+    case BinaryOp::GE:
+        return "GE";
+    case BinaryOp::LE:
+        return "LE";
+    case BinaryOp::ADD:
+        return "ADD";
+    case BinaryOp::SUB:
+        return "SUB";
+    case BinaryOp::MUL:
+        return "MUL";
+    case BinaryOp::DIV:
+        return "DIV";
+    case BinaryOp::MOD:
+        return "MOD";
+    case BinaryOp::AND:
+        return "AND";
+    case BinaryOp::OR:
+        return "OR";
+    case BinaryOp::XOR:
+        return "XOR";
+    case BinaryOp::SHL:
+        return "SHL";
+    case BinaryOp::SHR:
+        return "SHR";
+    case BinaryOp::SAR:
+        return "SAR";
     default:
         return "UNKNOWN_OP";
     }
 }
 
 /**
- * @brief 将 koopa_raw_slice_item_kind_t 转换为字符串
- * @param[in] kind koopa_raw_slice_item_kind_t
- * @return 字符串
- */
-string koopaRawSliceKindItemToString(int kind) {
-    switch (kind) {
-    case koopa_raw_slice_item_kind_t::KOOPA_RSIK_FUNCTION:
-        return "KOOPA_RSIK_PROGRAM";
-    case koopa_raw_slice_item_kind_t::KOOPA_RSIK_BASIC_BLOCK:
-        return "KOOPA_RSIK_BASIC_BLOCK";
-    case koopa_raw_slice_item_kind_t::KOOPA_RSIK_VALUE:
-        return "KOOPA_RSIK_VALUE";
-    default:
-        return "UNKNOWN_KIND";
-    }
-}
-
-/**
- * @brief 将 koopa_raw_type_tag_t 转换为字符串
- * @param[in] tag koopa_raw_type_tag_t
+ * @brief 将 Type::Tag 转换为字符串
+ * @param[in] tag Type::Tag
  * @return 字符串
  */
-string koopaRawTypeTagToString(int tag) {
+string typeTagToString(Type::Tag tag) {
     switch (tag) {
-    case koopa_raw_type_tag_t::KOOPA_RTT_INT32:
-        return "KOOPA_RTT_INT32";
-    case koopa_raw_type_tag_t::KOOPA_RTT_UNIT:
-        return "KOOPA_RTT_UNIT";
-    case koopa_raw_type_tag_t::KOOPA_RTT_ARRAY:
-        return "KOOPA_RTT_ARRAY";
-    case koopa_raw_type_tag_t::KOOPA_RTT_POINTER:
-        return "KOOPA_RTT_POINTER";
-    case koopa_raw_type_tag_t::KOOPA_RTT_FUNCTION:
-        return "KOOPA_RTT_FUNCTION";
+    case Type::Tag::INT32:
+        return "INT32";
+    case Type::Tag::UNIT:
+        return "UNIT";
+    case Type::Tag::ARRAY:
+        return "ARRAY";
+    case Type::Tag::POINTER:
+        return "POINTER";
+    case Type::Tag::FUNCTION:
+        return "FUNCTION";
     default:
         return "UNKNOWN_TAG";
     }
-}
\ No newline at end of file
+}
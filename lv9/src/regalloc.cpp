@@ -0,0 +1,1305 @@
+#include "include/regalloc.hpp"
+
+// 寄存器分配器
+RegisterAllocator register_allocator;
+
+// 参与分配的寄存器，调用者保存寄存器在前，t0 ~ t3 保留给指令选择
+const Reg RegisterAllocator::allocatable[] = {
+    T4, T5, T6, A7, A6, A5, A4, A3, A2, A1, A0,
+    S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11
+};
+const int RegisterAllocator::allocatable_count = size(RegisterAllocator::allocatable);
+
+/**
+ * @brief 判断值是否参与寄存器分配，即会产生需要保存的结果的指令，以及基本块参数
+ * @param[in] value 值
+ * @return 是否为寄存器候选值
+ */
+bool Liveness::is_candidate(const Value* value) {
+    switch (value->kind) {
+    case Value::Kind::BINARY:
+        return !is_branch_compare(value);
+    case Value::Kind::BLOCK_ARG:
+    case Value::Kind::LOAD:
+    case Value::Kind::GET_PTR:
+    case Value::Kind::GET_ELEM_PTR:
+        return true;
+    case Value::Kind::CALL:
+        return value->ty->tag != Type::Tag::UNIT;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 判断值是否为只被紧接着的 br 使用的比较，这样的比较与 br 合并为一条比较分支指令，不产生结果
+ * @param[in] value 值
+ * @return 是否与 br 合并
+ * @note 比较与 br 之间没有其他指令，操作数在 br 处仍然在原来的位置
+ */
+bool Liveness::is_branch_compare(const Value* value) {
+    if (value->kind != Value::Kind::BINARY) {
+        return false;
+    }
+    switch (static_cast<const Binary*>(value)->op) {
+    case BinaryOp::EQ:
+    case BinaryOp::NOT_EQ:
+    case BinaryOp::LT:
+    case BinaryOp::GT:
+    case BinaryOp::LE:
+    case BinaryOp::GE:
+        break;
+    default:
+        return false;
+    }
+    auto next = static_cast<const Instruction*>(value)->next;
+    return next && next->kind == Value::Kind::BRANCH && value->uses && !value->uses->next && value->uses->user == next;
+}
+
+/**
+ * @brief 计算函数内所有寄存器候选值的活跃区间，以及每个基本块出口处活跃的值
+ * @param[in] func 函数
+ * @note 候选值都只定义一次，跨基本块的使用从使用处沿前驱回溯到定义处，途经的基本块都计入区间
+ */
+void Liveness::compute(const Function* func) {
+    position.assign(func->value_count, -1);
+    block_start.assign(func->block_count, 0);
+    block_end.assign(func->block_count, 0);
+    intervals.clear();
+    calls.clear();
+    live_out.assign(func->block_count, {});
+    // 按基本块顺序为指令编号
+    int pos = 0;
+    for (auto bb : func->bbs) {
+        block_start[bb->id] = pos;
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            if (inst->kind == Value::Kind::CALL) {
+                calls.push_back(pos);
+            }
+            position[inst->id] = pos++;
+        }
+        block_end[bb->id] = pos - 1;
+    }
+    compute_preds(func);
+    // 记录基本块最近一次被哪个值标记为入口活跃、出口活跃，避免重复回溯
+    vector<int> marked_in(func->block_count, -1);
+    vector<int> marked_out(func->block_count, -1);
+    vector<const BasicBlock*> worklist;
+    // 值在基本块 use 的入口处活跃，沿前驱回溯到定义所在的基本块 def
+    auto propagate = [&](const Value* value, const BasicBlock* def, const BasicBlock* use, LiveInterval* interval) {
+        worklist.push_back(use);
+        while (!worklist.empty()) {
+            auto live_in = worklist.back();
+            worklist.pop_back();
+            if (live_in == def || marked_in[live_in->id] == value->id) {
+                continue;
+            }
+            marked_in[live_in->id] = value->id;
+            if (interval) {
+                interval->start = min(interval->start, block_start[live_in->id]);
+            }
+            for (auto pred : preds[live_in->id]) {
+                if (interval) {
+                    interval->end = max(interval->end, block_end[pred->id]);
+                }
+                if (marked_out[pred->id] != value->id) {
+                    marked_out[pred->id] = value->id;
+                    live_out[pred->id].push_back(value);
+                }
+                worklist.push_back(pred);
+            }
+        }
+    };
+    // 参数视为在入口基本块之前定义，区间从 -1 开始
+    for (auto param : func->params) {
+        if (!param->uses) {
+            continue;
+        }
+        LiveInterval interval{ param, -1, -1 };
+        for (auto use = param->uses; use; use = use->next) {
+            interval.end = max(interval.end, position[use->user->id]);
+            if (use->user->parent != func->bbs.front()) {
+                propagate(param, func->bbs.front(), use->user->parent, &interval);
+            }
+        }
+        interval.cross_call = !calls.empty() && calls.front() < interval.end;
+        intervals.push_back(interval);
+    }
+    for (auto bb : func->bbs) {
+        // 基本块参数视为在基本块开头定义，由前驱末尾的 jump 写入
+        for (auto param : bb->params) {
+            LiveInterval interval{ param, block_start[bb->id], block_start[bb->id] };
+            for (auto use = param->uses; use; use = use->next) {
+                interval.end = max(interval.end, position[use->user->id]);
+                if (use->user->parent != bb) {
+                    propagate(param, bb, use->user->parent, &interval);
+                }
+            }
+            auto call = lower_bound(calls.begin(), calls.end(), interval.start);
+            interval.cross_call = call != calls.end() && *call < interval.end;
+            intervals.push_back(interval);
+        }
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            if (!is_candidate(inst)) {
+                continue;
+            }
+            LiveInterval interval{ inst, position[inst->id], position[inst->id] };
+            for (auto use = inst->uses; use; use = use->next) {
+                auto user = use->user;
+                interval.end = max(interval.end, position[user->id]);
+                // 使用者在其他基本块，沿前驱回溯到定义所在的基本块
+                if (user->parent != bb) {
+                    propagate(inst, bb, user->parent, &interval);
+                }
+            }
+            // 区间内有调用，且调用之后值仍然活跃
+            auto call = upper_bound(calls.begin(), calls.end(), interval.start);
+            interval.cross_call = call != calls.end() && *call < interval.end;
+            intervals.push_back(interval);
+        }
+    }
+    stable_sort(intervals.begin(), intervals.end(), [](const LiveInterval& a, const LiveInterval& b) {
+        return a.start < b.start;
+    });
+}
+
+/**
+ * @brief 计算每个基本块的前驱
+ * @param[in] func 函数
+ */
+void Liveness::compute_preds(const Function* func) {
+    preds.assign(func->block_count, {});
+    for (auto bb : func->bbs) {
+        for (auto succ : bb->successors()) {
+            preds[succ->id].push_back(bb);
+        }
+    }
+}
+
+/**
+ * @brief 计算每个基本块的循环嵌套深度，需要先计算前驱
+ * @param[in] func 函数
+ * @note 深度优先搜索找出回边，每个循环头与其所有回边构成一个自然循环，循环体内的基本块深度加一
+ */
+void Liveness::compute_loop_depth(const Function* func) {
+    loop_depth.assign(func->block_count, 0);
+    if (func->bbs.empty()) {
+        return;
+    }
+    vector<vector<BasicBlock*>> succs(func->block_count);
+    for (auto bb : func->bbs) {
+        succs[bb->id] = bb->successors();
+    }
+    // 0 为未访问，1 为在搜索栈上，2 为已完成
+    vector<int> visited(func->block_count, 0);
+    // 按循环头编号存储回边的起点
+    vector<vector<const BasicBlock*>> latches(func->block_count);
+    vector<pair<const BasicBlock*, int>> stack = { { func->bbs.front(), 0 } };
+    visited[func->bbs.front()->id] = 1;
+    while (!stack.empty()) {
+        auto bb = stack.back().first;
+        auto& next = stack.back().second;
+        if (next == (int)succs[bb->id].size()) {
+            visited[bb->id] = 2;
+            stack.pop_back();
+            continue;
+        }
+        auto succ = succs[bb->id][next++];
+        if (visited[succ->id] == 0) {
+            visited[succ->id] = 1;
+            stack.push_back({ succ, 0 });
+        }
+        else if (visited[succ->id] == 1) {
+            latches[succ->id].push_back(bb);
+        }
+    }
+    // 循环体为不经过循环头即可到达回边起点的基本块
+    vector<int> in_loop(func->block_count, -1);
+    vector<const BasicBlock*> worklist;
+    for (auto header : func->bbs) {
+        if (latches[header->id].empty()) {
+            continue;
+        }
+        in_loop[header->id] = header->id;
+        loop_depth[header->id]++;
+        worklist = latches[header->id];
+        while (!worklist.empty()) {
+            auto bb = worklist.back();
+            worklist.pop_back();
+            if (in_loop[bb->id] == header->id) {
+                continue;
+            }
+            in_loop[bb->id] = header->id;
+            loop_depth[bb->id]++;
+            for (auto pred : preds[bb->id]) {
+                worklist.push_back(pred);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 计算支配树，需要先计算前驱
+ * @param[in] func 函数
+ * @note 按逆后序迭代求直接支配结点（Cooper-Harvey-Kennedy 算法）
+ */
+void Liveness::compute_dominators(const Function* func) {
+    idom.assign(func->block_count, -1);
+    rpo_index.assign(func->block_count, -1);
+    if (func->bbs.empty()) {
+        return;
+    }
+    // 迭代深度优先搜索求后序
+    vector<const BasicBlock*> order;
+    vector<vector<BasicBlock*>> succs(func->block_count);
+    for (auto bb : func->bbs) {
+        succs[bb->id] = bb->successors();
+    }
+    vector<bool> visited(func->block_count, false);
+    vector<pair<const BasicBlock*, int>> stack = { { func->bbs.front(), 0 } };
+    visited[func->bbs.front()->id] = true;
+    while (!stack.empty()) {
+        auto bb = stack.back().first;
+        auto& next = stack.back().second;
+        if (next == (int)succs[bb->id].size()) {
+            order.push_back(bb);
+            stack.pop_back();
+            continue;
+        }
+        auto succ = succs[bb->id][next++];
+        if (!visited[succ->id]) {
+            visited[succ->id] = true;
+            stack.push_back({ succ, 0 });
+        }
+    }
+    reverse(order.begin(), order.end());
+    for (int i = 0; i < (int)order.size(); i++) {
+        rpo_index[order[i]->id] = i;
+    }
+    auto entry = func->bbs.front()->id;
+    idom[entry] = entry;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto bb : order) {
+            if (bb->id == entry) {
+                continue;
+            }
+            int new_idom = -1;
+            for (auto pred : preds[bb->id]) {
+                if (idom[pred->id] == -1) {
+                    continue;
+                }
+                new_idom = new_idom == -1 ? pred->id : common_dominator(pred->id, new_idom);
+            }
+            if (new_idom != idom[bb->id]) {
+                idom[bb->id] = new_idom;
+                changed = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 求两个可达基本块的最近公共支配结点
+ * @param[in] a 基本块编号
+ * @param[in] b 基本块编号
+ * @return 最近公共支配结点的编号
+ */
+int Liveness::common_dominator(int a, int b) const {
+    while (a != b) {
+        while (rpo_index[a] > rpo_index[b]) {
+            a = idom[a];
+        }
+        while (rpo_index[b] > rpo_index[a]) {
+            b = idom[b];
+        }
+    }
+    return a;
+}
+
+/**
+ * @brief 建立冲突图与传递关系，并估计溢出代价
+ * @param[in] func 函数
+ * @param[in] remat 按值的编号标记可重算的值
+ */
+void GraphColoring::build(const Function* func, const vector<bool>& remat) {
+    // 为用到的参数与寄存器候选值编号
+    node_count = VREG_BASE;
+    values.assign(VREG_BASE, nullptr);
+    node_of.assign(func->value_count, -1);
+    for (auto param : func->params) {
+        if (param->uses) {
+            node_of[param->id] = node_count++;
+            values.push_back(param);
+        }
+    }
+    for (auto bb : func->bbs) {
+        for (auto param : bb->params) {
+            node_of[param->id] = node_count++;
+            values.push_back(param);
+        }
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            if (Liveness::is_candidate(inst)) {
+                node_of[inst->id] = node_count++;
+                values.push_back(inst);
+            }
+        }
+    }
+    adj_set.clear();
+    adj_list.assign(node_count, {});
+    degree.assign(node_count, 0);
+    alias.resize(node_count);
+    color.assign(node_count, NO_REG);
+    spill_cost.assign(node_count, 0);
+    state.assign(node_count, NodeState::INITIAL);
+    moves.clear();
+    move_list.assign(node_count, {});
+    for (int i = 0; i < node_count; i++) {
+        alias[i] = i;
+    }
+    for (Reg reg = 0; reg < VREG_BASE; reg++) {
+        state[reg] = NodeState::PRECOLORED;
+        color[reg] = reg;
+        degree[reg] = INT32_MAX / 2;
+    }
+    Liveness liveness;
+    liveness.compute(func);
+    liveness.compute_loop_depth(func);
+    // 值对应的结点，不参与分配的值为 -1
+    auto node = [&](const Value* value) {
+        if (Liveness::is_candidate(value) || value->kind == Value::Kind::FUNC_ARG) {
+            return node_of[value->id];
+        }
+        return -1;
+    };
+    // 当前活跃的结点，用稀疏集合存储以便遍历与删除
+    vector<int> live;
+    vector<int> live_pos(node_count, -1);
+    auto live_add = [&](int n) {
+        if (live_pos[n] == -1) {
+            live_pos[n] = live.size();
+            live.push_back(n);
+        }
+    };
+    auto live_remove = [&](int n) {
+        if (live_pos[n] != -1) {
+            live_pos[live.back()] = live_pos[n];
+            live[live_pos[n]] = live.back();
+            live.pop_back();
+            live_pos[n] = -1;
+        }
+    };
+    for (auto bb : func->bbs) {
+        double weight = pow(10.0, min(liveness.loop_depth[bb->id], 8));
+        for (auto n : live) {
+            live_pos[n] = -1;
+        }
+        live.clear();
+        for (auto value : liveness.live_out[bb->id]) {
+            live_add(node(value));
+        }
+        // 从后往前扫描，定值与此时所有活跃的结点冲突
+        for (auto inst = bb->tail; inst; inst = inst->prev) {
+            auto def = node(inst);
+            if (def != -1) {
+                live_remove(def);
+                for (auto n : live) {
+                    add_edge(def, n);
+                }
+                spill_cost[def] += weight;
+            }
+            if (inst->kind == Value::Kind::CALL) {
+                // 跨调用活跃的值与调用者保存寄存器冲突
+                for (auto n : live) {
+                    for (int i = 0; i < RegisterAllocator::allocatable_count; i++) {
+                        auto reg = RegisterAllocator::allocatable[i];
+                        if (RegisterAllocator::is_caller_saved(reg)) {
+                            add_edge(n, reg);
+                        }
+                    }
+                }
+                // 返回值来自 a0，前 8 个实参传入 a0 ~ a7
+                if (def != -1) {
+                    add_move(def, A0);
+                }
+                for (int i = 0; i < min(inst->num_operands, 8); i++) {
+                    auto arg = node(inst->operand(i));
+                    if (arg >= VREG_BASE) {
+                        add_move(a_reg(i), arg);
+                    }
+                }
+            }
+            if (inst->kind == Value::Kind::RETURN && inst->num_operands) {
+                auto value = node(inst->operand(0));
+                if (value >= VREG_BASE) {
+                    add_move(A0, value);
+                }
+            }
+            // jump 的实参传给目标基本块的参数，参数在这里定值
+            if (inst->kind == Value::Kind::JUMP) {
+                auto target = static_cast<const Jump*>(inst)->target;
+                for (int i = 0; i < inst->num_operands; i++) {
+                    auto param = node(target->params[i]);
+                    auto arg = node(inst->operand(i));
+                    if (arg >= VREG_BASE) {
+                        add_move(param, arg);
+                    }
+                    spill_cost[param] += weight;
+                }
+            }
+            for (int i = 0; i < inst->num_operands; i++) {
+                auto use = node(inst->operand(i));
+                if (use != -1) {
+                    live_add(use);
+                    if (use >= VREG_BASE) {
+                        spill_cost[use] += weight;
+                    }
+                }
+            }
+        }
+        // 基本块参数在开头同时定值，彼此冲突，也与入口处活跃的值冲突
+        for (auto param : bb->params) {
+            auto def = node(param);
+            for (auto n : live) {
+                add_edge(def, n);
+            }
+        }
+        for (auto param : bb->params) {
+            live_remove(node(param));
+        }
+        // 参数在入口处同时定值，彼此冲突；前 8 个参数来自 a0 ~ a7，溢出时要在入口处存到栈上
+        if (bb == func->bbs.front()) {
+            for (auto param : func->params) {
+                auto def = node(param);
+                if (def == -1) {
+                    continue;
+                }
+                for (auto n : live) {
+                    add_edge(def, n);
+                }
+                auto index = static_cast<const Argument*>(param)->index;
+                if (index < 8) {
+                    add_move(def, a_reg(index));
+                    spill_cost[def] += weight;
+                }
+            }
+        }
+    }
+    // 可重算的值溢出后只需在使用处重新计算，不需要存取栈
+    for (int n = VREG_BASE; n < node_count; n++) {
+        if (remat[values[n]->id]) {
+            spill_cost[n] /= 2;
+        }
+    }
+}
+
+/**
+ * @brief 添加冲突边
+ * @param[in] u 结点
+ * @param[in] v 结点
+ */
+void GraphColoring::add_edge(int u, int v) {
+    if (u == v || adjacent(u, v) || (state[u] == NodeState::PRECOLORED && state[v] == NodeState::PRECOLORED)) {
+        return;
+    }
+    adj_set.insert((uint64_t)u << 32 | v);
+    adj_set.insert((uint64_t)v << 32 | u);
+    if (state[u] != NodeState::PRECOLORED) {
+        adj_list[u].push_back(v);
+        degree[u]++;
+    }
+    if (state[v] != NodeState::PRECOLORED) {
+        adj_list[v].push_back(u);
+        degree[v]++;
+    }
+}
+
+/**
+ * @brief 判断两个结点是否冲突
+ * @param[in] u 结点
+ * @param[in] v 结点
+ * @return 是否冲突
+ */
+bool GraphColoring::adjacent(int u, int v) const {
+    return adj_set.count((uint64_t)u << 32 | v);
+}
+
+/**
+ * @brief 添加传递关系 dst = src
+ * @param[in] dst 目标结点
+ * @param[in] src 源结点
+ */
+void GraphColoring::add_move(int dst, int src) {
+    moves.push_back({ dst, src, MoveState::WORKLIST });
+    move_list[dst].push_back(moves.size() - 1);
+    move_list[src].push_back(moves.size() - 1);
+    worklist_moves.push_back(moves.size() - 1);
+}
+
+/**
+ * @brief 按度数与是否有传递关系将结点放入对应的工作表
+ */
+void GraphColoring::make_worklist() {
+    const int K = RegisterAllocator::allocatable_count;
+    for (int n = VREG_BASE; n < node_count; n++) {
+        if (degree[n] >= K) {
+            push_node(n, NodeState::SPILL);
+        }
+        else if (move_related(n)) {
+            push_node(n, NodeState::FREEZE);
+        }
+        else {
+            push_node(n, NodeState::SIMPLIFY);
+        }
+    }
+}
+
+/**
+ * @brief 遍历尚未移出冲突图的邻接结点
+ * @param[in] n 结点
+ * @param[in] f 回调
+ */
+template <typename F>
+void GraphColoring::for_adjacent(int n, F f) {
+    for (auto t : adj_list[n]) {
+        if (state[t] != NodeState::SELECT && state[t] != NodeState::COALESCED) {
+            f(t);
+        }
+    }
+}
+
+/**
+ * @brief 判断结点是否还有可能合并的传递关系
+ * @param[in] n 结点
+ * @return 是否有关联的传递
+ */
+bool GraphColoring::move_related(int n) {
+    for (auto m : move_list[n]) {
+        if (moves[m].state == MoveState::ACTIVE || moves[m].state == MoveState::WORKLIST) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 将结点移入工作表，旧工作表中的记录在取出时按状态过滤
+ * @param[in] n 结点
+ * @param[in] target 目标状态
+ */
+void GraphColoring::push_node(int n, NodeState target) {
+    state[n] = target;
+    switch (target) {
+    case NodeState::SIMPLIFY:
+        simplify_worklist.push_back(n);
+        break;
+    case NodeState::FREEZE:
+        freeze_worklist.push_back(n);
+        break;
+    case NodeState::SPILL:
+        spill_worklist.push_back(n);
+        break;
+    default:
+        assert(false);
+    }
+}
+
+/**
+ * @brief 简化：移除一个低度数且无传递关系的结点，压入选择栈
+ */
+void GraphColoring::simplify() {
+    auto n = simplify_worklist.back();
+    simplify_worklist.pop_back();
+    if (state[n] != NodeState::SIMPLIFY) {
+        return;
+    }
+    state[n] = NodeState::SELECT;
+    select_stack.push_back(n);
+    for_adjacent(n, [&](int m) { decrement_degree(m); });
+}
+
+/**
+ * @brief 降低结点度数，度数降到 K 以下时重新启用相关的传递并移出溢出工作表
+ * @param[in] m 结点
+ */
+void GraphColoring::decrement_degree(int m) {
+    if (state[m] == NodeState::PRECOLORED) {
+        return;
+    }
+    if (degree[m]-- != RegisterAllocator::allocatable_count) {
+        return;
+    }
+    enable_moves(m);
+    for_adjacent(m, [&](int t) { enable_moves(t); });
+    if (state[m] == NodeState::SPILL) {
+        push_node(m, move_related(m) ? NodeState::FREEZE : NodeState::SIMPLIFY);
+    }
+}
+
+/**
+ * @brief 将结点上暂不能合并的传递放回传递工作表
+ * @param[in] n 结点
+ */
+void GraphColoring::enable_moves(int n) {
+    for (auto m : move_list[n]) {
+        if (moves[m].state == MoveState::ACTIVE) {
+            moves[m].state = MoveState::WORKLIST;
+            worklist_moves.push_back(m);
+        }
+    }
+}
+
+/**
+ * @brief 合并：尝试合并一条传递的两端，预着色结点用 George 准则，其余用 Briggs 准则
+ */
+void GraphColoring::coalesce() {
+    auto m = worklist_moves.back();
+    worklist_moves.pop_back();
+    if (moves[m].state != MoveState::WORKLIST) {
+        return;
+    }
+    auto x = get_alias(moves[m].dst);
+    auto y = get_alias(moves[m].src);
+    auto u = x, v = y;
+    if (state[y] == NodeState::PRECOLORED) {
+        swap(u, v);
+    }
+    if (u == v) {
+        moves[m].state = MoveState::COALESCED;
+        add_worklist(u);
+        return;
+    }
+    if (state[v] == NodeState::PRECOLORED || adjacent(u, v)) {
+        moves[m].state = MoveState::CONSTRAINED;
+        add_worklist(u);
+        add_worklist(v);
+        return;
+    }
+    bool can_combine;
+    if (state[u] == NodeState::PRECOLORED) {
+        can_combine = true;
+        for_adjacent(v, [&](int t) { can_combine = can_combine && ok(t, u); });
+    }
+    else {
+        can_combine = conservative(u, v);
+    }
+    if (can_combine) {
+        moves[m].state = MoveState::COALESCED;
+        combine(u, v);
+        add_worklist(u);
+    }
+    else {
+        moves[m].state = MoveState::ACTIVE;
+    }
+}
+
+/**
+ * @brief 低度数且不再有传递关系的结点移入简化工作表
+ * @param[in] u 结点
+ */
+void GraphColoring::add_worklist(int u) {
+    if (state[u] == NodeState::FREEZE && !move_related(u) && degree[u] < RegisterAllocator::allocatable_count) {
+        push_node(u, NodeState::SIMPLIFY);
+    }
+}
+
+/**
+ * @brief George 准则：t 与预着色结点 r 合并无害
+ * @param[in] t 结点
+ * @param[in] r 预着色结点
+ * @return 是否无害
+ */
+bool GraphColoring::ok(int t, int r) {
+    return degree[t] < RegisterAllocator::allocatable_count || state[t] == NodeState::PRECOLORED || adjacent(t, r);
+}
+
+/**
+ * @brief Briggs 准则：合并后高度数邻居少于 K 个
+ * @param[in] u 结点
+ * @param[in] v 结点
+ * @return 是否可以保守合并
+ */
+bool GraphColoring::conservative(int u, int v) {
+    const int K = RegisterAllocator::allocatable_count;
+    unordered_set<int> significant;
+    auto count = [&](int t) {
+        if (degree[t] >= K) {
+            significant.insert(t);
+        }
+    };
+    for_adjacent(u, count);
+    for_adjacent(v, count);
+    return (int)significant.size() < K;
+}
+
+/**
+ * @brief 获取合并后的代表结点
+ * @param[in] n 结点
+ * @return 代表结点
+ */
+int GraphColoring::get_alias(int n) {
+    while (state[n] == NodeState::COALESCED) {
+        n = alias[n];
+    }
+    return n;
+}
+
+/**
+ * @brief 将 v 合并到 u
+ * @param[in] u 代表结点
+ * @param[in] v 被合并的结点
+ */
+void GraphColoring::combine(int u, int v) {
+    state[v] = NodeState::COALESCED;
+    alias[v] = u;
+    move_list[u].insert(move_list[u].end(), move_list[v].begin(), move_list[v].end());
+    enable_moves(v);
+    for_adjacent(v, [&](int t) {
+        add_edge(t, u);
+        decrement_degree(t);
+    });
+    if (degree[u] >= RegisterAllocator::allocatable_count && state[u] == NodeState::FREEZE) {
+        push_node(u, NodeState::SPILL);
+    }
+}
+
+/**
+ * @brief 冻结：放弃一个低度数结点上的传递，使其可以被简化
+ */
+void GraphColoring::freeze() {
+    auto u = freeze_worklist.back();
+    freeze_worklist.pop_back();
+    if (state[u] != NodeState::FREEZE) {
+        return;
+    }
+    push_node(u, NodeState::SIMPLIFY);
+    freeze_moves(u);
+}
+
+/**
+ * @brief 冻结结点上的所有传递
+ * @param[in] u 结点
+ */
+void GraphColoring::freeze_moves(int u) {
+    for (auto m : move_list[u]) {
+        if (moves[m].state != MoveState::ACTIVE && moves[m].state != MoveState::WORKLIST) {
+            continue;
+        }
+        auto x = get_alias(moves[m].dst);
+        auto y = get_alias(moves[m].src);
+        auto v = y == get_alias(u) ? x : y;
+        moves[m].state = MoveState::FROZEN;
+        if (state[v] == NodeState::FREEZE && !move_related(v) && degree[v] < RegisterAllocator::allocatable_count) {
+            push_node(v, NodeState::SIMPLIFY);
+        }
+    }
+}
+
+/**
+ * @brief 选择溢出：取溢出代价与度数之比最小的结点，乐观地压入选择栈
+ */
+void GraphColoring::select_spill() {
+    int best = -1;
+    int size = 0;
+    for (auto n : spill_worklist) {
+        if (state[n] != NodeState::SPILL) {
+            continue;
+        }
+        spill_worklist[size++] = n;
+        if (best == -1 || spill_cost[n] * degree[best] < spill_cost[best] * degree[n]) {
+            best = n;
+        }
+    }
+    spill_worklist.resize(size);
+    if (best == -1) {
+        return;
+    }
+    push_node(best, NodeState::SIMPLIFY);
+    freeze_moves(best);
+}
+
+/**
+ * @brief 按选择栈的顺序着色，优先使用传递另一端的颜色，其次是调用者保存寄存器
+ */
+void GraphColoring::assign_colors() {
+    vector<bool> forbidden(VREG_BASE);
+    while (!select_stack.empty()) {
+        auto n = select_stack.back();
+        select_stack.pop_back();
+        fill(forbidden.begin(), forbidden.end(), false);
+        for (auto w : adj_list[n]) {
+            auto a = get_alias(w);
+            if (state[a] == NodeState::COLORED || state[a] == NodeState::PRECOLORED) {
+                forbidden[color[a]] = true;
+            }
+        }
+        Reg reg = NO_REG;
+        for (auto m : move_list[n]) {
+            auto other = get_alias(moves[m].dst) == n ? get_alias(moves[m].src) : get_alias(moves[m].dst);
+            if ((state[other] == NodeState::COLORED || state[other] == NodeState::PRECOLORED) && !forbidden[color[other]]) {
+                reg = color[other];
+                break;
+            }
+        }
+        for (int i = 0; i < RegisterAllocator::allocatable_count && reg == NO_REG; i++) {
+            if (!forbidden[RegisterAllocator::allocatable[i]]) {
+                reg = RegisterAllocator::allocatable[i];
+            }
+        }
+        if (reg == NO_REG) {
+            state[n] = NodeState::SPILLED;
+        }
+        else {
+            state[n] = NodeState::COLORED;
+            color[n] = reg;
+        }
+    }
+    for (int n = VREG_BASE; n < node_count; n++) {
+        if (state[n] == NodeState::COALESCED) {
+            color[n] = color[get_alias(n)];
+        }
+    }
+}
+
+/**
+ * @brief 迭代寄存器合并图着色
+ * @param[in] func 函数
+ * @param[out] assignment 按值的编号存储分配到的寄存器，溢出的值为 NO_REG
+ * @param[in] remat 按值的编号标记可重算的值
+ */
+void GraphColoring::run(const Function* func, vector<Reg>& assignment, const vector<bool>& remat) {
+    simplify_worklist.clear();
+    freeze_worklist.clear();
+    spill_worklist.clear();
+    worklist_moves.clear();
+    select_stack.clear();
+    build(func, remat);
+    make_worklist();
+    while (true) {
+        if (!simplify_worklist.empty()) {
+            simplify();
+        }
+        else if (!worklist_moves.empty()) {
+            coalesce();
+        }
+        else if (!freeze_worklist.empty()) {
+            freeze();
+        }
+        else if (!spill_worklist.empty()) {
+            select_spill();
+        }
+        else {
+            break;
+        }
+    }
+    assign_colors();
+    for (int n = VREG_BASE; n < node_count; n++) {
+        assignment[values[n]->id] = color[n];
+    }
+}
+
+/**
+ * @brief 清空分配结果，所有值都存放在栈上
+ * @param[in] func 函数
+ */
+void RegisterAllocator::reset(const Function* func) {
+    assignment.assign(func->value_count, NO_REG);
+    callee_saved.clear();
+    remat.assign(func->value_count, false);
+}
+
+/**
+ * @brief 判断寄存器是否为调用者保存寄存器，调用后其值不再可用
+ * @param[in] reg 寄存器
+ * @return 是否为调用者保存寄存器
+ */
+bool RegisterAllocator::is_caller_saved(Reg reg) {
+    return reg == RA || (reg >= T0 && reg <= T2) || (reg >= A0 && reg <= A7) || reg >= T3;
+}
+
+/**
+ * @brief 判断值能否在使用处重新计算，即以常量下标从局部数组或全局变量算出的指针
+ * @param[in] value 值
+ * @return 是否可重算
+ */
+bool RegisterAllocator::rematerializable(const Value* value) {
+    if (value->kind != Value::Kind::GET_ELEM_PTR && value->kind != Value::Kind::GET_PTR) {
+        return false;
+    }
+    auto inst = static_cast<const Instruction*>(value);
+    if (inst->operand(1)->kind != Value::Kind::INTEGER) {
+        return false;
+    }
+    auto src = inst->operand(0);
+    return src->kind == Value::Kind::ALLOC || src->kind == Value::Kind::GLOBAL_ALLOC || rematerializable(src);
+}
+
+/**
+ * @brief 线性扫描寄存器分配
+ * @param[in] func 函数
+ * @note - 按起点顺序扫描活跃区间，区间结束后其寄存器即可复用
+ * @note - 不跨调用的值优先使用调用者保存寄存器，跨调用的值只能使用被调用者保存寄存器
+ * @note - 没有空闲寄存器时，溢出当前活跃区间中结束最晚的一个
+ * @note - 不跨调用的前 8 个参数优先留在传入的 a0 ~ a7 中
+ * @note - `cross_call_only` 为真时只为跨调用的值分配被调用者保存寄存器，其余的值仍然存放在栈上，参数仍然分配寄存器；
+ *         保存与恢复被调用者保存寄存器要一次 sw 和一次 lw，与只定值、使用一次的值存取栈的开销相当，这样的值不分配
+ */
+void RegisterAllocator::linear_scan(const Function* func, bool cross_call_only) {
+    static const Reg caller_saved_pool[] = { T4, T5, T6, A7, A6, A5, A4, A3, A2, A1, A0 };
+    static const Reg callee_saved_pool[] = { S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11 };
+    reset(func);
+    Liveness liveness;
+    liveness.compute(func);
+    auto& intervals = liveness.intervals;
+    if (cross_call_only) {
+        liveness.compute_loop_depth(func);
+    }
+    // 按 10 的循环深度次幂加权的定值与使用次数
+    auto frequency = [&](const Value* value) {
+        const BasicBlock* def = nullptr;
+        if (value->kind == Value::Kind::FUNC_ARG) {
+            def = func->bbs.front();
+        }
+        else if (value->kind == Value::Kind::BLOCK_ARG) {
+            def = static_cast<const BlockArg*>(value)->parent;
+        }
+        else {
+            def = static_cast<const Instruction*>(value)->parent;
+        }
+        double weight = pow(10.0, min(liveness.loop_depth[def->id], 8));
+        for (auto use = value->uses; use; use = use->next) {
+            weight += pow(10.0, min(liveness.loop_depth[use->user->parent->id], 8));
+        }
+        return weight;
+    };
+    // 每个物理寄存器被占用到的指令编号，以及占用它的区间下标，参数的区间从 -1 开始
+    vector<int> busy_until(VREG_BASE, -2);
+    vector<int> owner(VREG_BASE, -1);
+    for (int k = 0; k < (int)intervals.size(); k++) {
+        auto& interval = intervals[k];
+        bool is_param = interval.value->kind == Value::Kind::FUNC_ARG;
+        if (cross_call_only && (interval.cross_call ? frequency(interval.value) <= 2 : !is_param)) {
+            continue;
+        }
+        Reg reg = NO_REG;
+        // 在寄存器池中找空闲寄存器
+        auto find_free = [&](const Reg* pool, int size) {
+            for (int i = 0; i < size && reg == NO_REG; i++) {
+                if (busy_until[pool[i]] < interval.start) {
+                    reg = pool[i];
+                }
+            }
+        };
+        // 在寄存器池中找结束最晚的区间
+        Reg victim = NO_REG;
+        auto find_victim = [&](const Reg* pool, int size) {
+            for (int i = 0; i < size; i++) {
+                if (owner[pool[i]] != -1 && (victim == NO_REG || busy_until[pool[i]] > busy_until[victim])) {
+                    victim = pool[i];
+                }
+            }
+        };
+        if (is_param && !interval.cross_call && static_cast<const Argument*>(interval.value)->index < 8) {
+            auto incoming = a_reg(static_cast<const Argument*>(interval.value)->index);
+            find_free(&incoming, 1);
+        }
+        if (!interval.cross_call) {
+            find_free(caller_saved_pool, size(caller_saved_pool));
+        }
+        find_free(callee_saved_pool, size(callee_saved_pool));
+        // 没有空闲寄存器，若有比当前区间结束更晚的区间，则溢出它并抢占其寄存器，否则溢出当前区间
+        if (reg == NO_REG) {
+            if (!interval.cross_call) {
+                find_victim(caller_saved_pool, size(caller_saved_pool));
+            }
+            find_victim(callee_saved_pool, size(callee_saved_pool));
+            if (victim != NO_REG && busy_until[victim] > interval.end) {
+                assignment[intervals[owner[victim]].value->id] = NO_REG;
+                reg = victim;
+            }
+        }
+        if (reg != NO_REG) {
+            assignment[interval.value->id] = reg;
+            busy_until[reg] = interval.end;
+            owner[reg] = k;
+        }
+    }
+    collect_callee_saved();
+}
+
+/**
+ * @brief 图着色寄存器分配，溢出的可重算值在使用处重新计算
+ * @param[in] func 函数
+ */
+void RegisterAllocator::graph_coloring(const Function* func) {
+    reset(func);
+    vector<bool> can_remat(func->value_count, false);
+    for (auto bb : func->bbs) {
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            can_remat[inst->id] = rematerializable(inst);
+        }
+    }
+    GraphColoring coloring;
+    coloring.run(func, assignment, can_remat);
+    for (int i = 0; i < func->value_count; i++) {
+        remat[i] = can_remat[i] && assignment[i] == NO_REG;
+    }
+    collect_callee_saved();
+}
+
+/**
+ * @brief 为未分配到寄存器、也不重算的值分配栈槽
+ * @param[in] func 函数
+ * @note 按活跃区间起点扫描，区间结束后其栈槽即可给后来的值复用
+ */
+void RegisterAllocator::assign_stack_slots(const Function* func) {
+    slot.assign(func->value_count, -1);
+    slot_count = 0;
+    Liveness liveness;
+    liveness.compute(func);
+    // 活跃中的区间按终点排成小根堆
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> active;
+    vector<int> free_slots;
+    for (auto& interval : liveness.intervals) {
+        auto value = interval.value;
+        if (assignment[value->id] != NO_REG || remat[value->id]) {
+            continue;
+        }
+        if (value->kind == Value::Kind::FUNC_ARG && static_cast<const Argument*>(value)->index >= 8) {
+            continue;
+        }
+        while (!active.empty() && active.top().first < interval.start) {
+            free_slots.push_back(active.top().second);
+            active.pop();
+        }
+        if (free_slots.empty()) {
+            free_slots.push_back(slot_count++);
+        }
+        slot[value->id] = free_slots.back();
+        free_slots.pop_back();
+        active.push({ interval.end, slot[value->id] });
+    }
+}
+
+/**
+ * @brief 按访问频率排布栈槽与 alloc 分配的空间
+ * @param[in] func 函数
+ * @param[in] allocator 已经分配好栈槽的寄存器分配器
+ * @note - 访问次数按 10 的循环深度次幂加权，栈槽计入定值与使用，alloc 计入以它为操作数的指令
+ * @note - 4 字节的栈槽与标量按频率从高到低排在最前，数组按大小从小到大排在后面，热点访问尽量落在 12 位立即数范围内
+ */
+void FrameLayout::compute(const Function* func, const RegisterAllocator& allocator) {
+    offset.assign(func->value_count, -1);
+    size = 0;
+    Liveness liveness;
+    liveness.compute_preds(func);
+    liveness.compute_loop_depth(func);
+    auto frequency = [&](const BasicBlock* bb) {
+        return pow(10.0, min(liveness.loop_depth[bb->id], 8));
+    };
+    // 每一项为栈槽或 alloc，栈槽的编号取负数减一以便与 alloc 的值编号区分
+    struct Item {
+        int key;
+        int size;
+        double weight;
+    };
+    vector<Item> items;
+    for (int i = 0; i < allocator.slot_count; i++) {
+        items.push_back({ -i - 1, 4, 0 });
+    }
+    for (auto bb : func->bbs) {
+        for (auto inst = bb->head; inst; inst = inst->next) {
+            double weight = 0;
+            for (auto use = inst->uses; use; use = use->next) {
+                weight += frequency(use->user->parent);
+            }
+            if (inst->kind == Value::Kind::ALLOC) {
+                items.push_back({ inst->id, inst->ty->base->size(), weight });
+            }
+            else if (allocator.slot[inst->id] != -1) {
+                items[allocator.slot[inst->id]].weight += weight + frequency(bb);
+            }
+        }
+    }
+    for (auto param : func->params) {
+        if (allocator.slot[param->id] != -1) {
+            double weight = frequency(func->bbs.front());
+            for (auto use = param->uses; use; use = use->next) {
+                weight += frequency(use->user->parent);
+            }
+            items[allocator.slot[param->id]].weight += weight;
+        }
+    }
+    // 基本块参数在每个前驱末尾写入
+    for (auto bb : func->bbs) {
+        for (auto param : bb->params) {
+            if (allocator.slot[param->id] == -1) {
+                continue;
+            }
+            double weight = 0;
+            for (auto pred : liveness.preds[bb->id]) {
+                weight += frequency(pred);
+            }
+            for (auto use = param->uses; use; use = use->next) {
+                weight += frequency(use->user->parent);
+            }
+            items[allocator.slot[param->id]].weight += weight;
+        }
+    }
+    stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        if ((a.size == 4) != (b.size == 4)) {
+            return a.size == 4;
+        }
+        if (a.size != b.size) {
+            return a.size < b.size;
+        }
+        return a.weight > b.weight;
+    });
+    // 栈槽的偏移量，再展开到共享栈槽的值上
+    vector<int> slot_offset(allocator.slot_count);
+    for (auto& item : items) {
+        if (item.key < 0) {
+            slot_offset[-item.key - 1] = size;
+        }
+        else {
+            offset[item.key] = size;
+        }
+        size += item.size;
+    }
+    for (int i = 0; i < func->value_count; i++) {
+        if (allocator.slot[i] != -1) {
+            offset[i] = slot_offset[allocator.slot[i]];
+        }
+    }
+}
+
+/**
+ * @brief 收缩包装，把序言放到所有需要栈帧的基本块的最近公共支配结点，不经过这些基本块的返回路径不必分配栈帧
+ * @param[in] func 函数
+ * @param[in] allocator 寄存器分配器
+ * @note - 需要栈帧的基本块：有函数调用，或访问栈上的值、局部数组、第 8 个以后的参数，或用到被调用者保存寄存器
+ * @note - 参数在入口处就要存入栈槽、挪到被调用者保存寄存器或从调用者的栈帧加载时，序言只能放在入口处
+ * @note - 序言之后的基本块必须只跳转到序言之后的基本块，且不能回到序言所在的基本块，否则退回到在入口处生成序言
+ */
+void FrameLayout::shrink_wrap(const Function* func, const RegisterAllocator& allocator) {
+    framed.assign(func->block_count, true);
+    frame_block = func->bbs.empty() ? 0 : func->bbs.front()->id;
+    if (func->bbs.empty()) {
+        return;
+    }
+    // 值是否位于栈帧中，或占用需要在序言中保存的寄存器
+    auto in_frame = [&](const Value* value) {
+        if (value->kind == Value::Kind::FUNC_ARG && static_cast<const Argument*>(value)->index >= 8) {
+            return true;
+        }
+        if (!Liveness::is_candidate(value) && value->kind != Value::Kind::ALLOC && value->kind != Value::Kind::FUNC_ARG) {
+            return false;
+        }
+        if (offset[value->id] != -1 || allocator.is_remat(value)) {
+            return true;
+        }
+        auto reg = allocator.get(value);
+        return reg != NO_REG && !RegisterAllocator::is_caller_saved(reg);
+    };
+    for (auto param : func->params) {
+        if (param->uses && in_frame(param)) {
+            return;
+        }
+    }
+    Liveness liveness;
+    liveness.compute_preds(func);
+    liveness.compute_dominators(func);
+    int dominator = -1;
+    for (auto bb : func->bbs) {
+        if (liveness.idom[bb->id] == -1) {
+            continue;
+        }
+        bool needs_frame = false;
+        for (auto inst = bb->head; inst && !needs_frame; inst = inst->next) {
+            needs_frame = inst->kind == Value::Kind::CALL || in_frame(inst);
+            for (int i = 0; i < inst->num_operands && !needs_frame; i++) {
+                needs_frame = in_frame(inst->operand(i));
+            }
+            // jump 要写入目标基本块的参数
+            if (inst->kind == Value::Kind::JUMP) {
+                for (auto param : static_cast<const Jump*>(inst)->target->params) {
+                    needs_frame = needs_frame || in_frame(param);
+                }
+            }
+        }
+        if (needs_frame) {
+            dominator = dominator == -1 ? bb->id : liveness.common_dominator(dominator, bb->id);
+        }
+    }
+    if (dominator == -1 || dominator == frame_block) {
+        return;
+    }
+    // 支配树中以序言所在基本块为根的子树即为序言之后执行的基本块
+    vector<vector<int>> children(func->block_count);
+    for (auto bb : func->bbs) {
+        if (liveness.idom[bb->id] != -1 && liveness.idom[bb->id] != bb->id) {
+            children[liveness.idom[bb->id]].push_back(bb->id);
+        }
+    }
+    vector<bool> subtree(func->block_count, false);
+    vector<int> worklist = { dominator };
+    while (!worklist.empty()) {
+        auto id = worklist.back();
+        worklist.pop_back();
+        subtree[id] = true;
+        for (auto child : children[id]) {
+            worklist.push_back(child);
+        }
+    }
+    for (auto bb : func->bbs) {
+        if (!subtree[bb->id]) {
+            continue;
+        }
+        for (auto succ : bb->successors()) {
+            if (!subtree[succ->id] || succ->id == dominator) {
+                return;
+            }
+        }
+    }
+    frame_block = dominator;
+    framed = subtree;
+}
+
+/**
+ * @brief 统计用到的被调用者保存寄存器
+ */
+void RegisterAllocator::collect_callee_saved() {
+    vector<bool> used(VREG_BASE, false);
+    for (auto reg : assignment) {
+        if (reg != NO_REG) {
+            used[reg] = true;
+        }
+    }
+    for (auto reg : { S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11 }) {
+        if (used[reg]) {
+            callee_saved.push_back(reg);
+        }
+    }
+}
+
+/**
+ * @brief 获取值分配到的寄存器
+ * @param[in] value 值
+ * @return 寄存器，未分配或不是参数、寄存器候选值时为 NO_REG
+ */
+Reg RegisterAllocator::get(const Value* value) const {
+    if ((!Liveness::is_candidate(value) && value->kind != Value::Kind::FUNC_ARG) || value->id >= (int)assignment.size()) {
+        return NO_REG;
+    }
+    return assignment[value->id];
+}
+
+/**
+ * @brief 判断值是否溢出后在使用处重新计算
+ * @param[in] value 值
+ * @return 是否重算
+ */
+bool RegisterAllocator::is_remat(const Value* value) const {
+    return Liveness::is_candidate(value) && value->id < (int)remat.size() && remat[value->id];
+}
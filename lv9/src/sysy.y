@@ -25,27 +25,28 @@ using namespace std;
 
 // 声明 lexer 函数和错误处理函数
 int yylex();
-void yyerror(unique_ptr<BaseAST> &ast, const char *s);
+void yyerror(BaseAST *&ast, const char *s);
 
 using namespace std;
 
 %}
 
 // 定义 parser 函数和错误处理函数的附加参数
-// 我们需要返回一个字符串作为 AST, 所以我们把附加参数定义成字符串的智能指针
-// 解析完成后, 我们要手动修改这个参数, 把它设置成解析得到的字符串
-%parse-param { unique_ptr<BaseAST> &ast }
+// 我们需要返回一个 AST, 所以我们把附加参数定义成 AST 指针的引用
+// 解析完成后, 我们要手动修改这个参数, 把它设置成解析得到的 AST, AST 本身由 ast_arena 持有
+%parse-param { BaseAST *&ast }
 
 // yylval 的定义, 我们把它定义成了一个联合体 (union)
-// 因为 token 的值有的是字符串指针, 有的是整数，有的时候是 BaseAST 指针，有的时候是 vector<unique_ptr<BaseAST>> 指针
-// 之前我们在 lexer 中用到的 str_val 和 int_val 就是在这里被定义的
-// 至于为什么要用字符串指针而不直接用 string 或者 unique_ptr<string>?
-// 请自行 STFW 在 union 里写一个带析构函数的类会出现什么情况
+// 因为 token 的值有的是标识符句柄, 有的是运算符, 有的是整数，有的时候是 BaseAST 指针，有的时候是 ASTList 指针
+// 之前我们在 lexer 中用到的 ident_val, op_val 和 int_val 就是在这里被定义的
+// 标识符驻留在字符串池 string_pool 中, 这里只传递平凡的句柄 Ident, 不在堆上为每个 token 分配字符串
+// 至于为什么不直接用 string? 请自行 STFW 在 union 里写一个带析构函数的类会出现什么情况
 %union {
-  string *str_val;
+  Ident ident_val;
+  Operator op_val;
   int int_val;
   BaseAST *ast_val;
-  vector<unique_ptr<BaseAST>> *vec_val;
+  ASTList *vec_val;
 }
 
 /* token 的声明 */
@@ -53,8 +54,8 @@ using namespace std;
 // 注意 IDENT 和 INT_CONST 会返回 token 的值, 分别对应 str_val 和 int_val
 %token INT VOID CONST RETURN
 %token IF ELSE WHILE BREAK CONTINUE
-%token <str_val> IDENT
-%token <str_val> EqOp RelOp AddOp NotOp MulOp AndOp OrOp
+%token <ident_val> IDENT
+%token <op_val> EqOp RelOp AddOp NotOp MulOp AndOp OrOp
 %token <int_val> INT_CONST
 
 /* 非终结符的类型定义，ast_val 类型的 */
@@ -77,37 +78,36 @@ using namespace std;
 
 Program
   : CompUnit ExtendCompUnit {
-    // make_unique 是 C++14 引入的智能指针模板函数
-    // 它会在堆上分配一个 ProgramAST 对象, 并返回一个 unique_ptr<ProgramAST>
-    auto program = make_unique<ProgramAST>();
+    // 所有 AST 节点都在 ast_arena 内存池中分配, 生成 IR 后随内存池一次性释放
+    auto program = ast_arena.make<ProgramAST>();
     // CompUnit 的解析返回值
     auto comp_unit = $1;
     // ExtendCompUnit 的解析返回值
     // 这里是传递了指针，而不是值，真实的 vec 当前还存在于 ExtendBlockItemAST 中，通过使用指针，我们可以先避免大量拷贝
-    // 也符合了之前对于 ExtendCompUnit 的返回值 yylval 定义 vector<unique_ptr<BaseAST>> *
-    vector<unique_ptr<BaseAST>> *vec = $2;
+    // 也符合了之前对于 ExtendCompUnit 的返回值 yylval 定义 ASTList *
+    ASTList *vec = $2;
     // 把 $1 即 CompUnit 的解析返回值移动到 program->comp_units 中
-    program->comp_units.push_back(unique_ptr<BaseAST>(comp_unit));
+    program->comp_units.push_back(comp_unit);
     // 把 $2 即 ExtendCompUnit 的解析返回值移动到 program->comp_units 中
     for (auto& ptr : *vec) {
-      program->comp_units.push_back(move(ptr));
+      program->comp_units.push_back(ptr);
     }
-    // 把 program 移动到 ast 中
-    ast = move(program);
+    // 把 program 交给 ast
+    ast = program;
   }
   ;
 
 ExtendCompUnit
   : {
-    // 如果是从 ε 规约到 ExtendCompUnit, 则创建一个空的 vector<unique_ptr<BaseAST>>
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    // 如果是从 ε 规约到 ExtendCompUnit, 则创建一个空的 ASTList
+    ASTList *vec = ast_arena.make<ASTList>();
     // $$ 是 Bison 提供的宏, 它代表当前规则的返回值
     $$ = vec;
   }
   | ExtendCompUnit CompUnit {
     // 如果是从 ExtendCompUnit 规约到 CompUnit, 则把 CompUnit 的解析返回值移动到 ExtendCompUnit 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($2));
+    ASTList *vec = $1;
+    vec->push_back($2);
     $$ = vec;
   }
   ;
@@ -126,26 +126,26 @@ FuncDef
   : INT IDENT '(' ExtendFuncFParams ')' Block {
     // 有返回值的函数定义
     // 创建一个 FuncDefAST 对象
-    auto ast = new FuncDefAST();
+    auto ast = ast_arena.make<FuncDefAST>();
     // 设置各种属性
     ast->func_type = FuncDefAST::FuncType::INT;
-    ast->ident = *unique_ptr<string>($2);
-    vector<unique_ptr<BaseAST>> *vec = $4;
+    ast->ident = $2;
+    ASTList *vec = $4;
     ast->func_f_params = vec;
-    ast->block = unique_ptr<BaseAST>($6);
+    ast->block = $6;
     // 把 ast 作为当前规则的返回值
     $$ = ast;
   }
   | VOID IDENT '(' ExtendFuncFParams ')' Block {
     // 无返回值的函数定义
     // 创建一个 FuncDefAST 对象
-    auto ast = new FuncDefAST();
+    auto ast = ast_arena.make<FuncDefAST>();
     // 设置各种属性
     ast->func_type = FuncDefAST::FuncType::VOID;
-    ast->ident = *unique_ptr<string>($2);
-    vector<unique_ptr<BaseAST>> *vec = $4;
+    ast->ident = $2;
+    ASTList *vec = $4;
     ast->func_f_params = vec;
-    ast->block = unique_ptr<BaseAST>($6);
+    ast->block = $6;
     // 把 ast 作为当前规则的返回值
     $$ = ast;
   }
@@ -154,19 +154,19 @@ FuncDef
 ExtendFuncFParams
   : {
     // 0 个参数
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    ASTList *vec = ast_arena.make<ASTList>();
     $$ = vec;
   }
   | FuncFParam {
     // 1 个参数
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
-    vec->push_back(unique_ptr<BaseAST>($1));
+    ASTList *vec = ast_arena.make<ASTList>();
+    vec->push_back($1);
     $$ = vec;
   }
   | ExtendFuncFParams ',' FuncFParam {
     // 多个参数
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($3));
+    ASTList *vec = $1;
+    vec->push_back($3);
     $$ = vec;
   }
   ;
@@ -174,16 +174,16 @@ ExtendFuncFParams
 FuncFParam
   : INT IDENT {
     // 普通参数
-    auto ast = new FuncFParamAST();
-    ast->ident = *unique_ptr<string>($2);
+    auto ast = ast_arena.make<FuncFParamAST>();
+    ast->ident = $2;
     $$ = ast;
   }
   | INT IDENT '[' ']' ExtendArrayIndex {
     // 数组指针参数
-    auto ast = new FuncFParamAST();
-    ast->ident = *unique_ptr<string>($2);
+    auto ast = ast_arena.make<FuncFParamAST>();
+    ast->ident = $2;
     ast->is_array = true;
-    vector<unique_ptr<BaseAST>> *vec = $5;
+    ASTList *vec = $5;
     ast->array_index = vec;
     $$ = ast;
   }
@@ -192,33 +192,32 @@ FuncFParam
 Block
   : '{' BlockItem ExtendBlockItem '}' {
     // 带语句的块
-    auto ast = new BlockAST();
+    auto ast = ast_arena.make<BlockAST>();
     auto block_item = $2;
-    vector<unique_ptr<BaseAST>> *vec = $3;
-    ast->block_items.push_back(unique_ptr<BaseAST>(block_item));
+    ASTList *vec = $3;
+    ast->block_items.push_back(block_item);
     for (auto& ptr : *vec) {
-      ast->block_items.push_back(move(ptr));
+      ast->block_items.push_back(ptr);
     }
     $$ = ast;
   }
   | '{' '}'{
     // 空块
-    auto ast = new BlockAST();
-    ast->block_items = vector<unique_ptr<BaseAST>>();
+    auto ast = ast_arena.make<BlockAST>();
     $$ = ast;
   }
   ;
 
 ExtendBlockItem
   : {
-    // 从 ε 规约到 ExtendBlockItem, 则创建一个空的 vector<unique_ptr<BaseAST>>
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    // 从 ε 规约到 ExtendBlockItem, 则创建一个空的 ASTList
+    ASTList *vec = ast_arena.make<ASTList>();
     $$ = vec;
   }
   | ExtendBlockItem BlockItem {
     // 从 ExtendBlockItem 规约到 BlockItem, 则把 BlockItem 的解析返回值移动到 ExtendBlockItem 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($2));
+    ASTList *vec = $1;
+    vec->push_back($2);
     $$ = vec;
   }
   ;
@@ -248,12 +247,12 @@ Decl
 ConstDecl
   : CONST INT ConstDef ExtendConstDef ';' {
     // 常量声明，要处理一行有多个常量定义的情况，如 int a = 1, b = 2;
-    auto ast = new ConstDeclAST();
+    auto ast = ast_arena.make<ConstDeclAST>();
     auto const_def = $3;
-    vector<unique_ptr<BaseAST>> *vec = $4;
-    ast->const_defs.push_back(unique_ptr<BaseAST>(const_def));
+    ASTList *vec = $4;
+    ast->const_defs.push_back(const_def);
     for (auto& ptr : *vec) {
-      ast->const_defs.push_back(move(ptr));
+      ast->const_defs.push_back(ptr);
     }
     $$ = ast;
   }
@@ -261,14 +260,14 @@ ConstDecl
 
 ExtendConstDef
   : {
-    // 从 ε 规约到 ExtendConstDef, 则创建一个空的 vector<unique_ptr<BaseAST>>
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    // 从 ε 规约到 ExtendConstDef, 则创建一个空的 ASTList
+    ASTList *vec = ast_arena.make<ASTList>();
     $$ = vec;
   }
   | ExtendConstDef ',' ConstDef {
     // 从 ExtendConstDef 规约到 ConstDef, 则把 ConstDef 的解析返回值移动到 ExtendConstDef 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($3));
+    ASTList *vec = $1;
+    vec->push_back($3);
     $$ = vec;
   }
   ;
@@ -276,25 +275,25 @@ ExtendConstDef
 ConstDef
   : IDENT ExtendArrayIndex '=' ConstInitVal {
     // 常量定义，如 int a[10] = {1, 2, 3}; 或 int a = 1;
-    auto ast = new ConstDefAST();
-    ast->ident = *unique_ptr<string>($1);
+    auto ast = ast_arena.make<ConstDefAST>();
+    ast->ident = $1;
     // 指针肯定有，但是 vector 是否为空需要后续前端处理时判断
-    vector<unique_ptr<BaseAST>> *vec = $2;
+    ASTList *vec = $2;
     ast->array_index = vec;
-    ast->value = unique_ptr<BaseAST>($4);
+    ast->value = $4;
     $$ = ast;
   }
 
 ExtendConstInitVal
   : {
-    // 从 ε 规约到 ExtendConstInitVal, 则创建一个空的 vector<unique_ptr<BaseAST>>
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    // 从 ε 规约到 ExtendConstInitVal, 则创建一个空的 ASTList
+    ASTList *vec = ast_arena.make<ASTList>();
     $$ = vec;
   }
   | ExtendConstInitVal ',' ConstInitVal {
     // 从 ExtendConstInitVal 规约到 ConstInitVal, 则把 ConstInitVal 的解析返回值移动到 ExtendConstInitVal 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($3));
+    ASTList *vec = $1;
+    vec->push_back($3);
     $$ = vec;
   }
   ;
@@ -302,26 +301,26 @@ ExtendConstInitVal
 ConstInitVal
   : ConstExp {
     // 常量初始值，如 const int a = 1 的 1
-    auto ast = new ConstInitValAST();
-    ast->const_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<ConstInitValAST>();
+    ast->const_exp = $1;
     $$ = ast;
   }
   | '{' '}' {
     // 常量数组空初始值，如 const int arr = {}; 的 {}
-    auto ast = new ConstInitValAST();
+    auto ast = ast_arena.make<ConstInitValAST>();
     ast->init_values.emplace();
     $$ = ast;
   }
   | '{' ConstInitVal ExtendConstInitVal '}' {
     // 常量数组初始值，如 const int arr = {1, 2, 3}; 的 {1, 2, 3}
     // 注意这个可能会发生嵌套初始化列表定义，如 const int arr = {{1, 2}, {3, 4}};
-    auto ast = new ConstInitValAST();
+    auto ast = ast_arena.make<ConstInitValAST>();
     auto const_init_val = $2;
-    vector<unique_ptr<BaseAST>> *vec = $3;
+    ASTList *vec = $3;
     ast->init_values.emplace();
-    ast->init_values->push_back(unique_ptr<BaseAST>(const_init_val));
+    ast->init_values->push_back(const_init_val);
     for (auto& ptr : *vec) {
-      ast->init_values->push_back(move(ptr));
+      ast->init_values->push_back(ptr);
     }
     $$ = ast;
   }
@@ -329,14 +328,14 @@ ConstInitVal
 
 ExtendArrayIndex
   : {
-    // 从 ε 规约到 ExtendArrayIndex, 则创建一个空的 vector<unique_ptr<BaseAST>>
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    // 从 ε 规约到 ExtendArrayIndex, 则创建一个空的 ASTList
+    ASTList *vec = ast_arena.make<ASTList>();
     $$ = vec;
   }
   | ExtendArrayIndex '[' ConstExp ']' {
     // 从 ExtendArrayIndex 规约到 ConstExp, 则把 ConstExp 的解析返回值移动到 ExtendArrayIndex 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($3));
+    ASTList *vec = $1;
+    vec->push_back($3);
     $$ = vec;
   }
   ;
@@ -344,8 +343,8 @@ ExtendArrayIndex
 ConstExp
   : Exp {
     // 常量表达式，如 const int a = 1 + 2; 的 1 + 2
-    auto ast = new ConstExpAST();
-    ast->exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<ConstExpAST>();
+    ast->exp = $1;
     $$ = ast;
   }
   ;
@@ -353,12 +352,12 @@ ConstExp
 VarDecl
   : INT VarDef ExtendVarDef ';' {
     // 变量声明，要处理一行有多个变量定义的情况，如 int a, b;
-    auto ast = new VarDeclAST();
+    auto ast = ast_arena.make<VarDeclAST>();
     auto var_def = $2;
-    vector<unique_ptr<BaseAST>> *vec = $3;
-    ast->var_defs.push_back(unique_ptr<BaseAST>(var_def));
+    ASTList *vec = $3;
+    ast->var_defs.push_back(var_def);
     for (auto& ptr : *vec) {
-      ast->var_defs.push_back(move(ptr));
+      ast->var_defs.push_back(ptr);
     }
     $$ = ast;
   }
@@ -366,14 +365,14 @@ VarDecl
 
 ExtendVarDef
   : {
-    // 从 ε 规约到 ExtendVarDef, 则创建一个空的 vector<unique_ptr<BaseAST>>
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    // 从 ε 规约到 ExtendVarDef, 则创建一个空的 ASTList
+    ASTList *vec = ast_arena.make<ASTList>();
     $$ = vec;
   }
   | ExtendVarDef ',' VarDef {
     // 从 ExtendVarDef 规约到 VarDef, 则把 VarDef 的解析返回值移动到 ExtendVarDef 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($3));
+    ASTList *vec = $1;
+    vec->push_back($3);
     $$ = vec;
   }
   ;
@@ -381,33 +380,33 @@ ExtendVarDef
 VarDef
   : IDENT ExtendArrayIndex {
     // 变量定义，如 int a[10]; 或 int a;
-    auto ast = new VarDefAST();
-    ast->ident = *unique_ptr<string>($1);
-    vector<unique_ptr<BaseAST>> *vec = $2;
+    auto ast = ast_arena.make<VarDefAST>();
+    ast->ident = $1;
+    ASTList *vec = $2;
     ast->array_index = vec;
     $$ = ast;
   }
   | IDENT ExtendArrayIndex '=' InitVal {
     // 带初始值的变量定义，如 int a[10] = {1, 2, 3}; 或 int a = 1;
-    auto ast = new VarDefAST();
-    ast->ident = *unique_ptr<string>($1);
-    vector<unique_ptr<BaseAST>> *vec = $2;
+    auto ast = ast_arena.make<VarDefAST>();
+    ast->ident = $1;
+    ASTList *vec = $2;
     ast->array_index = vec;
-    ast->value = unique_ptr<BaseAST>($4);
+    ast->value = $4;
     $$ = ast;
   }
   ;
 
 ExtendInitVal
   : {
-    // 从 ε 规约到 ExtendInitVal, 则创建一个空的 vector<unique_ptr<BaseAST>>
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    // 从 ε 规约到 ExtendInitVal, 则创建一个空的 ASTList
+    ASTList *vec = ast_arena.make<ASTList>();
     $$ = vec;
   }
   | ExtendInitVal ',' InitVal {
     // 从 ExtendInitVal 规约到 InitVal, 则把 InitVal 的解析返回值移动到 ExtendInitVal 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($3));
+    ASTList *vec = $1;
+    vec->push_back($3);
     $$ = vec;
   }
   ;
@@ -415,26 +414,26 @@ ExtendInitVal
 InitVal
   : Exp {
     // 初始值，如 int a = 1; 的 1
-    auto ast = new InitValAST();
-    ast->exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<InitValAST>();
+    ast->exp = $1;
     $$ = ast;
   }
   | '{' '}' {
     // 空初始值，如 int arr = {}; 的 {}
-    auto ast = new InitValAST();
+    auto ast = ast_arena.make<InitValAST>();
     ast->init_values.emplace();
     $$ = ast;
   }
   | '{' InitVal ExtendInitVal '}' {
     // 数组初始值，如 int arr = {1, 2, 3}; 的 {1, 2, 3}
     // 注意这个可能会发生嵌套初始化列表定义，如 int arr = {{1, 2}, {3, 4}};
-    auto ast = new InitValAST();
+    auto ast = ast_arena.make<InitValAST>();
     auto init_val = $2;
-    vector<unique_ptr<BaseAST>> *vec = $3;
+    ASTList *vec = $3;
     ast->init_values.emplace();
-    ast->init_values->push_back(unique_ptr<BaseAST>(init_val));
+    ast->init_values->push_back(init_val);
     for (auto& ptr : *vec) {
-      ast->init_values->push_back(move(ptr));
+      ast->init_values->push_back(ptr);
     }
     $$ = ast;
   }
@@ -455,45 +454,45 @@ MatchedStmt
   : IF '(' Exp ')' MatchedStmt ELSE MatchedStmt {
     // if-else 语句，保证 else 永远匹配到最近的 if
     // 注意，这可能会嵌套定义。
-    auto ast = new StmtIfAST();
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->then_stmt = unique_ptr<BaseAST>($5);
-    ast->else_stmt = unique_ptr<BaseAST>($7);
+    auto ast = ast_arena.make<StmtIfAST>();
+    ast->exp = $3;
+    ast->then_stmt = $5;
+    ast->else_stmt = $7;
     $$ = ast;
   }
   | WHILE '(' Exp ')' Stmt {
     // while 语句
-    auto ast = new StmtWhileAST();
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->stmt = unique_ptr<BaseAST>($5);
+    auto ast = ast_arena.make<StmtWhileAST>();
+    ast->exp = $3;
+    ast->stmt = $5;
     $$ = ast;
   }
   | BREAK ';' {
     // break 语句
-    auto ast = new StmtBreakAST();
+    auto ast = ast_arena.make<StmtBreakAST>();
     $$ = ast;
   }
   | CONTINUE ';' {
     // continue 语句
-    auto ast = new StmtContinueAST();
+    auto ast = ast_arena.make<StmtContinueAST>();
     $$ = ast;
   }
   | LVal '=' Exp ';' {
     // 赋值语句，如 a = 1;
-    auto ast = new StmtAssignAST();
-    ast->l_val = unique_ptr<BaseAST>($1);
-    ast->exp = unique_ptr<BaseAST>($3);
+    auto ast = ast_arena.make<StmtAssignAST>();
+    ast->l_val = $1;
+    ast->exp = $3;
     $$ = ast;
   }
   | Exp ';'{
     // 表达式语句，如 a + 1;
-    auto ast = new StmtExpAST();
-    ast->exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<StmtExpAST>();
+    ast->exp = $1;
     $$ = ast;
   }
   | ';'{
     // 空语句，如 ;
-    auto ast = new StmtExpAST();
+    auto ast = ast_arena.make<StmtExpAST>();
     $$ = ast;
   }
   | Block {
@@ -502,30 +501,30 @@ MatchedStmt
   }
   | RETURN Exp ';' {
     // 带返回值的 return 语句，如 return 1;
-    auto ast = new StmtReturnAST();
-    ast->exp = unique_ptr<BaseAST>($2);
+    auto ast = ast_arena.make<StmtReturnAST>();
+    ast->exp = $2;
     $$ = ast;
   }
   | RETURN ';' {
     // 不带返回值的 return 语句，如 return;
-    auto ast = new StmtReturnAST();
+    auto ast = ast_arena.make<StmtReturnAST>();
     $$ = ast;
   }
   ;
 
 OpenStmt
   : IF '(' Exp ')' Stmt {
-    auto ast = new StmtIfAST();
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->then_stmt = unique_ptr<BaseAST>($5);
+    auto ast = ast_arena.make<StmtIfAST>();
+    ast->exp = $3;
+    ast->then_stmt = $5;
     $$ = ast;
   }
   | IF '(' Exp ')' MatchedStmt ELSE OpenStmt {
     // 保证 else 永远匹配到最近的 if
-    auto ast = new StmtIfAST();
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->then_stmt = unique_ptr<BaseAST>($5);
-    ast->else_stmt = unique_ptr<BaseAST>($7);
+    auto ast = ast_arena.make<StmtIfAST>();
+    ast->exp = $3;
+    ast->then_stmt = $5;
+    ast->else_stmt = $7;
     $$ = ast;
   }
   ;
@@ -533,9 +532,9 @@ OpenStmt
 LVal
   : IDENT ExtendArrayIndex {
     // 左值，如 a[10] 或 a
-    auto ast = new LValAST();
-    ast->ident = *unique_ptr<string>($1);
-    vector<unique_ptr<BaseAST>> *vec = $2;
+    auto ast = ast_arena.make<LValAST>();
+    ast->ident = $1;
+    ASTList *vec = $2;
     ast->array_index = vec;
     $$ = ast;
   }
@@ -544,8 +543,8 @@ LVal
 Exp
   : LOrExp {
     // 或表达式，如 a || b
-    auto ast = new ExpAST();
-    ast->l_or_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<ExpAST>();
+    ast->l_or_exp = $1;
     $$ = ast;
   }
   ;
@@ -553,16 +552,16 @@ Exp
 LOrExp
   : LAndExp {
     // 与表达式，如 a && b
-    auto ast = new LOrExpAST();
-    ast->l_and_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<LOrExpAST>();
+    ast->l_and_exp = $1;
     $$ = ast;
   }
   | LOrExp OrOp LAndExp {
     // 实际上是做了一个优先级处理，AndOp 的优先级高于 OrOp，因为 AndOp 更早规约出来
-    auto ast = new LExpWithOpAST();
+    auto ast = ast_arena.make<LExpWithOpAST>();
     ast->logical_op = LExpWithOpAST::LogicalOp::LOGICAL_OR;
-    ast->left = unique_ptr<BaseAST>($1);
-    ast->right = unique_ptr<BaseAST>($3);
+    ast->left = $1;
+    ast->right = $3;
     $$ = ast;
   }
   ;
@@ -570,16 +569,16 @@ LOrExp
 LAndExp
   : EqExp {
     // 等于表达式，如 a == b
-    auto ast = new LAndExpAST();
-    ast->eq_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<LAndExpAST>();
+    ast->eq_exp = $1;
     $$ = ast;
   }
   | LAndExp AndOp EqExp {
     // 实际上是做了一个优先级处理，EqExp 的优先级高于 AndOp，因为 EqExp 更早规约出来
-    auto ast = new LExpWithOpAST();
+    auto ast = ast_arena.make<LExpWithOpAST>();
     ast->logical_op = LExpWithOpAST::LogicalOp::LOGICAL_AND;
-    ast->left = unique_ptr<BaseAST>($1);
-    ast->right = unique_ptr<BaseAST>($3);
+    ast->left = $1;
+    ast->right = $3;
     $$ = ast;
   }
   ;
@@ -587,17 +586,16 @@ LAndExp
 EqExp
   : RelExp {
     // 关系表达式，如 a == b
-    auto ast = new EqExpAST();
-    ast->rel_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<EqExpAST>();
+    ast->rel_exp = $1;
     $$ = ast;
   }
   | EqExp EqOp RelExp {
     // 实际上是做了一个优先级处理，RelExp 的优先级高于 EqOp，因为 RelExp 更早规约出来
-    auto ast = new EqExpWithOpAST();
-    auto eq_op = *unique_ptr<string>($2);
-    ast->eq_op = ast->convert(eq_op);
-    ast->left = unique_ptr<BaseAST>($1);
-    ast->right = unique_ptr<BaseAST>($3);
+    auto ast = ast_arena.make<EqExpWithOpAST>();
+    ast->eq_op = ast->convert($2);
+    ast->left = $1;
+    ast->right = $3;
     $$ = ast;
   }
   ;
@@ -605,17 +603,16 @@ EqExp
 RelExp
   : AddExp {
     // 加法表达式，如 a + b
-    auto ast = new RelExpAST();
-    ast->add_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<RelExpAST>();
+    ast->add_exp = $1;
     $$ = ast;
   }
   | RelExp RelOp AddExp {
     // 实际上是做了一个优先级处理，AddExp 的优先级高于 RelOp，因为 AddExp 更早规约出来
-    auto ast = new RelExpWithOpAST();
-    auto rel_op = *unique_ptr<string>($2);
-    ast->rel_op = ast->convert(rel_op);
-    ast->left = unique_ptr<BaseAST>($1);
-    ast->right = unique_ptr<BaseAST>($3);
+    auto ast = ast_arena.make<RelExpWithOpAST>();
+    ast->rel_op = ast->convert($2);
+    ast->left = $1;
+    ast->right = $3;
     $$ = ast;
   }
   ;
@@ -623,17 +620,16 @@ RelExp
 AddExp
   : MulExp {
     // 乘法表达式，如 a * b
-    auto ast = new AddExpAST();
-    ast->mul_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<AddExpAST>();
+    ast->mul_exp = $1;
     $$ = ast;
   }
   | AddExp AddOp MulExp {
     // 实际上是做了一个优先级处理，MulExp 的优先级高于 AddOp，因为 MulExp 更早规约出来
-    auto ast = new AddExpWithOpAST();
-    auto add_op = *unique_ptr<string>($2);
-    ast->add_op = ast->convert(add_op);
-    ast->left = unique_ptr<BaseAST>($1);
-    ast->right = unique_ptr<BaseAST>($3);
+    auto ast = ast_arena.make<AddExpWithOpAST>();
+    ast->add_op = ast->convert($2);
+    ast->left = $1;
+    ast->right = $3;
     $$ = ast;
   }
   ;
@@ -641,17 +637,16 @@ AddExp
 MulExp
   : UnaryExp {
     // 单目运算符表达式，如 !a 或 -a
-    auto ast = new MulExpAST();
-    ast->unary_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<MulExpAST>();
+    ast->unary_exp = $1;
     $$ = ast;
   }
   | MulExp MulOp UnaryExp {
     // 实际上是做了一个优先级处理，UnaryExp 的优先级高于 MulOp，因为 UnaryExp 更早规约出来
-    auto ast = new MulExpWithOpAST();
-    auto mul_op = *unique_ptr<string>($2);
-    ast->mul_op = ast->convert(mul_op);
-    ast->left = unique_ptr<BaseAST>($1);
-    ast->right = unique_ptr<BaseAST>($3);
+    auto ast = ast_arena.make<MulExpWithOpAST>();
+    ast->mul_op = ast->convert($2);
+    ast->left = $1;
+    ast->right = $3;
     $$ = ast;
   }
   ;
@@ -659,31 +654,29 @@ MulExp
 UnaryExp
   : PrimaryExp {
     // 括号运算符表达式，如 (a)
-    auto ast = new UnaryExpAST();
-    ast->primary_exp = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<UnaryExpAST>();
+    ast->primary_exp = $1;
     $$ = ast;
   }
   | AddOp UnaryExp {
     // 实际上是做了一个优先级处理，（）的优先级最高
-    auto ast = new UnaryExpWithOpAST();
-    auto add_op = *unique_ptr<string>($1);
-    ast->unary_op = ast->convert(add_op);
-    ast->unary_exp = unique_ptr<BaseAST>($2);
+    auto ast = ast_arena.make<UnaryExpWithOpAST>();
+    ast->unary_op = ast->convert($1);
+    ast->unary_exp = $2;
     $$ = ast;
   }
   | NotOp UnaryExp {
     // 实际上是做了一个优先级处理，（）的优先级最高
-    auto ast = new UnaryExpWithOpAST();
-    auto not_op = *unique_ptr<string>($1);
-    ast->unary_op = ast->convert(not_op);
-    ast->unary_exp = unique_ptr<BaseAST>($2);
+    auto ast = ast_arena.make<UnaryExpWithOpAST>();
+    ast->unary_op = ast->convert($1);
+    ast->unary_exp = $2;
     $$ = ast;
   }
   | IDENT '(' ExtendFuncRParams ')' {
     // 函数调用表达式，如 f(1, 2, 3)
-    auto ast = new UnaryExpWithFuncCallAST();
-    ast->ident = *unique_ptr<string>($1);
-    vector<unique_ptr<BaseAST>> *vec = $3;
+    auto ast = ast_arena.make<UnaryExpWithFuncCallAST>();
+    ast->ident = $1;
+    ASTList *vec = $3;
     ast->func_r_params = vec;
     $$ = ast;
   }
@@ -691,20 +684,20 @@ UnaryExp
 
 ExtendFuncRParams
   : {
-    // 0 个参数的情况，从 ε 规约到 ExtendFuncRParams, 则创建一个空的 vector<unique_ptr<BaseAST>>
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
+    // 0 个参数的情况，从 ε 规约到 ExtendFuncRParams, 则创建一个空的 ASTList
+    ASTList *vec = ast_arena.make<ASTList>();
     $$ = vec;
   }
   | Exp {
     // 1 个参数的情况，从 Exp 规约到 ExtendFuncRParams, 则把 Exp 的解析返回值移动到 ExtendFuncRParams 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = new vector<unique_ptr<BaseAST>>;
-    vec->push_back(unique_ptr<BaseAST>($1));
+    ASTList *vec = ast_arena.make<ASTList>();
+    vec->push_back($1);
     $$ = vec;
   }
   | ExtendFuncRParams ',' Exp {
     // 多个参数的情况，从 ExtendFuncRParams 规约到 Exp, 则把 Exp 的解析返回值移动到 ExtendFuncRParams 的 vector 中
-    vector<unique_ptr<BaseAST>> *vec = $1;
-    vec->push_back(unique_ptr<BaseAST>($3));
+    ASTList *vec = $1;
+    vec->push_back($3);
     $$ = vec;
   }
   ;
@@ -712,20 +705,20 @@ ExtendFuncRParams
 PrimaryExp
   : '(' Exp ')' {
     // 括号表达式，如 (a)
-    auto ast = new PrimaryExpAST();
-    ast->exp = unique_ptr<BaseAST>($2);
+    auto ast = ast_arena.make<PrimaryExpAST>();
+    ast->exp = $2;
     $$ = ast;
   }
   | Number {
     // 数字表达式，如 1
-    auto ast = new PrimaryExpWithNumberAST();
+    auto ast = ast_arena.make<PrimaryExpWithNumberAST>();
     ast->number = $1;
     $$ = ast;
   }
   | LVal {
     // 变量表达式，如 a
-    auto ast = new PrimaryExpWithLValAST();
-    ast->l_val = unique_ptr<BaseAST>($1);
+    auto ast = ast_arena.make<PrimaryExpWithLValAST>();
+    ast->l_val = $1;
     $$ = ast;
   }
   ;
@@ -741,6 +734,6 @@ Number
 
 // 定义错误处理函数, 其中第二个参数是错误信息
 // parser 如果发生错误 (例如输入的程序出现了语法错误), 就会调用这个函数
-void yyerror(unique_ptr<BaseAST> &ast, const char *s) {
+void yyerror(BaseAST *&ast, const char *s) {
   cerr << "error: " << s << endl;
 }
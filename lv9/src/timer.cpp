@@ -0,0 +1,149 @@
+#include "include/timer.hpp"
+#include "include/writer.hpp"
+
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sys/resource.h>
+
+// 编译阶段计时器
+PassTimer pass_timer;
+
+/**
+ * @brief 获取进程已使用的 CPU 时间
+ * @return 微秒数
+ */
+static double cpu_time() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief 获取进程的峰值常驻内存
+ * @return KB 数
+ */
+static long peak_rss() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * @brief 获取相对编译开始的时间
+ * @return 微秒数
+ */
+double PassTimer::now() const {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - origin).count();
+}
+
+/**
+ * @brief 判断是否需要记录计时区间
+ * @return 是否开启了 -time-passes 或 -trace
+ */
+bool PassTimer::enabled() const {
+    return report_enabled || !trace_path.empty();
+}
+
+/**
+ * @brief 开启 -time-passes，编译结束时输出各阶段耗时
+ */
+void PassTimer::enable_report() {
+    report_enabled = true;
+}
+
+/**
+ * @brief 开启 -trace，编译结束时导出 Chrome trace 文件
+ * @param[in] path 导出文件路径
+ */
+void PassTimer::enable_trace(const string& path) {
+    trace_path = path;
+}
+
+/**
+ * @brief 开始一个计时区间，可以嵌套
+ * @param[in] name 区间名，如阶段名或函数名
+ * @param[in] category 区间类别，如 phase、function
+ */
+void PassTimer::begin(const string& name, const char* category) {
+    stack.push_back(records.size());
+    records.push_back({ name, category, (int)stack.size() - 1, now(), 0, cpu_time(), 0 });
+}
+
+/**
+ * @brief 结束最近开始的计时区间
+ */
+void PassTimer::end() {
+    assert(!stack.empty());
+    auto& record = records[stack.back()];
+    stack.pop_back();
+    record.wall = now() - record.start;
+    record.cpu = cpu_time() - record.cpu;
+    record.peak_rss = peak_rss();
+}
+
+/**
+ * @brief 向标准错误输出各阶段的耗时与峰值内存，嵌套的区间缩进显示
+ */
+void PassTimer::report() const {
+    if (!report_enabled) {
+        return;
+    }
+    cerr << "===== Pass execution timing report =====\n";
+    cerr << setw(12) << "Wall (ms)" << setw(12) << "CPU (ms)" << setw(16) << "Peak RSS (KB)" << "  Name\n";
+    cerr << fixed << setprecision(3);
+    for (auto& record : records) {
+        cerr << setw(12) << record.wall / 1e3 << setw(12) << record.cpu / 1e3 << setw(16) << record.peak_rss << "  ";
+        cerr << string(record.depth * 2, ' ') << record.name << '\n';
+    }
+    cerr << defaultfloat;
+}
+
+/**
+ * @brief 导出 Chrome trace-event 格式的 JSON 文件，可在 chrome://tracing 或 Perfetto 中打开
+ */
+void PassTimer::write_trace() const {
+    if (trace_path.empty()) {
+        return;
+    }
+    OutputWriter ofs;
+    ofs.open(trace_path.c_str());
+    ofs << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < records.size(); i++) {
+        auto& record = records[i];
+        ofs << "{\"name\":\"";
+        // 转义名字中的引号与反斜杠
+        for (char c : record.name) {
+            if (c == '"' || c == '\\') {
+                ofs << '\\';
+            }
+            ofs << c;
+        }
+        ofs << "\",\"cat\":\"" << record.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+        ofs << ",\"ts\":" << to_string(record.start) << ",\"dur\":" << to_string(record.wall);
+        ofs << ",\"args\":{\"cpu_us\":" << to_string(record.cpu) << ",\"peak_rss_kb\":" << to_string(record.peak_rss) << "}}";
+        ofs << (i + 1 < records.size() ? ",\n" : "\n");
+    }
+    ofs << "],\"displayTimeUnit\":\"ms\"}\n";
+    ofs.close();
+}
+
+/**
+ * @brief 开始计时区间，未开启计时时不做任何事
+ * @param[in] name 区间名
+ * @param[in] category 区间类别
+ */
+TimeRegion::TimeRegion(const char* name, const char* category) : active(pass_timer.enabled()) {
+    if (active) {
+        pass_timer.begin(name, category);
+    }
+}
+
+/**
+ * @brief 结束计时区间
+ */
+TimeRegion::~TimeRegion() {
+    if (active) {
+        pass_timer.end();
+    }
+}
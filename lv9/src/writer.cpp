@@ -0,0 +1,163 @@
+#include "include/writer.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief 析构时写出缓冲区中剩余的内容并关闭文件
+ */
+OutputWriter::~OutputWriter() {
+    if (fd != -1) {
+        flush();
+        ::close(fd);
+    }
+}
+
+/**
+ * @brief 打开输出文件，文件已存在则清空
+ * @param[in] path 文件路径
+ */
+void OutputWriter::open(const char* path) {
+    if (fd != -1) {
+        close();
+    }
+    fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        throw runtime_error(string("Cannot open output file ") + path + ": " + strerror(errno));
+    }
+    if (!buffer) {
+        buffer = make_unique<char[]>(BUFFER_SIZE);
+    }
+    size = 0;
+}
+
+/**
+ * @brief 将缓冲区中的内容写入文件
+ */
+void OutputWriter::flush() {
+    const char* data = buffer.get();
+    size_t len = size;
+    while (len > 0) {
+        ssize_t written = ::write(fd, data, len);
+        write_count++;
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw runtime_error(string("Cannot write output file: ") + strerror(errno));
+        }
+        data += written;
+        len -= written;
+    }
+    size = 0;
+}
+
+/**
+ * @brief 写出缓冲区中剩余的内容并关闭文件
+ */
+void OutputWriter::close() {
+    if (fd == -1) {
+        return;
+    }
+    flush();
+    ::close(fd);
+    fd = -1;
+}
+
+/**
+ * @brief 获取累计输出的字节数
+ * @return 字节数
+ */
+size_t OutputWriter::bytes() const {
+    return total_bytes;
+}
+
+/**
+ * @brief 获取累计调用 write 的次数
+ * @return 次数
+ */
+int OutputWriter::writes() const {
+    return write_count;
+}
+
+/**
+ * @brief 追加一段内容到缓冲区，缓冲区放不下时先写出
+ * @param[in] data 内容
+ * @param[in] len 长度
+ */
+void OutputWriter::write(const char* data, size_t len) {
+    total_bytes += len;
+    while (len > 0) {
+        if (size == BUFFER_SIZE) {
+            flush();
+        }
+        size_t n = min(len, BUFFER_SIZE - size);
+        memcpy(buffer.get() + size, data, n);
+        size += n;
+        data += n;
+        len -= n;
+    }
+}
+
+/**
+ * @brief 输出字符串
+ * @param[in] str 字符串
+ */
+OutputWriter& OutputWriter::operator<<(string_view str) {
+    write(str.data(), str.size());
+    return *this;
+}
+
+/**
+ * @brief 输出以 '\0' 结尾的字符串
+ * @param[in] str 字符串
+ */
+OutputWriter& OutputWriter::operator<<(const char* str) {
+    write(str, strlen(str));
+    return *this;
+}
+
+/**
+ * @brief 输出字符串
+ * @param[in] str 字符串
+ */
+OutputWriter& OutputWriter::operator<<(const string& str) {
+    write(str.data(), str.size());
+    return *this;
+}
+
+/**
+ * @brief 输出单个字符
+ * @param[in] c 字符
+ */
+OutputWriter& OutputWriter::operator<<(char c) {
+    if (size == BUFFER_SIZE) {
+        flush();
+    }
+    buffer[size++] = c;
+    total_bytes++;
+    return *this;
+}
+
+/**
+ * @brief 输出十进制整数，从低位到高位写入临时数组后整体追加
+ * @param[in] value 整数
+ */
+OutputWriter& OutputWriter::operator<<(int value) {
+    char digits[12];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+    // 用无符号数取绝对值，避免 INT_MIN 取负溢出
+    unsigned int abs = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        *--p = '0' + abs % 10;
+        abs /= 10;
+    } while (abs);
+    if (value < 0) {
+        *--p = '-';
+    }
+    write(p, end - p);
+    return *this;
+}
@@ -0,0 +1,30 @@
+#!/bin/bash
+# 输出写入的基准测试：对生成的大量语句的程序分别运行 -koopa 与 -riscv，
+# 报告墙钟时间、-stats 统计的输出字节数与 write 次数，装有 strace 时再统计实际的 write 系统调用
+# 用法：tests/large/bench.sh [语句条数]，COMPILER 默认为 build/compiler
+
+cd "$(dirname "$0")/../.."
+COMPILER=${COMPILER:-build/compiler}
+N=${1:-100000}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+python3 tests/large/gen_stmts.py "$N" > "$WORK/stmts.sy" || exit 1
+echo "输入：$N 条语句，$(stat -c %s "$WORK/stmts.sy") bytes"
+
+TIMEFORMAT='  wall: %R s, user: %U s, sys: %S s'
+for mode in -koopa -riscv "-perf -O2"; do
+    echo "[$mode]"
+    # 模式中 -O2 等选项放在输出文件之后，这里有意不加引号
+    time $COMPILER ${mode%% *} "$WORK/stmts.sy" -o "$WORK/out" ${mode#${mode%% *}} -stats 2> "$WORK/stats"
+    if [ $? -ne 0 ]; then
+        echo "  编译失败"
+        exit 1
+    fi
+    grep -E "^(koopa|riscv):" "$WORK/stats" | sed 's/^/  /'
+    if command -v strace > /dev/null; then
+        strace -f -c -e trace=write -o "$WORK/strace" \
+            $COMPILER ${mode%% *} "$WORK/stmts.sy" -o "$WORK/out" ${mode#${mode%% *}} 2> /dev/null
+        echo "  strace: $(awk '$NF == "write" { print $4 }' "$WORK/strace") write 系统调用"
+    fi
+done
@@ -0,0 +1,55 @@
+#!/bin/bash
+# 大输出回归测试：生成超过 64 MiB 的 Koopa IR，检查 -koopa 与 -riscv 的输出是否完整
+# 用法：tests/large/check_output.sh [元素个数]，COMPILER 默认为 build/compiler
+
+cd "$(dirname "$0")/../.."
+COMPILER=${COMPILER:-build/compiler}
+N=${1:-1600000}
+SENTINEL=987654321
+LIMIT=$((64 * 1024 * 1024))
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+python3 tests/large/gen_array.py "$N" > "$WORK/big.sy" || exit 1
+fail=0
+
+# 检查输出文件 $1：最后一行应为 $2，哨兵值应出现，匹配 $3 的行数应等于元素个数，$4 为 big 时还要求超过 64 MiB
+check() {
+    local file=$1 last=$2 pattern=$3 size
+    size=$(stat -c %s "$file")
+    echo "$file: $size bytes"
+    if [ "$4" = "big" ] && [ "$size" -le "$LIMIT" ]; then
+        echo "  输出没有超过 64 MiB，测试不到大输出的情况"
+        fail=1
+    fi
+    if [ "$(tail -n 1 "$file")" != "$last" ]; then
+        echo "  输出不完整，最后一行为：$(tail -n 1 "$file")"
+        fail=1
+    fi
+    if ! grep -q "$SENTINEL" "$file"; then
+        echo "  没有找到最后一个元素 $SENTINEL"
+        fail=1
+    fi
+    local count
+    count=$(grep -c "$pattern" "$file")
+    if [ "$count" -ne "$N" ]; then
+        echo "  有 $count 条数组元素的存储，应为 $N"
+        fail=1
+    fi
+}
+
+if ! $COMPILER -koopa "$WORK/big.sy" -o "$WORK/big.koopa" -stats; then
+    echo "-koopa: 编译失败"
+    exit 1
+fi
+check "$WORK/big.koopa" "}" $'^\tstore ' big
+
+if ! $COMPILER -riscv "$WORK/big.sy" -o "$WORK/big.S" -stats; then
+    echo "-riscv: 编译失败"
+    exit 1
+fi
+# 每个元素恰好一条 sw，常量 0 直接存 x0
+check "$WORK/big.S" $'\tret' $'^\tsw '
+
+[ $fail -eq 0 ] && echo "通过"
+exit $fail
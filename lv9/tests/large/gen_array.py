@@ -0,0 +1,16 @@
+#!/usr/bin/env python3
+# 生成一个局部数组初始化列表很长的程序，最后一个元素为哨兵值 987654321
+# 用法：gen_array.py [元素个数] > big.sy，默认 1600000 个，-koopa 输出超过 64 MiB
+import sys
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 1600000
+values = [str(i % 1000) for i in range(n - 1)] + ['987654321']
+out = sys.stdout
+out.write('int main() {\n')
+out.write('  int a[%d] = {' % n)
+for i in range(0, n, 20):
+    out.write(', '.join(values[i:i + 20]))
+    out.write(',\n' if i + 20 < n else '')
+out.write('};\n')
+out.write('  return a[%d] %% 256;\n' % (n - 1))
+out.write('}\n')
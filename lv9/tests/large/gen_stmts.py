@@ -0,0 +1,28 @@
+#!/usr/bin/env python3
+# 生成有大量语句的程序，用于测量输出的写入次数与耗时
+# 用法：gen_stmts.py [语句条数] > stmts.sy，默认 100000 条，每个函数 1000 条
+import sys
+
+n = int(sys.argv[1]) if len(sys.argv) > 1 else 100000
+per_func = 1000
+funcs = (n + per_func - 1) // per_func
+out = sys.stdout
+out.write('int g;\n')
+for f in range(funcs):
+    out.write('int f%d(int x, int y) {\n' % f)
+    out.write('  int a = x; int b = y; int c = x + y;\n')
+    for i in range(min(per_func, n - f * per_func)):
+        k = i % 4
+        if k == 0:
+            out.write('  a = a * %d + b - c;\n' % (i % 13 + 2))
+        elif k == 1:
+            out.write('  b = (b + a) %% %d;\n' % (i % 97 + 3))
+        elif k == 2:
+            out.write('  if (a > b) c = c + a / %d; else c = c - b;\n' % (i % 7 + 2))
+        else:
+            out.write('  g = g + (a + b + c) %% %d;\n' % (i % 31 + 5))
+    out.write('  return a + b + c;\n}\n')
+out.write('int main() {\n  int s = 0;\n')
+for f in range(funcs):
+    out.write('  s = s + f%d(%d, %d);\n' % (f, f, f + 1))
+out.write('  putint(s); putch(10);\n  return g % 256;\n}\n')
@@ -0,0 +1,57 @@
+#!/bin/bash
+# 功能测试：把 tests/functional 下的每个 .sy 编译成汇编并运行，与同名 .out 比较
+# .out 的格式为程序的标准输出（末尾没有换行时补一个换行）加上一行返回值，.in 存在时作为标准输入
+#
+# 用法：tests/run.sh [模式 ...]，默认依次测试 "-riscv"、"-perf"、"-perf -O2"
+# - COMPILER：编译器路径，默认为 build/compiler
+# - RUNNER：以 `$RUNNER prog.S input` 的形式调用，按 .out 的格式输出运行结果；
+#   默认用 clang 汇编、ld.lld 链接 libsysy，再用 qemu-riscv32-static 运行（即实验环境中的工具链）
+
+cd "$(dirname "$0")/.."
+COMPILER=${COMPILER:-build/compiler}
+CASES=${CASES:-tests/functional}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+run_qemu() {
+    clang "$1" -c -o "$WORK/prog.o" -target riscv32-unknown-linux-elf -march=rv32im -mabi=ilp32 || return 1
+    ld.lld "$WORK/prog.o" -L"$CDE_LIBRARY_PATH/riscv32" -lsysy -o "$WORK/prog" || return 1
+    qemu-riscv32-static "$WORK/prog" < "$2" > "$WORK/stdout"
+    local code=$?
+    cat "$WORK/stdout"
+    [ -s "$WORK/stdout" ] && [ -n "$(tail -c 1 "$WORK/stdout")" ] && echo
+    echo "$code"
+}
+
+if [ $# -eq 0 ]; then
+    set -- "-riscv" "-perf" "-perf -O2"
+fi
+
+fail=0
+for mode in "$@"; do
+    pass=0; total=0
+    for sy in "$CASES"/*.sy; do
+        name=$(basename "$sy" .sy)
+        input="$CASES/$name.in"
+        [ -f "$input" ] || input=/dev/null
+        total=$((total + 1))
+        # 模式中 -O2 等选项放在输出文件之后，这里有意不加引号
+        if ! $COMPILER ${mode%% *} "$sy" -o "$WORK/$name.S" ${mode#${mode%% *}}; then
+            echo "[$mode] $name: 编译失败"
+            continue
+        fi
+        if [ -n "$RUNNER" ]; then
+            $RUNNER "$WORK/$name.S" "$input" > "$WORK/$name.res"
+        else
+            run_qemu "$WORK/$name.S" "$input" > "$WORK/$name.res"
+        fi
+        if cmp -s "$WORK/$name.res" "$CASES/$name.out"; then
+            pass=$((pass + 1))
+        else
+            echo "[$mode] $name: 输出不一致"
+        fi
+    done
+    echo "[$mode] $pass / $total"
+    [ $pass -eq $total ] || fail=1
+done
+exit $fail